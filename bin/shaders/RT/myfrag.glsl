@@ -2,6 +2,8 @@
 
 #define Threshold float(0.001)
 #define HUGE_VAL float(1e+38)
+// shape narrower than this number of pixels is replaced by its bound while marching (see 'parser::bounds')
+#define LodPixels float(1)
 
 //painting color
 layout(location = 0) out vec4 OutColor;
@@ -33,6 +35,17 @@ layout(std140, binding = 3) uniform Animation
   float Time;
 };
 
+layout(std140, binding = 4) uniform Frame
+{
+  vec4 FrameVal[64];
+};
+
+// object arguments in parameters mode, 16 KB is least GL_MAX_UNIFORM_BLOCK_SIZE
+layout(std140, binding = 7) uniform Params
+{
+  vec4 ParamVal[1024];
+};
+
 layout(location = 0) uniform samplerCube skybox;
 layout(origin_upper_left) in vec4 gl_FragCoord;
 
@@ -405,33 +418,73 @@ vec3 Scale( vec3 s, vec3 p )
   return p / s;
 }
 
+// cells are centered at multiples of period, axes with zero period aren't repeated
 vec3 Replication( vec3 c, vec3 p )
 {
-  return mod(p, c) - 0.5 * c;
+  return p - c * round(p / (c + vec3(equal(c, vec3(0)))));
 }
 
+// cells are taken from 0 to n - 1 along each axis, outer cells are nearest ones
+vec3 ReplicationLimited( vec3 c, vec3 n, vec3 p )
+{
+  return p - c * clamp(round(p / (c + vec3(equal(c, vec3(0))))), vec3(0), max(n - 1, vec3(0)));
+}
+
+// half-space behind plane through origin is reflected to its front
+vec3 Mirror( vec3 n, vec3 p )
+{
+  n = normalize(n);
+  return p - 2.0 * min(dot(p, n), 0.0) * n;
+}
+
+FUNCTION
+
+// number of shapes replaced by bounds near last point of 'SceneDist', it is counted and shown only with 'IsLodDebug'
+int SceneLod;
+
+// pixel footprint at point distance from camera
+float SceneLodSize( vec3 P )
+{
+  return IsLod ? distance(P, Loc) * LodPixels * Wp / (FrameW * ProjDist) : 0.0;
+}
+
+// Scene with material is evaluated exactly
 float SceneSDF( in vec3 point, inout mtl Mtl )
 { 
-float res, tmp;
+float res, tmp, tmp_lod = 0.0;
 
 mtl tmp_mtl;
+int tmp_id, res_id;
+
+SCENE
+
+return res;
+}
+
+// Scene distance without material, material code of scene is skipped
+#define SCENE_DIST
+float SceneDist( in vec3 point )
+{ 
+float res, tmp, tmp_lod = SceneLodSize(point);
+
+SceneLod = 0;
 
 SCENE
 
 return res;
 }
+#undef SCENE_DIST
 
 vec3 SDFSceneNormal( vec3 P )
 {
   float EPSILON = Threshold;
-  mtl Mtl;
 
-  float a = SceneSDF(vec3(P.x + EPSILON, P.y, P.z), Mtl),
-        b = SceneSDF(vec3(P.x - EPSILON, P.y, P.z), Mtl),
-        c = SceneSDF(vec3(P.x, P.y + EPSILON, P.z), Mtl),
-        d = SceneSDF(vec3(P.x, P.y - EPSILON, P.z), Mtl),
-        e = SceneSDF(vec3(P.x, P.y, P.z + EPSILON), Mtl),
-        f = SceneSDF(vec3(P.x, P.y, P.z - EPSILON), Mtl);
+  float a = SceneDist(vec3(P.x + EPSILON, P.y, P.z)),
+        b = SceneDist(vec3(P.x - EPSILON, P.y, P.z)),
+        c = SceneDist(vec3(P.x, P.y + EPSILON, P.z)),
+        d = SceneDist(vec3(P.x, P.y - EPSILON, P.z)),
+        e = SceneDist(vec3(P.x, P.y, P.z + EPSILON)),
+        f = SceneDist(vec3(P.x, P.y, P.z - EPSILON));
 
 
   return normalize(vec3(a - b, c - d, e - f));
@@ -572,13 +625,12 @@ vec3 Tonemap_ACES( const vec3 x )
 float calcAO( vec3 P, vec3 N )
 {
   float occ = 0.0;
-  mtl Mtl;
   float sca = 1.0;
 
   for (int i = 0; i < 5; i++)
   {
     float h = 0.01 + 0.12 * float(i) / 4.0;
-    float a = SceneSDF(P + h * N, Mtl);
+    float a = SceneDist(P + h * N);
 
     occ += (h - a.x) * sca;
     sca *= 0.95;
@@ -589,13 +641,32 @@ float calcAO( vec3 P, vec3 N )
   return clamp(1.0 - 3.0 * occ, 0.0, 1.0) * (0.5 + 0.5 * N.y);
 }
 
+// Clip ray segment to scene bounding sphere, segment is empty if ray misses scene
+void SceneClip( in ray R, inout float Min, inout float Max )
+{
+  if (SceneBound.w < 0)
+    return;
+
+  vec3 oc = R.Org - SceneBound.xyz;
+  float b = dot(oc, R.Dir), h = b * b - dot(oc, oc) + SceneBound.w * SceneBound.w;
+
+  if (h < 0)
+  {
+    Max = Min;
+    return;
+  }
+  h = sqrt(h);
+  Min = max(Min, -b - h);
+  Max = min(Max, -b + h);
+}
+
 float HardShadow( in ray R, float Min, float Max )
 {                 
-  mtl Mtl;
+  SceneClip(R, Min, Max);
 
   for (float t = Min; t < Max;)
   {   
-    float io = SceneSDF(RayApply(R, t), Mtl);
+    float io = SceneDist(RayApply(R, t));
     float h = io;
    
     if (abs(h) < 0.001)
@@ -611,11 +682,12 @@ float SoftShadow( in ray R, float Min, float Max, float k )
 {
   float res = 1.0;
   float ph = 1e20;
-  mtl Mtl;
+
+  SceneClip(R, Min, Max);
 
   for (float t = Min; t < Max;)
   {   
-    float io = SceneSDF(RayApply(R, t), Mtl);
+    float io = SceneDist(RayApply(R, t));
     float h = io;
    
     if (h < 0.001)
@@ -715,14 +787,29 @@ void SphereTracing( inout ray R, float MaxDist )
   float io;
   mtl Mtl;
 
+  SceneClip(R, t, MaxDist);
   while (t < MaxDist)
   {
-    io = SceneSDF(RayApply(R, t), Mtl);
+    io = SceneDist(RayApply(R, t));
 
     if (abs(io) <= Threshold)
     { 
       vec3 P = RayApply(R, t);
+      int lod = SceneLod;
       vec3 N = SDFSceneNormal(P);
+
+      // Exact shapes are green, ones replaced by bounds go from yellow to red by their count
+      if (IsLodDebug)
+      {
+        vec3 c = lod == 0 ? vec3(0, 0.6, 0) : mix(vec3(1, 1, 0), vec3(1, 0, 0), min(float(lod - 1) / 3.0, 1.0));
+
+        R.Color += c * (0.3 + 0.7 * abs(dot(N, R.Dir))) * R.Weight * R.Kr;
+        R.Weight = 0;
+        return;
+      }
+
+      // Material is found once for hit point
+      SceneSDF(P, Mtl);
       R.Color += Shade(R, P, N, Mtl) * R.Weight * R.Kr;
       R.Kr = 1 - Mtl.roughness;
       R.Weight *= 0.5;
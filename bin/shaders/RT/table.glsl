@@ -0,0 +1,248 @@
+// scene table (see 'parser::table'), replaces generated lights and flags
+layout(std430, binding = 5) readonly buffer SceneHead
+{
+  ivec4 SceneFlags; // skybox, reflection, shadows, ambient occlusion
+  ivec4 SceneCnt;   // point, dir and spot lights count, code size
+  vec4 SceneBound;  // scene bounding sphere, negative radius if scene is unbounded
+  point_light PointLgt[16];
+  dir_light DirLgt[16];
+  spot_light SpotLgt[16];
+  int SceneCode[];
+};
+
+// scene table constants
+layout(std430, binding = 6) readonly buffer SceneData
+{
+  float SceneVal[];
+};
+
+#define IsSkybox (SceneFlags.x != 0)
+#define IsReflection (SceneFlags.y != 0)
+#define IsShadows (SceneFlags.z != 0)
+#define IsAO (SceneFlags.w != 0)
+#define IsLod false
+#define IsLodDebug false
+#define PointLgtCnt SceneCnt.x
+#define DirLgtCnt SceneCnt.y
+#define SpotLgtCnt SceneCnt.z
+#define IsPointLgt (PointLgtCnt > 0)
+#define IsDirLgt (DirLgtCnt > 0)
+#define IsSpotLgt (SpotLgtCnt > 0)
+#define SceneStack 16
+
+float SceneNum( int Pc )
+{
+  int Op = SceneCode[Pc];
+
+  if (Op >= 0)
+    return SceneVal[Op];
+  Op = -1 - Op;
+  return FrameVal[Op / 4][Op % 4];
+}
+
+vec3 SceneVec( int Pc )
+{
+  return vec3(SceneNum(Pc), SceneNum(Pc + 1), SceneNum(Pc + 2));
+}
+
+vec3 SceneTex( int N, vec2 TexCoord )
+{
+  switch (N)
+  {
+  case 1:
+    return texture(Tex1, TexCoord).bgr;
+  case 2:
+    return texture(Tex2, TexCoord).bgr;
+  case 3:
+    return texture(Tex3, TexCoord).bgr;
+  case 4:
+    return texture(Tex4, TexCoord).bgr;
+  case 5:
+    return texture(Tex5, TexCoord).bgr;
+  case 6:
+    return texture(Tex6, TexCoord).bgr;
+  case 7:
+    return texture(Tex7, TexCoord).bgr;
+  default:
+    return texture(Tex8, TexCoord).bgr;
+  }
+}
+
+// scene interpreter, it is compiled again without materials as 'SceneRunDist' (see 'parser::table::GetCodeStr')
+#ifndef SCENE_DIST
+float SceneRun( in vec3 point, inout mtl Mtl )
+#else
+float SceneRunDist( in vec3 point )
+#endif
+{
+  float D[SceneStack];
+#ifndef SCENE_DIST
+  mtl M[SceneStack];
+#endif
+  vec3 p = point;
+  int sp = 0, pc = 0;
+
+  while (pc < SceneCnt.w)
+  {
+    int op = SceneCode[pc];
+
+    if (op == 0)
+    {
+      // point
+      p = point;
+      pc += 1;
+    }
+    else if (op == 1)
+    {
+      // baked modifications
+      p = mat3(SceneVec(pc + 1), SceneVec(pc + 4), SceneVec(pc + 7)) * p + SceneVec(pc + 10);
+      pc += 13;
+    }
+    else if (op == 2)
+    {
+      p = Rotate(SceneNum(pc + 1), SceneVec(pc + 2), p);
+      pc += 5;
+    }
+    else if (op == 3)
+    {
+      p = Translate(SceneVec(pc + 1), p);
+      pc += 4;
+    }
+    else if (op == 4)
+    {
+      p = Scale(SceneVec(pc + 1), p);
+      pc += 4;
+    }
+    else if (op == 8)
+    {
+      p = Replication(SceneVec(pc + 1), p);
+      pc += 4;
+    }
+    else if (op == 9)
+    {
+      p = ReplicationLimited(SceneVec(pc + 1), SceneVec(pc + 4), p);
+      pc += 7;
+    }
+    else if (op == 10)
+    {
+      p = Mirror(SceneVec(pc + 1), p);
+      pc += 4;
+    }
+    else if (op == 5)
+    {
+      // shape
+      int type = SceneCode[pc + 1], tex = SceneCode[pc + 2];
+      vec2 uv = vec2(0);
+      float d;
+
+      pc += 3;
+      if (type == 0)
+      {
+        d = SDFSphere(p, sphere(SceneVec(pc), SceneNum(pc + 3)), uv);
+        pc += 4;
+      }
+      else if (type == 1)
+      {
+        d = SDFBox(p, box(SceneVec(pc), SceneVec(pc + 3)), uv);
+        pc += 6;
+      }
+      else if (type == 2)
+      {
+        d = SDFCylinder(p, cylinder(SceneVec(pc), SceneNum(pc + 3), SceneVec(pc + 4), SceneNum(pc + 7)), uv);
+        pc += 8;
+      }
+      else if (type == 3)
+      {
+        d = SDFCapsule(p, capsule(SceneVec(pc), SceneVec(pc + 3), SceneNum(pc + 6)), uv);
+        pc += 7;
+      }
+      else if (type == 4)
+      {
+        d = SDFPlane(p, plane(SceneVec(pc), SceneNum(pc + 3)), uv);
+        pc += 4;
+      }
+      else if (type == 5)
+      {
+        d = SDFTorus(p, torus(SceneVec(pc), SceneVec(pc + 3), SceneNum(pc + 6), SceneNum(pc + 7)), uv);
+        pc += 8;
+      }
+      else if (type == 6)
+      {
+        d = SDFEllipsoid(p, ellipsoid(SceneVec(pc), SceneVec(pc + 3)), uv);
+        pc += 6;
+      }
+      else
+      {
+        d = SDFSea(p, sea(SceneNum(pc), SceneNum(pc + 1), int(SceneNum(pc + 2))));
+        pc += 3;
+      }
+
+#ifndef SCENE_DIST
+      mtl m;
+
+      if (SceneCode[pc] == 0)
+        m = MtlLib[int(SceneNum(pc + 1))];
+      else
+        m = mtl(SceneVec(pc + 1), SceneNum(pc + 4), SceneNum(pc + 5));
+      if (tex != 0)
+        m.Albedo = SceneTex(tex, uv);
+      M[sp] = m;
+#endif
+      pc += SceneCode[pc] == 0 ? 2 : 6;
+      D[sp++] = d;
+    }
+    else
+    {
+      // operation or adding to scene
+      float a = D[sp - 2], b = D[sp - 1], r;
+
+      if (op == 6)
+      {
+        int type = SceneCode[pc + 1];
+        float k = SceneNum(pc + 2);
+
+        if (type == 0)
+          r = SDFUnion(a, b);
+        else if (type == 1)
+          r = SDFUnionSmooth(a, b, k);
+        else if (type == 2)
+          r = SDFDifer(a, b);
+        else if (type == 3)
+          r = SDFDiferSmooth(a, b, k);
+        else if (type == 4)
+          r = SDFInter(a, b);
+        else
+          r = SDFInterSmooth(a, b, k);
+        pc += 3;
+      }
+      else
+      {
+        r = SDFUnion(a, b);
+        pc += 1;
+      }
+#ifndef SCENE_DIST
+      mtl ma = M[sp - 2], mb = M[sp - 1], m;
+
+      // Scene addition prefers added shape on equal distances
+      if (op != 6 && r == b)
+        m = mb;
+      else if (r == a)
+        m = ma;
+      else if (r == b)
+        m = mb;
+      else
+        m = SDFSurfaceSmoothUnion(a, ma, b, mb, 0.5);
+      M[sp - 2] = m;
+#endif
+      sp--;
+      D[sp - 1] = r;
+    }
+  }
+  if (sp == 0)
+    return HUGE_VAL;
+#ifndef SCENE_DIST
+  Mtl = M[0];
+#endif
+  return D[0];
+}
+
@@ -8,7 +8,7 @@
   *               Animation module.
   * PROGRAMMER  : Vladislav Biserov.
   *               Maxim Molostov.
-  * LAST UPDATE : 30.03.2023
+  * LAST UPDATE : 01.04.2023
   * NOTE        : None.
   *
   * No part of this file may be changed without agreement of
@@ -16,12 +16,33 @@
   */
 
 
+#include <chrono>
+#include <filesystem>
 #include <fstream>
+#include <span>
 #include "animation.h"
 #include "../utils/parser/parser.h"
 
 trm::animation trm::animation::Instance;
 
+/* Scene compiled by worker thread */
+struct trm::animation::reload
+{
+  BOOL IsChanged = FALSE;                             // Is shader text changed
+  BOOL IsTable = FALSE;                               // Is scene table used
+  BOOL IsOk = TRUE;                                   // Are all shaders built
+  parser::compile_context Context;                    // Switches scene is compiled with and shader write counters
+  std::string Report;                                 // Parser report
+  std::map<std::string, texture::tex_data> Textures;  // Scene textures, new ones aren't loaded yet
+  std::shared_ptr<parser::pack> Pack;                 // Precompiled scene, table is uploaded from it
+  std::vector<INT> HeadBuf;                           // Scene table program of parsed scene
+  std::vector<FLT> ValsBuf;                           // Scene table constants of parsed scene
+  std::span<const INT> Head;                          // Scene table program
+  std::span<const FLT> Vals;                          // Scene table constants
+  std::optional<parser::vm> Frame;                    // Frame uniforms program
+  LARGE_INTEGER Start {};                             // Shader rebuild start time
+}; /* End of 'trm::animation::reload' structure */
+
 /* Render function.
  * ARGUMENTS: None.
  * RETURNS: None.
@@ -30,18 +51,29 @@ VOID trm::animation::Render( VOID )
 {
   static std::string SName = "bin\\scenes\\a.scene";
   UboAnim->Apply();
+  UboFrame->Apply();
+  UboParam->Apply();
   timer::Response();
   if (win::IsActive)
     input::Response();
   Scene->Response(this);
   render::Start();
   
+  // Switch between generated scene code and scene table interpreter
+  if (KeysClick['I'])
+  {
+    IsTable = !IsTable;
+    Reload(SName);
+  }
+  // Switch parameters mode: values edits don't rebuild shader while parameters fit into 'ParamVal'
+  if (KeysClick['U'])
+  {
+    IsParams = !IsParams;
+    Reload(SName);
+  }
   if (DW.IsChanged(GlobalTime))
   {
-    parser::Parse(SName,
-      "bin\\shaders\\RT\\myfrag.glsl", "bin\\shaders\\RT\\frag.glsl");
-    UpdateTextures();
-    shader_manager::Update();
+    Reload(SName);
     OutputDebugString("updated\n");
   }
   if (win::IsFileChanged)
@@ -50,27 +82,269 @@ VOID trm::animation::Render( VOID )
     SName = "bin\\scenes\\" + win::CurSceneName;
     SetCurrentDirectory(win::WorkDirectory.c_str());
     win::UpdateMenuSceneName();
-    parser::Parse(SName,
-      "bin\\shaders\\RT\\myfrag.glsl", "bin\\shaders\\RT\\frag.glsl");
-    UpdateTextures();
-    shader_manager::Update();
+    Reload(SName);
   }
+  Swap(FALSE);
   UBO_ANIM UC =
   {
     vec4(0, 0, 0, Time),
   };
   UboAnim->Update(&UC);
+
+  UBO_FRAME UF {};
+
+  if (Active != nullptr && Active->Frame.has_value())
+  {
+    const std::vector<float> &Vals = Active->Frame->Frame(Time);
+
+    // Parameters after 'FrameVal' slots don't change, they are uploaded on swap
+    std::copy_n(Vals.begin(), std::min<size_t>(Vals.size(), parser::uniforms::MaxCount), UF.Val);
+  }
+  UboFrame->Update(&UF);
+
+  // Query of this slot was issued some frames ago, its result doesn't stall pipeline
+  INT Slot = GpuFrame++ % GpuQueryCnt;
+  INT IsReady = 0;
+
+  if (GpuQueryScene[Slot] == GpuScene)
+  {
+    glGetQueryObjectiv(GpuQuery[Slot], GL_QUERY_RESULT_AVAILABLE, &IsReady);
+    if (IsReady)
+    {
+      GLuint64 Ns = 0;
+
+      glGetQueryObjectui64v(GpuQuery[Slot], GL_QUERY_RESULT, &Ns);
+      GpuTime += Ns / 1e6;
+      if (++GpuCnt == 500)
+        GpuReport();
+    }
+  }
+  glBeginQuery(GL_TIME_ELAPSED, GpuQuery[Slot]);
   Scene->Render(this);
+  glEndQuery(GL_TIME_ELAPSED);
+  GpuQueryScene[Slot] = GpuScene;
   render::End();
 }; /* End of 'trm::animation::Render' function */
 
-VOID trm::animation::UpdateTextures( VOID )
+/* Report scene render time function.
+ * Time is averaged for scene in use and its backend, so text
+ * and table backends of the same scene may be compared.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+VOID trm::animation::GpuReport( VOID )
+{
+  if (GpuCnt > 0)
+    OutputDebugString(std::format("scene render: {:.3f} ms GPU average of {} frames, {}\n", GpuTime / GpuCnt, GpuCnt,
+      Active != nullptr && Active->IsTable ? "scene table" : "shader text").c_str());
+  GpuTime = 0;
+  GpuCnt = 0;
+} /* End of 'trm::animation::GpuReport' function */
+
+/* Load new textures function.
+ * ARGUMENTS:
+ *   - scene textures:
+ *       std::map<std::string, texture::tex_data> &Tex;
+ * RETURNS: None.
+ */
+VOID trm::animation::UpdateTextures( std::map<std::string, texture::tex_data> &Tex )
+{
+  for (auto &tex : Tex)
+  {
+    // Textures of previous scene version are kept by parser
+    if (tex.second.Tex == nullptr)
+      tex.second.Tex = texture_manager::CreateTexture(tex.first);
+  }
+} /* End of 'trm::animation::UpdateTextures' function */
+
+/* Reload scene function.
+ * Scene is parsed by worker thread, old one is rendered until
+ * new shaders are linked (see 'Swap'). Compiled scene is saved to
+ * 'bin/cache', unchanged scene is loaded from there without parsing.
+ * ARGUMENTS:
+ *   - scene file name:
+ *       const std::string &Name;
+ * RETURNS: None.
+ */
+VOID trm::animation::Reload( const std::string &Name )
+{
+  // Only one scene is compiled at once, the last request wins
+  if (Compiling.valid() || Pending != nullptr)
+  {
+    Queued = Name;
+    return;
+  }
+  parser::compile_context Ctx;
+
+  Ctx.IsTable = IsTable != FALSE;
+  Ctx.IsParams = IsParams != FALSE;
+
+  Compiling = std::async(std::launch::async, [Name, Ctx]( std::map<std::string, texture::tex_data> Tex )
+    {
+      std::shared_ptr<reload> R = std::make_shared<reload>();
+      std::string
+        In = "bin\\shaders\\RT\\myfrag.glsl",
+        Out = "bin\\shaders\\RT\\frag.glsl",
+        Bin = "bin\\cache\\" + std::filesystem::path(Name).filename().string() + ".bin";
+      UINT64 Source = parser::pack::Source(Name, In, Ctx);
+      LARGE_INTEGER Start, End, Freq;
+
+      R->Context = Ctx;
+      QueryPerformanceFrequency(&Freq);
+      QueryPerformanceCounter(&Start);
+      if ((R->Pack = parser::pack::Open(Bin, Source)) != nullptr)
+      {
+        // Shader on disk is usually the same, it was loaded on start
+        R->IsChanged = parser::file::Write(Out, std::string(R->Pack->GetShader()), std::string(R->Pack->GetKey()));
+        (R->IsChanged ? R->Context.WriteCnt : R->Context.SkipCnt)++;
+        R->Textures = R->Pack->GetTextures(Tex);
+        R->Report = R->Pack->GetReport();
+        if (std::optional<parser::program> Prg = R->Pack->GetFrame(); Prg.has_value())
+          R->Frame.emplace(std::move(*Prg));
+        R->IsTable = R->Pack->IsTable();
+        R->Head = R->Pack->GetHead();
+        R->Vals = R->Pack->GetVals();
+      }
+      else
+      {
+        // Comment and values only edits produce the same shader
+        R->IsChanged = parser::Parse(Name, In, Out, Tex, R->Context);
+        R->Textures = std::move(Tex);
+        R->Report = std::move(R->Context.Report);
+        if (R->Context.Frame.has_value())
+          R->Frame.emplace(std::move(*R->Context.Frame));
+        R->IsTable = R->Context.IsTableUsed;
+        if (R->IsTable)
+        {
+          R->HeadBuf = std::move(R->Context.Head);
+          R->ValsBuf = std::move(R->Context.Vals);
+          R->Head = R->HeadBuf;
+          R->Vals = R->ValsBuf;
+        }
+        if (!parser::pack::Save(Bin, Source, {R->Context.Shader, R->Context.Key, R->Report,
+              &R->Textures, R->IsTable != FALSE, R->Head, R->Vals, R->Frame.has_value() ? &R->Frame->GetProgram() : nullptr}))
+          R->Report += std::format("scene isn't saved to '{}', it is parsed again on next load\n", Bin);
+      }
+      QueryPerformanceCounter(&End);
+      R->Report += std::format("scene {}: {:.3f} ms\n", R->Pack != nullptr ? "loaded from '" + Bin + "'" : "compiled",
+        static_cast<DBL>(End.QuadPart - Start.QuadPart) * 1000 / Freq.QuadPart);
+      return R;
+    }, Textures);
+}; /* End of 'trm::animation::Reload' function */
+
+/* Swap reloaded scene function.
+ * ARGUMENTS:
+ *   - wait for reload to be finished flag:
+ *       BOOL IsWait;
+ * RETURNS: None.
+ */
+VOID trm::animation::Swap( BOOL IsWait )
 {
-  for (auto tex : Textures)
+  LARGE_INTEGER Start, End, Freq;
+
+  QueryPerformanceFrequency(&Freq);
+  if (Compiling.valid())
+  {
+    if (!IsWait && Compiling.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      return;
+    try
+    {
+      Pending = Compiling.get();
+    }
+    catch (std::exception &E)
+    {
+      // Old scene is kept
+      OutputDebugString((std::string("scene error: ") + E.what() + "\n").c_str());
+    }
+    if (Pending != nullptr && Pending->IsChanged)
+    {
+      QueryPerformanceCounter(&Pending->Start);
+      shader_manager::Start();
+    }
+  }
+  if (Pending == nullptr)
   {
-    Textures[tex.first].Tex = texture_manager::CreateTexture(tex.first);
+    if (!Queued.empty())
+      Reload(std::exchange(Queued, std::string()));
+    return;
   }
-}
+
+  // Old programs are rendered while new ones are compiled by driver
+  if (Pending->IsChanged)
+  {
+    while (!shader_manager::Swap(Pending->IsOk))
+      if (!IsWait)
+        return;
+    QueryPerformanceCounter(&End);
+    DBL BuildTime = static_cast<DBL>(End.QuadPart - Pending->Start.QuadPart) / Freq.QuadPart;
+
+    // Driver compile time of this shader, its size is in parser report
+    RebuildTime += BuildTime;
+    OutputDebugString(std::format("scene shader rebuild: {:.1f} ms\n", BuildTime * 1000).c_str());
+  }
+  std::shared_ptr<reload> R = std::move(Pending);
+
+  if (!R->IsOk)
+  {
+    // Scene data must match programs in use
+    OutputDebugString("scene shader build failed, see 'bin/shaders/error.log'\n");
+    if (!Queued.empty())
+      Reload(std::exchange(Queued, std::string()));
+    return;
+  }
+  // Textures and frame uniforms are taken with programs, textures are checked even if shader text is unchanged
+  UpdateTextures(R->Textures);
+  Textures = std::move(R->Textures);
+  // Queries issued for previous scene are not counted
+  GpuReport();
+  GpuScene++;
+  Active = R;
+  if (R->Frame.has_value() && R->Frame->GetProgram().Outs > parser::uniforms::MaxCount)
+  {
+    const std::vector<float> &Vals = R->Frame->Frame(Time);
+    std::unique_ptr<UBO_PARAM> UP = std::make_unique<UBO_PARAM>();
+
+    std::copy(Vals.begin() + parser::uniforms::MaxCount, Vals.end(), UP->Val);
+    UboParam->Update(UP.get());
+  }
+  RebuildCnt += R->Context.WriteCnt;
+  SkipCnt += R->Context.SkipCnt;
+  OutputDebugString(R->Report.c_str());
+
+  if (R->IsTable)
+  {
+    INT
+      HeadSize = static_cast<INT>(R->Head.size() * sizeof(INT)),
+      ValsSize = static_cast<INT>(R->Vals.size() * sizeof(FLT));
+
+    QueryPerformanceCounter(&Start);
+    if (SsboHead == nullptr)
+    {
+      SsboHead = CreateStorageBuffer(parser::table::HeadBinding, R->Head.data(), HeadSize);
+      SsboData = CreateStorageBuffer(parser::table::DataBinding, R->Vals.data(), ValsSize);
+    }
+    else
+    {
+      SsboHead->UpdateStorage(R->Head.data(), HeadSize);
+      SsboData->UpdateStorage(R->Vals.data(), ValsSize);
+    }
+    QueryPerformanceCounter(&End);
+    OutputDebugString(std::format("scene table upload: {:.3f} ms, {} bytes\n",
+      static_cast<DBL>(End.QuadPart - Start.QuadPart) * 1000 / Freq.QuadPart, HeadSize + ValsSize).c_str());
+  }
+  // Scene in use keeps its frame program only, mapped file may be saved again
+  R->Head = {};
+  R->Vals = {};
+  R->HeadBuf.clear();
+  R->ValsBuf.clear();
+  R->Pack.reset();
+
+  if (RebuildCnt > 0)
+    OutputDebugString(std::format("shader rebuild: {:.1f} ms average, about {:.1f} ms saved\n",
+      RebuildTime * 1000 / RebuildCnt, RebuildTime * 1000 / RebuildCnt * SkipCnt).c_str());
+  if (!Queued.empty())
+    Reload(std::exchange(Queued, std::string()));
+}; /* End of 'trm::animation::Swap' function */
 
 /* Initialization function.
  * ARGUMENTS: None.
@@ -79,12 +353,12 @@ VOID trm::animation::UpdateTextures( VOID )
 VOID trm::animation::Init( VOID )
 {
   DW.StartWatch("bin\\scenes");
+  glGenQueries(GpuQueryCnt, GpuQuery);
 
   SetCurrentDirectory(win::WorkDirectory.c_str());
-  parser::Parse("bin\\scenes\\a.scene",
-    "bin\\shaders\\RT\\myfrag.glsl", "bin\\shaders\\RT\\frag.glsl");
-  UpdateTextures();
-  shader_manager::Update();
+  Reload("bin\\scenes\\a.scene");
+  // First frame needs scene
+  Swap(TRUE);
 }; /* End of 'trm::animation::Init' function */
 
 /* Deinitialization function.
@@ -94,6 +368,9 @@ VOID trm::animation::Init( VOID )
 VOID trm::animation::Close( VOID )
 {
   DW.StopWatch();
+  if (Compiling.valid())
+    Compiling.wait();
+  glDeleteQueries(GpuQueryCnt, GpuQuery);
 }; /* End of 'trm::animation::Close' function */
 
 /* Resize window function.
@@ -8,7 +8,7 @@
   *               Animation module.
   * PROGRAMMER  : Vladislav Biserov.
   *               Maxim Molostov.
-  * LAST UPDATE : 05.01.2023
+  * LAST UPDATE : 31.03.2023
   * NOTE        : None.
   *
   * No part of this file may be changed without agreement of
@@ -20,6 +20,8 @@
 #define __animation_h_
 
 #include <initializer_list>
+#include <future>
+#include <memory>
 #include "../def.h"
 #include "../utils/stock.h"
 #include "win/win.h"
@@ -125,6 +127,31 @@ namespace trm
       vec4 DummyTime;
     };
     buffer *UboAnim;
+    struct UBO_FRAME
+    {
+      FLT Val[256]; // Scene values evaluated once per frame
+    };
+    buffer *UboFrame;
+    struct UBO_PARAM
+    {
+      FLT Val[4096]; // Object arguments in parameters mode, set on scene swap
+    };
+    buffer *UboParam;
+    buffer *SsboHead = nullptr, *SsboData = nullptr; // Scene table program and constants
+    DBL RebuildTime = 0; // Total time of performed shader rebuilds in seconds
+    INT RebuildCnt = 0, SkipCnt = 0; // Performed and skipped shader rebuilds
+    BOOL IsTable = FALSE, IsParams = FALSE; // Switches scenes are compiled with (see 'parser::compile_context')
+    static const INT GpuQueryCnt = 4;     // Scene render time queries count, result is read this many frames later
+    UINT GpuQuery[GpuQueryCnt] {};        // Scene render time queries (GL_TIME_ELAPSED), used in turn
+    INT GpuQueryScene[GpuQueryCnt] {};    // Number of scene query was issued for, 0 if not issued
+    INT GpuFrame = 0, GpuScene = 1;       // Frame counter and number of scene in use
+    DBL GpuTime = 0;                      // Total scene render time in milliseconds
+    INT GpuCnt = 0;                       // Frames measured for scene in use
+    struct reload;                                  // Scene compiled by worker thread
+    std::future<std::shared_ptr<reload>> Compiling; // Scene being parsed
+    std::shared_ptr<reload> Pending;                // Parsed scene waiting for its shaders
+    std::shared_ptr<reload> Active;                 // Scene in use, its frame uniforms are evaluated each frame
+    std::string Queued;                             // Scene requested while other one is compiled
     directory_watcher DW;
     // parser Parser;
 
@@ -134,6 +161,10 @@ namespace trm
     {
       UBO_ANIM *UC = nullptr;
       UboAnim = CreateBuffer(3, UC);
+      UBO_FRAME *UF = nullptr;
+      UboFrame = CreateBuffer(4, UF);
+      UBO_PARAM *UP = nullptr;
+      UboParam = CreateBuffer(7, UP);
 
       /* Update menu */
       win::CurSceneName = "a.scene";
@@ -199,7 +230,35 @@ namespace trm
 
   private:
 
-    VOID UpdateTextures( VOID );
+    /* Load new textures function.
+     * ARGUMENTS:
+     *   - scene textures:
+     *       std::map<std::string, texture::tex_data> &Tex;
+     * RETURNS: None.
+     */
+    VOID UpdateTextures( std::map<std::string, texture::tex_data> &Tex );
+
+    /* Reload scene function.
+     * ARGUMENTS:
+     *   - scene file name:
+     *       const std::string &Name;
+     * RETURNS: None.
+     */
+    VOID Reload( const std::string &Name );
+
+    /* Swap reloaded scene function.
+     * ARGUMENTS:
+     *   - wait for reload to be finished flag:
+     *       BOOL IsWait;
+     * RETURNS: None.
+     */
+    VOID Swap( BOOL IsWait );
+
+    /* Report scene render time function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID GpuReport( VOID );
 
     /* Render function.
      * ARGUMENTS: None.
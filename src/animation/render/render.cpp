@@ -192,6 +192,12 @@ trm::render::render( HWND &hWnd, INT &W, INT &H ) :
   hGLRC = hRC;
   wglMakeCurrent(hDC, hGLRC);
 
+#ifdef GL_ARB_parallel_shader_compile
+  /* Scene shaders are rebuilt in background by driver threads (see 'shader::Swap') */
+  if (GLEW_ARB_parallel_shader_compile)
+    glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+#endif /* GL_ARB_parallel_shader_compile */
+
   /* Render parameters setup */
   glClearColor(0.30, 0.47, 0.8, 1);
   glEnable(GL_DEPTH_TEST);
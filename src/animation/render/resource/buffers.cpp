@@ -19,6 +19,49 @@
 #include "buffers.h"
 #include "../../../def.h"
 
+/* Create shader storage buffer function
+ * ARGUMENTS: 
+ *   - binding point:
+ *       UINT BindingPoint;
+ *   - data:
+ *       const VOID *Data;
+ *   - data size in bytes:
+ *       INT Size;
+ * RETURNS:
+ *   (buffer &) self reference
+ */
+trm::buffer & trm::buffer::CreateStorage( UINT BindingPoint, const VOID *Data, INT Size )
+{
+  Free();
+  BindPoint = BindingPoint;
+  NumOfQuads = Size / 16;
+  Target = GL_SHADER_STORAGE_BUFFER;
+
+  glGenBuffers(1, &Id);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, Id);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, Size, Data, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  Apply();
+  return *this;
+} // end of 'trm::buffer::CreateStorage' function
+
+/* Update shader storage buffer function, buffer is reallocated for new size
+ * ARGUMENTS:
+ *   - data:
+ *       const VOID *Data;
+ *   - data size in bytes:
+ *       INT Size;
+ * RETURNS: None.
+ */ 
+VOID trm::buffer::UpdateStorage( const VOID *Data, INT Size )
+{
+  NumOfQuads = Size / 16;
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, Id);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, Size, Data, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  Apply();
+} // end of 'trm::buffer::UpdateStorage' function
+
 /* Apply buffers 
  * ARGUMENTS: None.
  * RETURNS: None.
@@ -26,7 +69,7 @@
 VOID trm::buffer::Apply( VOID )
 {
   if (BindPoint != 0)
-    glBindBufferBase(GL_UNIFORM_BUFFER, BindPoint, Id);
+    glBindBufferBase(Target, BindPoint, Id);
 } // end of 'trm::buffer::Apply' function
 
 /* Free buffers 
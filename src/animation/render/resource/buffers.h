@@ -35,6 +35,7 @@ namespace trm
     UINT Id;        // open gl id
     UINT BindPoint; // binding point for shader
     INT NumOfQuads; // number of vec4
+    UINT Target;    // uniform or shader storage buffer
 
     /* Create buffer function
      * ARGUMENTS: 
@@ -51,6 +52,7 @@ namespace trm
         Free();
         BindPoint = BindingPoint;
         NumOfQuads = sizeof(*Ptr) / 16;
+        Target = GL_UNIFORM_BUFFER;
 
         glGenBuffers(1, &Id);
         glBindBuffer(GL_UNIFORM_BUFFER, Id);
@@ -59,9 +61,11 @@ namespace trm
         Apply();
         return *this;
       } // end of 'trm::buffer::Create' function
+
+    buffer & CreateStorage( UINT BindingPoint, const VOID *Data, INT Size );
   public:
     /* default constructor */
-    buffer( VOID ) : Id(0), BindPoint(0), NumOfQuads(0)
+    buffer( VOID ) : Id(0), BindPoint(0), NumOfQuads(0), Target(GL_UNIFORM_BUFFER)
     {
     } // end of default consructor
 
@@ -84,6 +88,8 @@ namespace trm
         glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(*Ptr), Ptr);
         glBindBuffer(GL_UNIFORM_BUFFER, 0);
       } // end of 'trm::buffer::Update' function
+
+    VOID UpdateStorage( const VOID *Data, INT Size );
    
     /* Free buffers 
      * ARGUMENTS: None.
@@ -117,6 +123,22 @@ namespace trm
         return Add(buffer().Create(BindingPoint, Ptr));
       } /* End of 'trm::buffer_manager::CreateBuffers' function */
 
+    /* Create shader storage buffer function
+     * ARGUMENTS: 
+     *   - binding point:
+     *       UINT BindingPoint;
+     *   - data:
+     *       const VOID *Data;
+     *   - data size in bytes:
+     *       INT Size;
+     * RETURNS:
+     *   (buffer *) pointer to buffer
+     */
+    buffer * CreateStorageBuffer( UINT BindingPoint, const VOID *Data, INT Size )
+    {
+      return Add(buffer().CreateStorage(BindingPoint, Data, Size));
+    } /* End of 'trm::buffer_manager::CreateStorageBuffer' function */
+
     /* Update buffers 
      * ARGUMENTS:
      *   - data structure:
@@ -8,7 +8,7 @@
   *               Animation module.
   * PROGRAMMER  : Vladislav Biserov.
   *               Maxim Molostov.
-  * LAST UPDATE : 17.11.2022
+  * LAST UPDATE : 31.03.2023
   * NOTE        : None.
   *
   * No part of this file may be changed without agreement of
@@ -67,14 +67,13 @@ std::string trm::shader::LoadTextFile( const std::string &FileName )
                       std::istreambuf_iterator<char>());
 } /* End of 'trm::shader::LoadTextFile' function */
 
-/* Load shader function.
+/* Build shader program function.
  * ARGUMENTS: None.
  * RETURNS:
- *   (shader &) Self-reference.
+ *   (UINT) Program id with link issued, 0 if it can't be created.
  */
-trm::shader & trm::shader::Load( VOID )
+UINT trm::shader::Build( VOID )
 {
-  Free();
   struct
   {
     INT Type;          /* Shader OpenFL type (e.g. GL_VERTEX_SHADER) */
@@ -88,9 +87,9 @@ trm::shader & trm::shader::Load( VOID )
     {GL_GEOMETRY_SHADER, "GEOM", 0},
     {GL_FRAGMENT_SHADER, "FRAG", 0},
   };
-  INT res;
   CHAR Buf[1000];
   BOOL is_ok = TRUE;
+  UINT prg = 0;
 
   for (auto &s : shdr)
   {
@@ -124,56 +123,81 @@ trm::shader & trm::shader::Load( VOID )
     const CHAR *Src[]= {txt.c_str()};
     glShaderSource(s.Id, 1, Src, NULL);
 
-    /* Compile shader */
+    /* Compile shader, its status is checked after link (see 'Check') */
     glCompileShader(s.Id);
-    glGetShaderiv(s.Id, GL_COMPILE_STATUS, &res);
-    if (res != 1)
-    {
-      glGetShaderInfoLog(s.Id, sizeof(Buf), &res, Buf);
-      Log(s.Stuff, Buf);
-      is_ok = FALSE;
-      break;
-    }
   }
 
   /* Create shader program */
   if (is_ok)
   {
-    if ((ProgId = glCreateProgram()) == 0)
+    if ((prg = glCreateProgram()) == 0)
       is_ok = FALSE;
     else
     {
-      /* Attach shaders to program */
+      /* Attach shaders to program and link it */
       for (auto s : shdr)
         if (s.Id != 0)
-          glAttachShader(ProgId, s.Id);
-      /* Link shader program */
-      glLinkProgram(ProgId);
-      glGetProgramiv(ProgId, GL_LINK_STATUS, &res);
-      if (res != 1)
-      {
-        glGetProgramInfoLog(ProgId, sizeof(Buf), &res, Buf);
-        Log("LINK", Buf);
-        is_ok = FALSE;
-      }
+          glAttachShader(prg, s.Id);
+      glLinkProgram(prg);
     }
   }
 
   if (!is_ok)
-  {
     /* Delete all created shaders */
     for (auto s : shdr)
       if (s.Id != 0)
-      {
-        if (ProgId != 0)
-          glDetachShader(ProgId, s.Id);
         glDeleteShader(s.Id);
-      }
-    /* Delete program */
-    if (ProgId != 0)
-      glDeleteProgram(ProgId);
-    ProgId = 0;
+  return prg;
+} /* End of 'trm::shader::Build' function */
+
+/* Check is shader program built function.
+ * ARGUMENTS:
+ *   - program id:
+ *       UINT Prg;
+ * RETURNS:
+ *   (BOOL) TRUE if program is linked, otherwise it is deleted.
+ */
+BOOL trm::shader::Check( UINT Prg )
+{
+  INT n, res;
+  UINT shds[5];
+  CHAR Buf[1000];
+
+  if (Prg == 0)
+    return FALSE;
+  glGetProgramiv(Prg, GL_LINK_STATUS, &res);
+  if (res == 1)
+    return TRUE;
+
+  /* Compilation errors go first, link error is a consequence of them */
+  glGetAttachedShaders(Prg, 5, &n, shds);
+  for (INT i = 0; i < n; i++)
+  {
+    glGetShaderiv(shds[i], GL_COMPILE_STATUS, &res);
+    if (res != 1)
+    {
+      glGetShaderInfoLog(shds[i], sizeof(Buf), &res, Buf);
+      glGetShaderiv(shds[i], GL_SHADER_TYPE, &res);
+      Log(res == GL_VERTEX_SHADER ? "VERT" : res == GL_FRAGMENT_SHADER ? "FRAG" : "SHADER", Buf);
+    }
   }
+  glGetProgramInfoLog(Prg, sizeof(Buf), &res, Buf);
+  Log("LINK", Buf);
+  Free(Prg);
+  return FALSE;
+} /* End of 'trm::shader::Check' function */
+
+/* Load shader function.
+ * ARGUMENTS: None.
+ * RETURNS:
+ *   (shader &) Self-reference.
+ */
+trm::shader & trm::shader::Load( VOID )
+{
+  Free();
+  ProgId = Build();
+  if (!Check(ProgId))
+    ProgId = 0;
   return *this;
 } /* End of 'trm::shader::Load' function */
 
@@ -182,21 +206,32 @@ trm::shader & trm::shader::Load( VOID )
  * RETURNS: None.
  */
 VOID trm::shader::Free( VOID )
+{
+  Free(ProgId);
+} /* End of 'trm::shader::Free' function */
+
+/* Free shader program function.
+ * ARGUMENTS:
+ *   - program id:
+ *       UINT Prg;
+ * RETURNS: None.
+ */
+VOID trm::shader::Free( UINT Prg )
 {
   INT n;
   UINT shds[5];
 
-  if (ProgId == 0)
+  if (Prg == 0)
     return;
 
-  glGetAttachedShaders(ProgId, 5, &n, shds);
+  glGetAttachedShaders(Prg, 5, &n, shds);
 
-  for (auto s: shds)
+  for (INT i = 0; i < n; i++)
   {
-    glDetachShader(ProgId, s);
-    glDeleteShader(s);
+    glDetachShader(Prg, shds[i]);
+    glDeleteShader(shds[i]);
   }
-  glDeleteProgram(ProgId);
+  glDeleteProgram(Prg);
 } /* End of 'trm::shader::Free' function */
 
 /* Update shader function.
@@ -208,6 +243,76 @@ VOID trm::shader::Update( VOID )
   Load();
 } /* End of 'trm::shader::Update' function */
 
+/* Start shader rebuild function.
+ * Old program is kept in use until all rebuilt ones are linked (see 'shader_manager::Swap').
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+VOID trm::shader::Start( VOID )
+{
+  Free(NewProgId);
+  NewProgId = Build();
+  IsRebuilt = TRUE;
+} /* End of 'trm::shader::Start' function */
+
+/* Check is rebuilt shader program compiled function.
+ * ARGUMENTS: None.
+ * RETURNS:
+ *   (BOOL) TRUE if rebuild is compiled or not started, FALSE if it is still compiling.
+ */
+BOOL trm::shader::IsReady( VOID )
+{
+  if (NewProgId == 0)
+    return TRUE;
+#ifdef GL_ARB_parallel_shader_compile
+  if (GLEW_ARB_parallel_shader_compile)
+  {
+    INT done = GL_TRUE;
+
+    // Driver compiles on own threads, status query doesn't wait for it
+    glGetProgramiv(NewProgId, GL_COMPLETION_STATUS_ARB, &done);
+    return done == GL_TRUE;
+  }
+#endif /* GL_ARB_parallel_shader_compile */
+  return TRUE;
+} /* End of 'trm::shader::IsReady' function */
+
+/* Check is rebuilt shader program linked function.
+ * ARGUMENTS: None.
+ * RETURNS:
+ *   (BOOL) TRUE if rebuilt program is linked or rebuild is not started.
+ */
+BOOL trm::shader::IsLinked( VOID )
+{
+  if (!IsRebuilt)
+    return TRUE;
+  // Failed program is deleted by check
+  if (!Check(NewProgId))
+    NewProgId = 0;
+  return NewProgId != 0;
+} /* End of 'trm::shader::IsLinked' function */
+
+/* Finish shader rebuild function.
+ * ARGUMENTS:
+ *   - use rebuilt program flag, otherwise it is deleted and old one is kept:
+ *       BOOL IsUse;
+ * RETURNS: None.
+ */
+VOID trm::shader::Swap( BOOL IsUse )
+{
+  if (!IsRebuilt)
+    return;
+  if (IsUse)
+  {
+    Free();
+    ProgId = NewProgId;
+  }
+  else
+    Free(NewProgId);
+  NewProgId = 0;
+  IsRebuilt = FALSE;
+} /* End of 'trm::shader::Swap' function */
+
 /* Apply shader function.
  * ARGUMENTS: None.
  * RETURNS: 
@@ -245,4 +350,38 @@ VOID trm::shader_manager::Update( VOID )
     s.second.Update();
 } /* End of 'trm::shader_manager::Update' function */
 
+/* Start all shaders rebuild function.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+VOID trm::shader_manager::Start( VOID )
+{
+  for (auto &s : Stock)
+    s.second.Start();
+} /* End of 'trm::shader_manager::Start' function */
+
+/* Swap all rebuilt shaders function.
+ * Programs are swapped together when all of them are linked,
+ * if some one failed all rebuilt programs are deleted.
+ * ARGUMENTS:
+ *   - set to FALSE if some shader failed to build:
+ *       BOOL &IsOk;
+ * RETURNS:
+ *   (BOOL) TRUE if all shaders are finished.
+ */
+BOOL trm::shader_manager::Swap( BOOL &IsOk )
+{
+  for (auto &s : Stock)
+    if (!s.second.IsReady())
+      return FALSE;
+
+  // Every program is checked, so all errors are logged
+  for (auto &s : Stock)
+    if (!s.second.IsLinked())
+      IsOk = FALSE;
+  for (auto &s : Stock)
+    s.second.Swap(IsOk);
+  return TRUE;
+} /* End of 'trm::shader_manager::Swap' function */
+
 /* END OF 'shader.cpp' FILE */
\ No newline at end of file
@@ -8,7 +8,7 @@
   *               Animation module.
   * PROGRAMMER  : Vladislav Biserov.
   *               Maxim Molostov.
-  * LAST UPDATE : 17.11.2022
+  * LAST UPDATE : 31.03.2023
   * NOTE        : None.
   *
   * No part of this file may be changed without agreement of
@@ -34,6 +34,8 @@ namespace trm
     friend class jittering;
   private:
     UINT ProgId;
+    UINT NewProgId = 0;     // Program being rebuilt, swapped in when all shaders are linked
+    BOOL IsRebuilt = FALSE; // Is rebuild started and not finished
 
     /* Load text from file function.
      * ARGUMENTS:
@@ -44,6 +46,22 @@ namespace trm
      */
     std::string LoadTextFile( const std::string &FileName );
 
+    /* Build shader program function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (UINT) Program id with link issued, 0 if it can't be created.
+     */
+    UINT Build( VOID );
+
+    /* Check is shader program built function.
+     * ARGUMENTS:
+     *   - program id:
+     *       UINT Prg;
+     * RETURNS:
+     *   (BOOL) TRUE if program is linked, otherwise it is deleted.
+     */
+    BOOL Check( UINT Prg );
+
     /* Load shader function.
      * ARGUMENTS: None.
      * RETURNS:
@@ -66,6 +84,14 @@ namespace trm
      * RETURNS: None.
      */
     VOID Free( VOID );
+
+    /* Free shader program function.
+     * ARGUMENTS:
+     *   - program id:
+     *       UINT Prg;
+     * RETURNS: None.
+     */
+    VOID Free( UINT Prg );
   public:
     /* Shader name */
     std::string Name;
@@ -93,6 +119,34 @@ namespace trm
      */
     VOID Update( VOID );
 
+    /* Start shader rebuild function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID Start( VOID );
+
+    /* Check is rebuilt shader program compiled function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (BOOL) TRUE if rebuild is compiled or not started, FALSE if it is still compiling.
+     */
+    BOOL IsReady( VOID );
+
+    /* Check is rebuilt shader program linked function.
+     * ARGUMENTS: None.
+     * RETURNS:
+     *   (BOOL) TRUE if rebuilt program is linked or rebuild is not started.
+     */
+    BOOL IsLinked( VOID );
+
+    /* Finish shader rebuild function.
+     * ARGUMENTS:
+     *   - use rebuilt program flag, otherwise it is deleted and old one is kept:
+     *       BOOL IsUse;
+     * RETURNS: None.
+     */
+    VOID Swap( BOOL IsUse );
+
     /* Apply shader function.
      * ARGUMENTS: None.
      * RETURNS:
@@ -155,6 +209,23 @@ namespace trm
      * RETURNS: None.
      */
     VOID Update( VOID );
+
+    /* Start all shaders rebuild function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    VOID Start( VOID );
+
+    /* Swap all rebuilt shaders function.
+     * Programs are swapped together when all of them are linked,
+     * if some one failed all rebuilt programs are deleted.
+     * ARGUMENTS:
+     *   - set to FALSE if some shader failed to build:
+     *       BOOL &IsOk;
+     * RETURNS:
+     *   (BOOL) TRUE if all shaders are finished.
+     */
+    BOOL Swap( BOOL &IsOk );
   };
 } /* end of 'trm' namespace */
 
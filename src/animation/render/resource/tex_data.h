@@ -0,0 +1,37 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+ /* FILE NAME   : tex_data.h
+  * PURPOSE     : Ray marching project.
+  *               Animation module.
+  * PROGRAMMER  : Vladislav Biserov.
+  *               Maxim Molostov.
+  * LAST UPDATE : 31.03.2023
+  * NOTE        : Doesn't depend on OpenGL, it is shared with parser.
+  *
+  * No part of this file may be changed without agreement of
+  * Computer Graphics Support Group of 30 Phys-Math Lyceum
+  */
+
+
+#ifndef __tex_data_h_
+#define __tex_data_h_
+
+/* NSF name space */
+namespace trm
+{
+  class texture;
+
+  /* Structure which save information about texture */
+  struct tex_data
+  {
+    int n;         // Texture sampler number in scene shader
+    texture *Tex;  // Loaded texture, nullptr if it isn't loaded yet
+  }; // End of 'tex_data' struct
+} /* end of 'trm' name space */
+
+#endif /* __tex_data_h_ */
+
+/* END OF 'tex_data.h' FILE */
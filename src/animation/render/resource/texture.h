@@ -8,7 +8,7 @@
   *               Animation module.
   * PROGRAMMER  : Vladislav Biserov.
   *               Maxim Molostov.
-  * LAST UPDATE : 17.11.2022
+  * LAST UPDATE : 31.03.2023
   * NOTE        : None.
   *
   * No part of this file may be changed without agreement of
@@ -24,6 +24,7 @@
 #include "../../../utils/reader.h"
 #include "../../../def.h"
 #include "resource.h"
+#include "tex_data.h"
 
 /* NSF name space */
 namespace trm
@@ -43,12 +44,8 @@ namespace trm
   public:
     std::string Name;
 
-    /* Structure which save information about texture */
-    struct tex_data
-    {
-      INT n;
-      texture *Tex;
-    }; // End of 'tex_data' struct
+    /* Structure which save information about texture (see 'tex_data.h') */
+    using tex_data = trm::tex_data;
 
     /* Constructor */
     texture( VOID ) : Name {}, TexId(0), W(0), H(0)
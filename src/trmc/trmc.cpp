@@ -0,0 +1,344 @@
+/*************************************************************
+ * Copyright (C) 2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : trmc.cpp
+ * PURPOSE     : Ray marching project.
+ *               Offline scene compiler.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 01.04.2023
+ * NOTE        : Usage:
+ *                 trmc [-j threads] [-o out dir] [-c cache dir] [-s template] [-p] [-v] scene|dir...
+ *               Compiled shaders are stored in cache by hash of scene text,
+ *               shader sources and compiler executable, unchanged scenes are copied from it.
+ *               Output shaders keep scene paths relative to current directory.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include "../utils/parser/parser.h"
+
+namespace fs = std::filesystem;
+
+namespace trmc
+{
+  /* Compiler options */
+  struct options
+  {
+    int Threads = 0;                                // Worker threads, 0 for all cores
+    fs::path Out = ".";                             // Output directory
+    fs::path Cache = ".trmc";                       // Cache directory
+    fs::path Template = "bin/shaders/RT/myfrag.glsl"; // Shader template
+    bool IsParams = false;                          // Pass object arguments through 'ParamVal'
+    bool IsVerbose = false;                         // Print parser reports
+  }; /* End of 'options' structure */
+
+  /* Read whole file function.
+   * ARGUMENTS:
+   *   - file name:
+   *       const fs::path &Name;
+   * RETURNS: (std::string) file contents.
+   */
+  static std::string Read(const fs::path &Name)
+  {
+    std::ifstream F(Name, std::ios::binary);
+
+    if (!F.is_open())
+      throw std::runtime_error("can't read " + Name.string());
+
+    std::stringstream str;
+
+    str << F.rdbuf();
+    return str.str();
+  } /* End of 'Read' function */
+
+  /* Get compiler executable file name function.
+   * ARGUMENTS:
+   *   - program name from command line:
+   *       const char *Arg0;
+   * RETURNS: (fs::path) executable file name.
+   */
+  static fs::path Self(const char *Arg0)
+  {
+#ifdef _WIN32
+    char buf[MAX_PATH];
+
+    if (GetModuleFileNameA(nullptr, buf, MAX_PATH) != 0)
+      return buf;
+#else
+    std::error_code err;
+    fs::path res = fs::read_symlink("/proc/self/exe", err);
+
+    if (!err)
+      return res;
+#endif
+    return Arg0;
+  } /* End of 'Self' function */
+
+  /* Get scene files function.
+   * ARGUMENTS:
+   *   - scene files and directories:
+   *       const std::vector<std::string> &Args;
+   * RETURNS: (std::vector<fs::path>) scene files, directories are expanded to '.scene' files in them.
+   */
+  static std::vector<fs::path> Scenes(const std::vector<std::string> &Args)
+  {
+    std::vector<fs::path> res;
+    std::set<fs::path> seen;
+
+    for (auto &a : Args)
+    {
+      std::vector<fs::path> dir;
+
+      if (fs::is_directory(a))
+      {
+        for (auto &e : fs::directory_iterator(a))
+          if (e.is_regular_file() && e.path().extension() == ".scene")
+            dir.push_back(e.path());
+        std::sort(dir.begin(), dir.end());
+      }
+      else
+        dir.push_back(a);
+      // Scene given twice would be written by two threads at once
+      for (auto &s : dir)
+        if (seen.insert(fs::weakly_canonical(s)).second)
+          res.push_back(s);
+    }
+    return res;
+  } /* End of 'Scenes' function */
+
+  /* Get output shader file name function.
+   * ARGUMENTS:
+   *   - output directory:
+   *       const fs::path &Out;
+   *   - scene file name:
+   *       const fs::path &Scene;
+   * RETURNS: (fs::path) shader file name, it keeps scene path relative to current
+   *          directory (or absolute path without root), so scenes with the same name
+   *          from different directories don't overwrite each other.
+   */
+  static fs::path Output(const fs::path &Out, const fs::path &Scene)
+  {
+    fs::path
+      abs = fs::weakly_canonical(Scene),
+      rel = abs.lexically_relative(fs::current_path());
+
+    if (rel.empty() || *rel.begin() == "..")
+      rel = abs.relative_path();
+    return Out / rel.replace_extension(".glsl");
+  } /* End of 'Output' function */
+
+  /* Batch compilation class */
+  class batch
+  {
+  private:
+    const options &Opt;
+    std::vector<fs::path> Files;
+    uint64_t Base;                            // Hash of compiler, template and options
+    std::atomic<size_t> Next = 0;             // Next scene to compile
+    std::atomic<int> Compiled = 0, Cached = 0, Failed = 0;
+    std::mutex Print;                         // Output lines guard
+
+    /* Print line function.
+     * ARGUMENTS:
+     *   - stream:
+     *       std::ostream &Out;
+     *   - line text:
+     *       const std::string &Line;
+     * RETURNS: None.
+     */
+    void Say(std::ostream &Out, const std::string &Line)
+    {
+      std::lock_guard<std::mutex> guard(Print);
+
+      Out << Line << std::endl;
+    } /* End of 'Say' function */
+
+    /* Compile one scene function.
+     * ARGUMENTS:
+     *   - scene file name:
+     *       const fs::path &Scene;
+     * RETURNS: None.
+     */
+    void One(const fs::path &Scene)
+    {
+      auto start = std::chrono::steady_clock::now();
+      fs::path out = Output(Opt.Out, Scene);
+      char name[17];
+
+      std::snprintf(name, sizeof(name), "%016llx", (unsigned long long)parser::pack::Hash(Base, Read(Scene)));
+
+      fs::path cached = Opt.Cache / (std::string(name) + ".glsl");
+      const char *how = "cached";
+
+      fs::create_directories(out.parent_path());
+      if (fs::exists(cached))
+      {
+        fs::copy_file(cached, out, fs::copy_options::overwrite_existing);
+        Cached++;
+      }
+      else
+      {
+        std::map<std::string, trm::tex_data> tex;
+        std::ostringstream tmp;
+        parser::compile_context ctx;
+
+        ctx.IsParams = Opt.IsParams;
+        ctx.IsConvert = false;
+
+        // Other processes may share cache, entry appears at once
+        tmp << name << '.' << std::this_thread::get_id() << ".tmp";
+        parser::Parse(Scene.string(), Opt.Template.string(), (Opt.Cache / tmp.str()).string(), tex, ctx);
+        if (Opt.IsVerbose)
+          Say(std::cout, ctx.Report);
+        if (ctx.Overflow > 0)
+          Say(std::cerr, std::format("{}: warning: {} values don't fit into 'FrameVal' or 'ParamVal', they are kept in shader text",
+            Scene.string(), ctx.Overflow));
+        fs::copy_file(Opt.Cache / tmp.str(), out, fs::copy_options::overwrite_existing);
+        fs::rename(Opt.Cache / tmp.str(), cached);
+        Compiled++;
+        how = "compiled";
+      }
+      Say(std::cout, std::format("{} -> {} ({}, {:.1f} ms)", Scene.string(), out.string(), how,
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()));
+    } /* End of 'One' function */
+
+    /* Worker thread function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    void Work(void)
+    {
+      for (size_t i; (i = Next++) < Files.size(); )
+        try
+        {
+          One(Files[i]);
+        }
+        catch (std::exception &E)
+        {
+          Failed++;
+          Say(std::cerr, Files[i].string() + ": error: " + E.what());
+        }
+    } /* End of 'Work' function */
+
+  public:
+    /* Batch constructor.
+     * ARGUMENTS:
+     *   - options:
+     *       const options &Opt;
+     *   - scene files:
+     *       std::vector<fs::path> &&Files;
+     *   - compiler executable file name:
+     *       const fs::path &Exe;
+     */
+    batch(const options &Opt, std::vector<fs::path> &&Files, const fs::path &Exe) : Opt(Opt), Files(std::move(Files))
+    {
+      Base = parser::pack::Hash(parser::pack::Basis, parser::Version);
+      Base = parser::pack::Hash(Base, Read(Exe));
+      Base = parser::pack::Template(Base, Opt.Template.string());
+      Base = parser::pack::Hash(Base, Opt.IsParams ? "params" : "values");
+    } /* End of 'batch' constructor */
+
+    /* Compile all scenes function.
+     * ARGUMENTS: None.
+     * RETURNS: (int) number of failed scenes.
+     */
+    int Run(void)
+    {
+      auto start = std::chrono::steady_clock::now();
+      int n = Opt.Threads > 0 ? Opt.Threads : std::max(1, (int)std::thread::hardware_concurrency());
+      std::vector<std::thread> th;
+
+      fs::create_directories(Opt.Out);
+      fs::create_directories(Opt.Cache);
+      n = std::min(n, std::max(1, (int)Files.size()));
+      for (int i = 0; i < n; i++)
+        th.emplace_back(&batch::Work, this);
+      for (auto &t : th)
+        t.join();
+      Say(std::cout, std::format("{} scenes: {} compiled, {} cached, {} failed, {} threads, {:.1f} ms", Files.size(),
+        Compiled.load(), Cached.load(), Failed.load(), n,
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()));
+      return Failed;
+    } /* End of 'Run' function */
+  }; /* End of 'batch' class */
+} /* end of 'trmc' namespace */
+
+/* The main program function.
+ * ARGUMENTS:
+ *   - command line arguments count:
+ *       int argc;
+ *   - command line arguments:
+ *       char *argv[];
+ * RETURNS:
+ *   (int) Error level for operation system (0 for success).
+ */
+int main(int argc, char *argv[])
+{
+  trmc::options opt;
+  std::vector<std::string> args;
+  bool is_usage = false;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string a = argv[i];
+
+    if ((a == "-j" || a == "-o" || a == "-c" || a == "-s") && i + 1 < argc)
+    {
+      std::string v = argv[++i];
+
+      if (a == "-j")
+        opt.Threads = std::atoi(v.c_str());
+      else if (a == "-o")
+        opt.Out = v;
+      else if (a == "-c")
+        opt.Cache = v;
+      else
+        opt.Template = v;
+    }
+    else if (a == "-p")
+      opt.IsParams = true;
+    else if (a == "-v")
+      opt.IsVerbose = true;
+    else if (!a.empty() && a[0] == '-')
+      is_usage = true;
+    else
+      args.push_back(a);
+  }
+  if (is_usage || args.empty())
+  {
+    std::cerr << "usage: trmc [-j threads] [-o out dir] [-c cache dir] [-s template] [-p] [-v] scene|dir...\n"
+      "  -p  pass object arguments through 'ParamVal' (as application does)\n"
+      "  -v  print parser reports\n";
+    return 2;
+  }
+  try
+  {
+    trmc::batch C(opt, trmc::Scenes(args), trmc::Self(argv[0]));
+
+    return C.Run() == 0 ? 0 : 1;
+  }
+  catch (std::exception &E)
+  {
+    std::cerr << "error: " << E.what() << "\n";
+    return 2;
+  }
+} /* End of 'main' function */
+
+/* END OF 'trmc.cpp' FILE */
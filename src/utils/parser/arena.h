@@ -0,0 +1,206 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+ /* FILE NAME   : arena.h
+  * PURPOSE     : Ray marching project.
+  *               Parser module.
+  * PROGRAMMER  : Vladislav Biserov.
+  * LAST UPDATE : 30.03.2023
+  * NOTE        : None.
+  *
+  * No part of this file may be changed without agreement of
+  * Computer Graphics Support Group of 30 Phys-Math Lyceum
+  */
+
+#ifndef __arena_h_
+#define __arena_h_
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace parser
+{
+  /* Bump allocation arena class.
+   * Owns all syntax tree nodes and strings of one compilation,
+   * everything is released at once by 'Reset'.
+   */
+  class arena
+  {
+  private:
+    /* Destructor record structure */
+    struct finalizer
+    {
+      void (*Destroy)(void *); // Object destructor call
+      void *Object;            // Object pointer
+      finalizer *Next;         // Previous record
+    }; /* End of 'finalizer' structure */
+
+    static constexpr size_t BlockSize = 64 * 1024;
+
+    std::vector<char *> Blocks;   // Allocated memory blocks
+    std::vector<char *> Large;    // Allocations not fitting to block
+    char *Cur = nullptr;          // Current block free space start
+    char *End = nullptr;          // Current block end
+    size_t Used = 0;              // Index of current block
+    finalizer *Finalizers = nullptr;
+    size_t Count = 0;             // Number of allocations since reset
+    size_t Bytes = 0;             // Bytes requested since reset
+
+    /* Get next block function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    void Grow(void)
+    {
+      // Reuse blocks which are left after reset
+      if (Cur == nullptr || Used + 1 >= Blocks.size())
+      {
+        Blocks.push_back(new char[BlockSize]);
+        Used = Blocks.size() - 1;
+      }
+      else
+        Used++;
+      Cur = Blocks[Used];
+      End = Cur + BlockSize;
+    } /* End of 'Grow' function */
+
+  public:
+    arena(void)
+    {
+    }
+
+    arena(const arena &) = delete;
+    arena & operator=(const arena &) = delete;
+
+    ~arena()
+    {
+      Reset();
+      for (auto b : Blocks)
+        delete[] b;
+      Blocks.clear();
+    }
+
+    /* Allocate raw memory function.
+     * ARGUMENTS:
+     *   - size and alignment in bytes:
+     *       size_t Size, Align;
+     * RETURNS: (void *) allocated memory.
+     */
+    void * Alloc(size_t Size, size_t Align = alignof(std::max_align_t))
+    {
+      Count++;
+      Bytes += Size;
+      if (Size + Align > BlockSize / 4)
+      {
+        Large.push_back(new char[Size + Align]);
+
+        char *p = Large.back();
+
+        return p + (Align - (size_t)p % Align) % Align;
+      }
+
+      size_t pad = (Align - (size_t)Cur % Align) % Align;
+
+      if (Cur == nullptr || Cur + pad + Size > End)
+      {
+        Grow();
+        pad = (Align - (size_t)Cur % Align) % Align;
+      }
+
+      void *p = Cur + pad;
+
+      Cur += pad + Size;
+      return p;
+    } /* End of 'Alloc' function */
+
+    /* Create object in arena function.
+     * ARGUMENTS:
+     *   - constructor arguments:
+     *       args_type &&...Args;
+     * RETURNS: (type *) created object.
+     */
+    template<typename type, typename ...args_type>
+      type * New(args_type &&...Args)
+      {
+        type *obj = new (Alloc(sizeof(type), alignof(type))) type(std::forward<args_type>(Args)...);
+
+        if constexpr (!std::is_trivially_destructible_v<type>)
+        {
+          finalizer *f = new (Alloc(sizeof(finalizer), alignof(finalizer))) finalizer;
+
+          f->Destroy = [](void *Obj) { static_cast<type *>(Obj)->~type(); };
+          f->Object = obj;
+          f->Next = Finalizers;
+          Finalizers = f;
+        }
+        return obj;
+      } /* End of 'New' function */
+
+    /* Copy string to arena function.
+     * ARGUMENTS:
+     *   - string to copy:
+     *       std::string_view Str;
+     * RETURNS: (std::string_view) arena owned copy.
+     */
+    std::string_view Str(std::string_view Str)
+    {
+      if (Str.empty())
+        return {};
+
+      char *p = (char *)Alloc(Str.size(), 1);
+
+      memcpy(p, Str.data(), Str.size());
+      return std::string_view(p, Str.size());
+    } /* End of 'Str' function */
+
+    /* Release all arena objects function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    void Reset(void)
+    {
+      for (finalizer *f = Finalizers; f != nullptr; f = f->Next)
+        f->Destroy(f->Object);
+      Finalizers = nullptr;
+
+      // Keep standard blocks for the next compilation
+      for (auto b : Large)
+        delete[] b;
+      Large.clear();
+      Used = 0;
+      Cur = Blocks.empty() ? nullptr : Blocks[0];
+      End = Cur == nullptr ? nullptr : Cur + BlockSize;
+      Count = 0;
+      Bytes = 0;
+    } /* End of 'Reset' function */
+
+    /* Get number of allocations function.
+     * ARGUMENTS: None.
+     * RETURNS: (size_t) number of allocations since last reset.
+     */
+    size_t GetCount(void) const
+    {
+      return Count;
+    } /* End of 'GetCount' function */
+
+    /* Get allocated size function.
+     * ARGUMENTS: None.
+     * RETURNS: (size_t) bytes requested since last reset.
+     */
+    size_t GetSize(void) const
+    {
+      return Bytes;
+    } /* End of 'GetSize' function */
+  }; /* End of 'arena' class */
+}
+
+#endif
+
+/* END OF 'arena.h' FILE */
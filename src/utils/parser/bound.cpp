@@ -0,0 +1,873 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : bound.cpp
+ * PURPOSE     : Ray marching project.
+ *               Parser module.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 02.04.2023
+ * NOTE        : None.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include <algorithm>
+
+#include "bound.h"
+#include "chain.h"
+#include "expr.h"
+#include "func.h"
+#include "loop.h"
+
+thread_local std::vector<parser::bounds::shape> parser::bounds::Shapes;
+thread_local std::vector<std::vector<double>> parser::bounds::Vars;
+thread_local std::vector<std::pair<int, int>> parser::bounds::Uses;
+thread_local std::vector<bool> parser::bounds::IsUnsafe;
+thread_local std::vector<std::tuple<int, int, bool>> parser::bounds::Parts;
+thread_local std::vector<int> parser::bounds::Signs;
+thread_local std::vector<int> parser::bounds::Frame;
+thread_local parser::bounds::sphere parser::bounds::Scene;
+thread_local bool parser::bounds::IsAdded = false;
+thread_local int
+  parser::bounds::Guarded = 0,
+  parser::bounds::Lods = 0,
+  parser::bounds::Total = 0;
+thread_local std::vector<parser::bounds::sphere> parser::bounds::Results;
+thread_local bool parser::bounds::IsStretched = false;
+thread_local std::vector<parser::bounds::span> parser::bounds::Spans;
+thread_local bool parser::bounds::IsSpan = false;
+
+/* Reset bounds function.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+void parser::bounds::Clear( void )
+{
+  Shapes.clear();
+  Vars.clear();
+  Uses.clear();
+  IsUnsafe.clear();
+  Parts.clear();
+  Signs.clear();
+  Frame.clear();
+  Scene = {};
+  IsAdded = false;
+  Guarded = Lods = Total = 0;
+  Results.clear();
+  IsStretched = false;
+  Spans.clear();
+  IsSpan = false;
+} /* End of 'parser::bounds::Clear' function */
+
+/* Get shape variable by symbol id function.
+ * ARGUMENTS:
+ *   - symbol id:
+ *       int Id;
+ * RETURNS: (shape &) shape variable.
+ */
+parser::bounds::shape & parser::bounds::At( int Id )
+{
+  if (Id >= (int)Shapes.size())
+    Shapes.resize(Id + 1);
+  return Shapes[Id];
+} /* End of 'parser::bounds::At' function */
+
+/* Read function arguments values function.
+ * ARGUMENTS:
+ *   - arguments:
+ *       std::vector<arg> &Args;
+ *   - arguments types:
+ *       const std::vector<param::type> &Types;
+ *   - numbers and vectors values, materials and textures are skipped (out):
+ *       std::vector<double> &Vals;
+ * RETURNS: (bool) are all values known on compile time.
+ */
+bool parser::bounds::Read( std::vector<arg> &Args, const std::vector<param::type> &Types, std::vector<double> &Vals )
+{
+  for (size_t i = 0; i < Args.size(); i++)
+  {
+    if (Types[i] != param::type::eNum && Types[i] != param::type::eVec)
+      continue;
+
+    double v[3];
+    int n = Args[i].Value != nullptr ? Args[i].Value->Values(v) : 0;
+
+    if (n != (Types[i] == param::type::eVec ? 3 : 1))
+      return false;
+    Vals.insert(Vals.end(), v, v + n);
+  }
+  return true;
+} /* End of 'parser::bounds::Read' function */
+
+/* Get sphere enclosing two spheres function.
+ * ARGUMENTS:
+ *   - bounded spheres:
+ *       const sphere &A, &B;
+ * RETURNS: (sphere) enclosing sphere.
+ */
+parser::bounds::sphere parser::bounds::Enclose( const sphere &A, const sphere &B )
+{
+  double d[3] {B.C[0] - A.C[0], B.C[1] - A.C[1], B.C[2] - A.C[2]}, len = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+
+  if (len + B.R <= A.R)
+    return A;
+  if (len + A.R <= B.R)
+    return B;
+
+  sphere res;
+
+  res.R = (len + A.R + B.R) / 2;
+  for (int i = 0; i < 3; i++)
+    res.C[i] = A.C[i] + d[i] * (res.R - A.R) / len;
+  return res;
+} /* End of 'parser::bounds::Enclose' function */
+
+/* Place last primitive of shape to world function.
+ * ARGUMENTS:
+ *   - shape variable:
+ *       shape &S;
+ * RETURNS: None.
+ */
+void parser::bounds::Place( shape &S )
+{
+  S.Val = {};
+  S.In = {};
+  if (!S.IsMod || S.Prim.R < 0)
+    return;
+
+  // Square of W norm doesn't exceed any norm of W^T * W, maximal row sum is taken
+  double norm = 0;
+
+  for (int r = 0; r < 3; r++)
+  {
+    double sum = 0;
+
+    for (int c = 0; c < 3; c++)
+      sum += fabs(S.W[0][r] * S.W[0][c] + S.W[1][r] * S.W[1][c] + S.W[2][r] * S.W[2][c]);
+    norm = std::max(norm, sum);
+  }
+
+  sphere res;
+
+  res.R = S.Prim.R * sqrt(norm);
+  for (int r = 0; r < 3; r++)
+  {
+    res.C[r] = S.w[r];
+    for (int c = 0; c < 3; c++)
+      res.C[r] += S.W[r][c] * S.Prim.C[c];
+  }
+  if (norm > 0 && isfinite(res.R) && isfinite(res.C[0]) && isfinite(res.C[1]) && isfinite(res.C[2]))
+  {
+    S.Val = res;
+    S.Inv = 1 / sqrt(norm);
+  }
+
+  // Inner sphere is kept by rotations and translations only
+  bool is_rigid = S.Val.R >= 0 && S.PrimIn.R >= 0;
+
+  for (int r = 0; r < 3 && is_rigid; r++)
+    for (int c = 0; c < 3; c++)
+      if (fabs(S.W[0][r] * S.W[0][c] + S.W[1][r] * S.W[1][c] + S.W[2][r] * S.W[2][c] - (r == c)) > 1e-6)
+        is_rigid = false;
+  if (is_rigid)
+  {
+    S.In.R = S.PrimIn.R;
+    for (int r = 0; r < 3; r++)
+    {
+      S.In.C[r] = S.w[r];
+      for (int c = 0; c < 3; c++)
+        S.In.C[r] += S.W[r][c] * S.PrimIn.C[c];
+    }
+  }
+  // Function returns distance of stretched shape in its primitive space, not in function point space
+  if (functions::IsBody() && fabs(norm - 1) > 1e-6)
+    IsStretched = true;
+} /* End of 'parser::bounds::Place' function */
+
+/* Write bound number function.
+ * ARGUMENTS:
+ *   - buffer to append text to:
+ *       std::string &Out;
+ *   - value:
+ *       double Val;
+ *   - frame slot, -1 to write literal:
+ *       int Slot;
+ * RETURNS: None.
+ */
+void parser::bounds::Number( std::string &Out, double Val, int Slot )
+{
+  if (Slot >= 0)
+    Out += uniforms::Name(Slot);
+  else
+    expr::Literal(Out, Val);
+} /* End of 'parser::bounds::Number' function */
+
+/* Record operation operands function, called by folding pass.
+ * ARGUMENTS:
+ *   - result shape variable symbol id:
+ *       int Var;
+ *   - operation type:
+ *       obj::oper::type Type;
+ *   - operands shape names:
+ *       const std::string &P1, &P2;
+ * RETURNS: None.
+ */
+void parser::bounds::Use( int Var, obj::oper::type Type, const std::string &P1, const std::string &P2 )
+{
+  int
+    res = Type == obj::oper::type::eUnion ? Var : -1,
+    a = symbols::Find(P1),
+    b = symbols::Find(P2);
+
+  for (int id : {a, b})
+    if (id >= 0)
+      Uses.push_back({id, res});
+  // Second operand of difference is subtracted, operations are monotonic by other operands
+  if (a >= 0)
+    Parts.push_back({a, Var, false});
+  if (b >= 0)
+    Parts.push_back({b, Var, Type == obj::oper::type::eDiff || Type == obj::oper::type::eDiffSmth});
+} /* End of 'parser::bounds::Use' function */
+
+/* Find shapes which can't be guarded or replaced by bounds function.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+void parser::bounds::Begin( void )
+{
+  std::sort(Uses.begin(), Uses.end());
+  Uses.erase(std::unique(Uses.begin(), Uses.end()), Uses.end());
+
+  int n = 0;
+
+  for (auto &u : Uses)
+    n = std::max({n, u.first + 1, u.second + 1});
+  IsUnsafe.assign(n, false);
+
+  // Operand of union is as safe as union result
+  bool is_changed = true;
+
+  while (is_changed)
+  {
+    is_changed = false;
+    for (auto &u : Uses)
+      if (!IsUnsafe[u.first] && (u.second < 0 || IsUnsafe[u.second]))
+        IsUnsafe[u.first] = is_changed = true;
+  }
+
+  // Shapes which aren't operands of other shapes are added to scene,
+  // sign of operand is sign of result, reversed for subtracted one
+  std::vector<bool> is_part;
+
+  n = 0;
+  for (auto &[a, r, is_sub] : Parts)
+    n = std::max({n, a + 1, r + 1});
+  Signs.assign(n, 0);
+  is_part.assign(n, false);
+  for (auto &[a, r, is_sub] : Parts)
+    if (a != r)
+      is_part[a] = true;
+  for (int i = 0; i < n; i++)
+    if (!is_part[i])
+      Signs[i] = 1;
+
+  is_changed = true;
+  while (is_changed)
+  {
+    is_changed = false;
+    for (auto &[a, r, is_sub] : Parts)
+    {
+      if (Signs[r] == 0)
+        continue;
+
+      int
+        s = Signs[r] == 2 || !is_sub ? Signs[r] : -Signs[r],
+        m = Signs[a] == 0 || Signs[a] == s ? s : 2;
+
+      if (m != Signs[a])
+      {
+        Signs[a] = m;
+        is_changed = true;
+      }
+    }
+  }
+} /* End of 'parser::bounds::Begin' function */
+
+/* Get vector variable values function.
+ * ARGUMENTS:
+ *   - symbol id:
+ *       int Id;
+ *   - values (out):
+ *       double *Vals;
+ * RETURNS: (int) number of values, 0 if variable value isn't known.
+ */
+int parser::bounds::GetVar( int Id, double *Vals )
+{
+  if (Id >= (int)Vars.size())
+    return 0;
+  std::copy(Vars[Id].begin(), Vars[Id].end(), Vals);
+  return (int)Vars[Id].size();
+} /* End of 'parser::bounds::GetVar' function */
+
+/* Set vector variable function.
+ * ARGUMENTS:
+ *   - symbol id:
+ *       int Id;
+ *   - assigned expression:
+ *       expr *E;
+ * RETURNS: None.
+ */
+void parser::bounds::SetVar( int Id, expr *E )
+{
+  double v[3];
+  int n = E->Values(v);
+
+  if (Id >= (int)Vars.size())
+    Vars.resize(Id + 1);
+  Vars[Id].assign(v, v + n);
+} /* End of 'parser::bounds::SetVar' function */
+
+/* Record shape function.
+ * ARGUMENTS:
+ *   - shape variable symbol id:
+ *       int Var;
+ *   - shape type:
+ *       obj::shape::type Type;
+ *   - arguments:
+ *       std::vector<arg> &Args;
+ * RETURNS: None.
+ */
+void parser::bounds::Shape( int Var, obj::shape::type Type, std::vector<arg> &Args )
+{
+  shape &s = At(Var);
+  std::vector<double> v;
+
+  // Planes and water are unbounded
+  s.Prim = {};
+  s.PrimIn = {};
+  if (Type != obj::shape::type::ePlane && Type != obj::shape::type::eWater && Read(Args, obj::shape::Types.at(Type), v))
+  {
+    double half = 0;
+
+    if (Type == obj::shape::type::eCylinder || Type == obj::shape::type::eCapsule)
+    {
+      // Segment ends are the first vector and the vector after radius for cylinder
+      int e = Type == obj::shape::type::eCylinder ? 4 : 3;
+
+      for (int i = 0; i < 3; i++)
+      {
+        s.Prim.C[i] = (v[i] + v[e + i]) / 2;
+        half += (v[e + i] - v[i]) * (v[e + i] - v[i]);
+      }
+      half = sqrt(half) / 2;
+    }
+    else
+      std::copy(v.begin(), v.begin() + 3, s.Prim.C);
+
+    switch (Type)
+    {
+    case obj::shape::type::eSphere:
+      s.Prim.R = fabs(v[3]);
+      s.PrimIn = s.Prim;
+      break;
+    case obj::shape::type::eBox:
+      s.Prim.R = sqrt(v[3] * v[3] + v[4] * v[4] + v[5] * v[5]);
+      s.PrimIn = {{s.Prim.C[0], s.Prim.C[1], s.Prim.C[2]}, std::min({fabs(v[3]), fabs(v[4]), fabs(v[5])})};
+      break;
+    case obj::shape::type::eEllipsoid:
+      s.Prim.R = std::max({fabs(v[3]), fabs(v[4]), fabs(v[5])});
+      break;
+    case obj::shape::type::eTorus:
+      s.Prim.R = fabs(v[6]) + fabs(v[7]);
+      break;
+    case obj::shape::type::eCylinder:
+      s.Prim.R = half + std::max(fabs(v[3]), fabs(v[7]));
+      break;
+    case obj::shape::type::eCapsule:
+      s.Prim.R = half + fabs(v[6]);
+      s.PrimIn = {{s.Prim.C[0], s.Prim.C[1], s.Prim.C[2]}, fabs(v[6])};
+      break;
+    default:
+      break;
+    }
+  }
+  Place(s);
+  Span(Var);
+} /* End of 'parser::bounds::Shape' function */
+
+/* Enclose current shape bound to loop iterations bound function.
+ * ARGUMENTS:
+ *   - shape variable symbol id:
+ *       int Var;
+ * RETURNS: None.
+ */
+void parser::bounds::Span( int Var )
+{
+  if (!IsSpan)
+    return;
+  if (Var >= (int)Spans.size())
+    Spans.resize(Var + 1);
+
+  const shape &s = At(Var);
+  span &sp = Spans[Var];
+
+  // Guard distance is measured in world space, stretched shapes are never guarded in loop
+  if (sp.Val.R == -1)
+    return;
+  if (s.Val.R < 0 || fabs(s.Inv - 1) > 1e-6)
+  {
+    sp.Val = {};
+    return;
+  }
+  sp.Val = sp.Val.R == -2 ? s.Val : Enclose(sp.Val, s.Val);
+  sp.Prim = std::max(sp.Prim, s.Prim.R);
+  for (int r = 0; r < 3; r++)
+  {
+    sp.IsPlaced &= s.w[r] == 0;
+    for (int c = 0; c < 3; c++)
+      sp.IsPlaced &= s.W[r][c] == (r == c);
+  }
+} /* End of 'parser::bounds::Span' function */
+
+/* Record shape modification function.
+ * ARGUMENTS:
+ *   - shape variable symbol id:
+ *       int Var;
+ *   - modification type:
+ *       obj::mod::type Type;
+ *   - arguments:
+ *       std::vector<arg> &Args;
+ * RETURNS: None.
+ */
+void parser::bounds::Mod( int Var, obj::mod::type Type, std::vector<arg> &Args )
+{
+  shape &s = At(Var);
+  std::vector<double> v;
+
+  // Instances of repeated or mirrored shape are spread over space
+  if (!s.IsMod || Type == obj::mod::type::eRepeat || Type == obj::mod::type::eMirror ||
+      !Read(Args, obj::mod::Types.at(Type), v))
+    s.IsMod = false;
+  else
+  {
+    // Inverse of modification: previous point is f * p + g
+    double f[3][3] {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}, g[3] {};
+
+    if (Type == obj::mod::type::eTranslate)
+      for (int r = 0; r < 3; r++)
+        g[r] = -v[r];
+    else if (Type == obj::mod::type::eScale)
+      for (int r = 0; r < 3; r++)
+        f[r][r] = v[r];
+    else
+    {
+      // 'Rotate' applies inverse of 'MatrRotate' matrix, so its inverse is the matrix itself
+      double
+        a = v[0] * 3.14159 / 180, sn = sin(a), cs = cos(a),
+        x = v[1], y = v[2], z = v[3],
+        q[3][3]
+        {
+          {cs + x * x * (1 - cs), y * x * (1 - cs) - z * sn, z * x * (1 - cs) + y * sn},
+          {x * y * (1 - cs) + z * sn, cs + y * y * (1 - cs), z * y * (1 - cs) - x * sn},
+          {x * z * (1 - cs) - y * sn, y * z * (1 - cs) + x * sn, cs + z * z * (1 - cs)},
+        };
+
+      std::copy(&q[0][0], &q[0][0] + 9, &f[0][0]);
+    }
+
+    double W[3][3], w[3];
+
+    for (int r = 0; r < 3; r++)
+    {
+      w[r] = s.w[r];
+      for (int c = 0; c < 3; c++)
+      {
+        W[r][c] = 0;
+        for (int k = 0; k < 3; k++)
+          W[r][c] += s.W[r][k] * f[k][c];
+        w[r] += s.W[r][c] * g[c];
+      }
+    }
+    std::copy(&W[0][0], &W[0][0] + 9, &s.W[0][0]);
+    std::copy(w, w + 3, s.w);
+  }
+
+  // Modification prints last primitive again
+  Place(s);
+  Span(Var);
+} /* End of 'parser::bounds::Mod' function */
+
+/* Record operation function.
+ * ARGUMENTS:
+ *   - result shape variable symbol id:
+ *       int Var;
+ *   - operation type:
+ *       obj::oper::type Type;
+ *   - operands shape names:
+ *       const std::string &P1, &P2;
+ *   - smoothness coefficient, nullptr if there isn't one:
+ *       expr *K;
+ * RETURNS: None.
+ */
+void parser::bounds::Oper( int Var, obj::oper::type Type, const std::string &P1, const std::string &P2, expr *K )
+{
+  sphere
+    a = At(symbols::Find(P1)).Val,
+    b = At(symbols::Find(P2)).Val,
+    ia = At(symbols::Find(P1)).In,
+    ib = At(symbols::Find(P2)).In,
+    res;
+  double k[3] {};
+  shape &s = At(Var);
+
+  s.In = {};
+  switch (Type)
+  {
+  case obj::oper::type::eUnion:
+  case obj::oper::type::eUnionSmth:
+    // Smooth union is below plain one by k / 4 at most
+    if (a.R >= 0 && b.R >= 0 && (K == nullptr || K->Values(k) == 1))
+    {
+      res = Enclose(a, b);
+      res.R += fabs(k[0]) / 4;
+      // Union contains both operands
+      s.In = ia.R >= ib.R ? ia : ib;
+    }
+    break;
+  case obj::oper::type::eDiff:
+  case obj::oper::type::eDiffSmth:
+    // Smooth maximum isn't below plain one, difference is inside first operand
+    res = a;
+    break;
+  default:
+    res = a.R < 0 || (b.R >= 0 && b.R < a.R) ? b : a;
+    break;
+  }
+  s.Val = res;
+} /* End of 'parser::bounds::Oper' function */
+
+/* Add shape to scene function.
+ * ARGUMENTS:
+ *   - shape variable symbol id:
+ *       int Var;
+ * RETURNS: None.
+ */
+void parser::bounds::Add( int Var )
+{
+  sphere v = At(Var).Val;
+
+  if (!IsAdded)
+    Scene = v;
+  else if (Scene.R >= 0)
+    Scene = v.R < 0 ? sphere() : Enclose(Scene, v);
+  IsAdded = true;
+} /* End of 'parser::bounds::Add' function */
+
+/* Start or finish collecting loop iterations bounds function.
+ * ARGUMENTS:
+ *   - is loop started:
+ *       bool IsStart;
+ * RETURNS: None.
+ */
+void parser::bounds::Loop( bool IsStart )
+{
+  if (IsStart)
+    Spans.clear();
+  IsSpan = IsStart;
+} /* End of 'parser::bounds::Loop' function */
+
+/* Finish scene bounds function, called while frame uniforms are collected.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+void parser::bounds::End( void )
+{
+  float b[4];
+
+  Frame.clear();
+  if (!GetScene(b))
+    return;
+
+  // Scene bound goes to frame block with other object arguments in parameters mode
+  bool old = uniforms::SetArgs(true);
+
+  if (uniforms::IsParam())
+    for (int i = 0; i < 4; i++)
+    {
+      int slot = uniforms::Param(b[i]);
+
+      if (slot < 0)
+      {
+        Frame.clear();
+        break;
+      }
+      Frame.push_back(slot);
+    }
+  uniforms::SetArgs(old);
+} /* End of 'parser::bounds::End' function */
+
+/* Wrap shape evaluation with bound test and level of detail function.
+ * Names evaluation reads and assigns are recorded to current chunk.
+ * ARGUMENTS:
+ *   - shape variable symbol id:
+ *       int Var;
+ *   - shape evaluation GLSL text:
+ *       const std::string &Text;
+ *   - primitive center GLSL text, empty if it isn't first argument:
+ *       const std::string &Center;
+ * RETURNS: (std::string) GLSL text.
+ */
+std::string parser::bounds::Guard( int Var, const std::string &Text, const std::string &Center )
+{
+  const shape &sh = At(Var);
+  sphere s = sh.Val;
+  double
+    inv = sh.Inv,
+    prim = sh.Prim.R;
+  std::string center;
+  int
+    dist = file::Name(Var),
+    mtl = file::Name(Var, file::facet::eMtl);
+  // Material of primitive is assigned by its own chunk, function call assigns it with distance
+  bool is_mtl = variables::GetShapeMtl(Var).Text.empty();
+  // Material of skipped evaluation is never read: shape is farther than scene or
+  // is taken by its bound in 'SceneDist', so earlier evaluations don't reach it
+  auto eval = [&](bool IsPart)
+  {
+    file::Use(file::Name(Var, file::facet::eMod));
+    file::Set(dist, IsPart);
+    if (is_mtl)
+      file::Set(mtl);
+  };
+
+  // Scene distance isn't known in function body
+  if (functions::IsBody())
+  {
+    eval(false);
+    return Text;
+  }
+  Total++;
+
+  // GLSL loop body is the same for all iterations, bound encloses all of them
+  if (loops::IsSymbolic())
+  {
+    bool is_span = Var < (int)Spans.size() && Spans[Var].Val.R >= 0 && chains::GetFactor(Var) == 1;
+
+    s = is_span ? Spans[Var].Val : sphere();
+    inv = 1;
+    prim = s.R;
+    if (is_span && Spans[Var].IsPlaced && !Center.empty())
+    {
+      center = Center;
+      prim = s.R = Spans[Var].Prim;
+    }
+  }
+
+  // Scene distance isn't set before first addition
+  bool
+    is_guard = !variables::IsFirst && (Var >= (int)IsUnsafe.size() || !IsUnsafe[Var]),
+    is_lod = Var >= (int)Signs.size() || Signs[Var] == 1;
+
+  if (s.R < 0 || (!is_guard && !is_lod))
+  {
+    eval(false);
+    return Text;
+  }
+  file::Set(dist);
+  file::Use(dist);
+  if (is_guard)
+    file::Use(file::Res);
+  eval(true);
+  Guarded += is_guard;
+  Lods += is_lod;
+
+  const std::string &name = symbols::GetName(Var);
+  std::string res = name + " = length(point - ";
+  bool old = uniforms::SetArgs(true);
+  auto number = [&res](double Val)
+  {
+    Number(res, Val, uniforms::IsParam() ? uniforms::Param(Val) : -1);
+  };
+
+  if (!center.empty())
+    res += center;
+  else
+  {
+    res += "vec3(";
+    for (int i = 0; i < 3; i++)
+    {
+      if (i > 0)
+        res += ", ";
+      number(s.C[i]);
+    }
+    res += ')';
+  }
+  res += ')';
+  // Shape distance is measured in primitive space, world distance is shrunk by modifications stretch,
+  // bound is corrected as scaled shape distance is
+  double f = chains::GetFactor(Var);
+
+  if (inv * f != 1)
+  {
+    res += " * ";
+    number(inv * f);
+  }
+  res += " - ";
+  number((prim + Pad) * f);
+  res += ";\n";
+  // Bound distance is kept for shape narrower than pixel footprint (it is zero in 'SceneSDF'),
+  // hit points near such bound are counted for debug view only, normal and shadow rays don't pay for it
+  if (is_lod)
+  {
+    res += "if (tmp_lod > ";
+    number(2 * (s.R + Pad));
+    res += std::format(")\n  SceneLod += int(IsLodDebug && {} < tmp_lod);\nelse{}", name, is_guard ? " " : "\n");
+  }
+  uniforms::SetArgs(old);
+
+  // Bound distance is kept if shape can't be nearer than scene
+  if (is_guard)
+    res += std::format("if ({} <= res)\n", name);
+  res += "{\n";
+  for (size_t p = 0, end; p < Text.size(); p = end + 1)
+  {
+    end = Text.find('\n', p);
+    if (end == std::string::npos)
+      end = Text.size();
+    if (end > p)
+      res += "  " + Text.substr(p, end - p);
+    res += '\n';
+  }
+  return res + "}\n";
+} /* End of 'parser::bounds::Guard' function */
+
+/* Record scene function result function.
+ * ARGUMENTS:
+ *   - function index:
+ *       int Func;
+ *   - returned shape variable symbol id:
+ *       int Var;
+ * RETURNS: None.
+ */
+void parser::bounds::Result( int Func, int Var )
+{
+  if (Func >= (int)Results.size())
+    Results.resize(Func + 1);
+  Results[Func] = IsStretched ? sphere() : At(Var).Val;
+  IsStretched = false;
+} /* End of 'parser::bounds::Result' function */
+
+/* Record scene function call function.
+ * ARGUMENTS:
+ *   - result shape variable symbol id:
+ *       int Var;
+ *   - function index:
+ *       int Func;
+ * RETURNS: None.
+ */
+void parser::bounds::Call( int Var, int Func )
+{
+  shape &s = At(Var);
+
+  // Function result is primitive of called shape
+  s.Prim = Func < (int)Results.size() ? Results[Func] : sphere();
+  s.PrimIn = {};
+  Place(s);
+} /* End of 'parser::bounds::Call' function */
+
+/* Check is shape inside other one function.
+ * Inner sphere is taken from exact distance primitives only,
+ * so outer shape distance doesn't exceed inner one anywhere.
+ * ARGUMENTS:
+ *   - inner and outer shape variables symbol ids:
+ *       int Inner, Outer;
+ *   - minimal gap between inner shape bound and outer shape surface:
+ *       double Gap;
+ * RETURNS: (bool) is bound of inner shape inside outer shape by gap at least.
+ */
+bool parser::bounds::IsInside( int Inner, int Outer, double Gap )
+{
+  const sphere &a = At(Inner).Val, &b = At(Outer).In;
+
+  if (a.R < 0 || b.R < 0)
+    return false;
+
+  double d[3] {b.C[0] - a.C[0], b.C[1] - a.C[1], b.C[2] - a.C[2]};
+
+  return sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) + a.R + Pad + Gap <= b.R;
+} /* End of 'parser::bounds::IsInside' function */
+
+/* Check are shapes apart function.
+ * ARGUMENTS:
+ *   - shape variables symbol ids:
+ *       int A, B;
+ *   - minimal gap between bounds:
+ *       double Gap;
+ * RETURNS: (bool) are bounds apart by gap at least.
+ */
+bool parser::bounds::IsApart( int A, int B, double Gap )
+{
+  const sphere &a = At(A).Val, &b = At(B).Val;
+
+  if (a.R < 0 || b.R < 0)
+    return false;
+
+  double d[3] {b.C[0] - a.C[0], b.C[1] - a.C[1], b.C[2] - a.C[2]};
+
+  return sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) - a.R - b.R - Pad >= Gap;
+} /* End of 'parser::bounds::IsApart' function */
+
+/* Get scene bound declaration function.
+ * ARGUMENTS: None.
+ * RETURNS: (std::string) GLSL text.
+ */
+std::string parser::bounds::GetFlagStr( void )
+{
+  float b[4];
+
+  GetScene(b);
+
+  std::string res = "#define SceneBound vec4(";
+
+  for (int i = 0; i < 4; i++)
+  {
+    if (i > 0)
+      res += ", ";
+    Number(res, b[i], Frame.empty() ? -1 : Frame[i]);
+  }
+  return res + ")\n";
+} /* End of 'parser::bounds::GetFlagStr' function */
+
+/* Get scene bound function.
+ * ARGUMENTS:
+ *   - center and radius, negative radius if scene is unbounded (out):
+ *       float *Bound;
+ * RETURNS: (bool) is scene bounded.
+ */
+bool parser::bounds::GetScene( float *Bound )
+{
+  bool is_bounded = IsAdded && Scene.R >= 0;
+
+  for (int i = 0; i < 3; i++)
+    Bound[i] = is_bounded ? (float)Scene.C[i] : 0;
+  Bound[3] = is_bounded ? (float)(Scene.R + Pad) : -1;
+  return is_bounded;
+} /* End of 'parser::bounds::GetScene' function */
+
+/* Get bounds statistics function.
+ * ARGUMENTS: None.
+ * RETURNS: (std::string) report line.
+ */
+std::string parser::bounds::GetStat( void )
+{
+  std::string res = std::format("shape bounds: {} of {} evaluations guarded, {} with level of detail, ", Guarded, Total, Lods);
+
+  if (!IsAdded || Scene.R < 0)
+    return res + "scene is unbounded";
+  return res + std::format("scene bound radius {:.3f}", Scene.R + Pad);
+} /* End of 'parser::bounds::GetStat' function */
+
+/* END OF 'bound.cpp' FILE */
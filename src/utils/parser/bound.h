@@ -0,0 +1,130 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+ /* FILE NAME   : bound.h
+  * PURPOSE     : Ray marching project.
+  *               Parser module.
+  * PROGRAMMER  : Vladislav Biserov.
+  * LAST UPDATE : 02.04.2023
+  * NOTE        : None.
+  *
+  * No part of this file may be changed without agreement of
+  * Computer Graphics Support Group of 30 Phys-Math Lyceum
+  */
+
+#ifndef __bound_h_
+#define __bound_h_
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "obj/obj.h"
+
+namespace parser
+{
+  class expr;
+  struct arg;
+
+  /* Shape bounds class.
+   * Conservative world space bounding spheres are derived on compile time
+   * from constant arguments of shapes and modifications. Shape evaluation is
+   * skipped (bound distance is taken instead) when the bound is farther than
+   * scene distance found so far. This is exact only for shapes which reach
+   * the scene through 'add' and plain unions, other shapes are never guarded.
+   * Bound of whole scene is used to clip rays before marching.
+   * Shape narrower than pixel footprint at point distance from camera is
+   * replaced by its bound in scene distance (level of detail). Bound is never
+   * farther than shape, so this is safe for shapes which are only added to
+   * scene (through any unions and intersections and as first operand of
+   * differences), subtracted shapes are always evaluated.
+   * Shape evaluated in GLSL loop body is guarded by sphere enclosing its
+   * bounds of all iterations, unmodified primitive is guarded around center
+   * it is given in GLSL.
+   */
+  class bounds
+  {
+  private:
+    /* Bounding sphere structure */
+    struct sphere
+    {
+      double C[3] {}; // Center
+      double R = -1;  // Radius, negative if shape is unbounded
+    }; /* End of 'sphere' structure */
+
+    /* Shape variable structure */
+    struct shape
+    {
+      double W[3][3] {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}, w[3] {}; // Modifications: world point is W * local + w
+      bool IsMod = true;  // Are modifications known on compile time
+      sphere Prim;        // Last primitive bound in its local space
+      sphere Val;         // Current value bound in world space
+      sphere PrimIn;      // Sphere inside last primitive in its local space, negative radius if unknown
+      sphere In;          // Sphere inside current value in world space
+      double Inv = 1;     // Inverse of modifications stretch, scales world distance to primitive space
+    }; /* End of 'shape' structure */
+
+    /* Loop iterations bound structure */
+    struct span
+    {
+      sphere Val {{}, -2};  // Sphere enclosing bounds of all iterations, radius -2 if not set
+      double Prim = 0;      // Maximal primitive radius
+      bool IsPlaced = true; // Are primitives unmodified in all iterations
+    }; /* End of 'span' structure */
+
+    static constexpr double Pad = 0.01; // Bounds padding, covers marching threshold and float rounding
+
+    static thread_local std::vector<shape> Shapes;              // Shape variables by symbol id
+    static thread_local std::vector<std::vector<double>> Vars;  // Vector variables values by symbol id
+    static thread_local std::vector<std::pair<int, int>> Uses;  // Operation operand and result, result is -1 if operation isn't union
+    static thread_local std::vector<bool> IsUnsafe;             // Shapes which can't be guarded by symbol id
+    static thread_local std::vector<std::tuple<int, int, bool>> Parts; // Operation operand, result and is operand subtracted
+    static thread_local std::vector<int> Signs;                 // Shapes signs by symbol id: 1 - added, -1 - subtracted, 2 - both, 0 - unknown
+    static thread_local std::vector<int> Frame;                 // Scene bound frame slots
+    static thread_local sphere Scene;                           // Scene bound
+    static thread_local bool IsAdded;                           // Is any shape added to scene
+    static thread_local int Guarded, Lods, Total;               // Guarded, with level of detail and all shape evaluations
+    static thread_local std::vector<sphere> Results;            // Scene function results bounds by function index
+    static thread_local bool IsStretched;                       // Is shape of function body stretched
+    static thread_local std::vector<span> Spans;                // Bounds of all loop iterations by symbol id
+    static thread_local bool IsSpan;                            // Are loop iterations bounds collected
+
+    bounds(void)
+    {
+    }
+
+    static shape & At(int Id);
+    static bool Read(std::vector<arg> &Args, const std::vector<param::type> &Types, std::vector<double> &Vals);
+    static sphere Enclose(const sphere &A, const sphere &B);
+    static void Place(shape &S);
+    static void Number(std::string &Out, double Val, int Slot);
+    static void Span(int Var);
+
+  public:
+    static void Clear(void);
+    static void Use(int Var, obj::oper::type Type, const std::string &P1, const std::string &P2);
+    static void Begin(void);
+    static int GetVar(int Id, double *Vals);
+    static void SetVar(int Id, expr *E);
+    static void Shape(int Var, obj::shape::type Type, std::vector<arg> &Args);
+    static void Mod(int Var, obj::mod::type Type, std::vector<arg> &Args);
+    static void Oper(int Var, obj::oper::type Type, const std::string &P1, const std::string &P2, expr *K);
+    static void Add(int Var);
+    static void Loop(bool IsStart);
+    static void End(void);
+    static std::string Guard(int Var, const std::string &Text, const std::string &Center = "");
+    static void Result(int Func, int Var);
+    static void Call(int Var, int Func);
+    static bool IsInside(int Inner, int Outer, double Gap);
+    static bool IsApart(int A, int B, double Gap);
+    static std::string GetFlagStr(void);
+    static bool GetScene(float *Bound);
+    static std::string GetStat(void);
+  }; /* End of 'bounds' class */
+}
+
+#endif
+
+/* END OF 'bound.h' FILE */
@@ -0,0 +1,426 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+ /* FILE NAME   : bytecode.h
+  * PURPOSE     : Ray marching project.
+  *               Parser module.
+  * PROGRAMMER  : Vladislav Biserov.
+  * LAST UPDATE : 30.03.2023
+  * NOTE        : None.
+  *
+  * No part of this file may be changed without agreement of
+  * Computer Graphics Support Group of 30 Phys-Math Lyceum
+  */
+
+#ifndef __bytecode_h_
+#define __bytecode_h_
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace parser
+{
+  class expr;
+  class statement;
+  class assign_statement;
+  class for_statement;
+
+  /* Bytecode operation codes */
+  enum class opcode : unsigned char
+  {
+    eStore,      // R[A] = R[B], variable A = R[A]
+    eStoreInt,   // R[A] = (int)R[B], variable A = R[A]
+    eAdd,        // R[A] = R[B] + R[C]
+    eSub,        // R[A] = R[B] - R[C]
+    eMul,        // R[A] = R[B] * R[C]
+    eDiv,        // R[A] = R[B] / R[C]
+    eEQ,         // R[A] = R[B] == R[C]
+    eNOTEQ,      // R[A] = R[B] != R[C]
+    eLT,         // R[A] = R[B] < R[C]
+    eLTEQ,       // R[A] = R[B] <= R[C]
+    eGT,         // R[A] = R[B] > R[C]
+    eGTEQ,       // R[A] = R[B] >= R[C]
+    eAnd,        // R[A] = R[B] && R[C]
+    eOr,         // R[A] = R[B] || R[C]
+    eNeg,        // R[A] = -R[B]
+    eSin,        // R[A] = sin(R[B])
+    eCos,        // R[A] = cos(R[B])
+    eAbs,        // R[A] = fabs(R[B])
+    eMod,        // R[A] = fmod(R[B], R[C])
+    eJump,       // PC = A
+    eJumpIfZero, // if (R[A] == 0) PC = B
+    eEval,       // R[A] = Exprs[B]->Eval()
+    eExec,       // Statements[A]->Execute()
+    ePrint,      // Assigns[A]->Print()
+    eLoop,       // if (Loops[A]->Begin()) PC = B
+    eNext,       // Loops[A]->Next()
+    eDone,       // Loops[A]->End()
+    eOut,        // Out[A] = R[B]
+    eHalt,       // Stop execution
+  }; /* End of 'opcode' enum */
+
+  /* Bytecode instruction structure */
+  struct instr
+  {
+    opcode Op;   // Operation code
+    int A, B, C; // Operands
+  }; /* End of 'instr' structure */
+
+  /* Compiled scene program class.
+   * Register file is laid out as variable slots (indexed by symbol id), then constants,
+   * then temporaries, so operands are plain indices.
+   */
+  class program
+  {
+  public:
+    std::vector<instr> Code;                 // Instructions
+    std::vector<double> Regs;                // Initial register file
+    int Slots = 0;                           // Number of variable slots (symbol ids)
+    std::vector<expr *> Exprs;               // Expressions left to tree walker
+    std::vector<statement *> Statements;     // Statements left to tree walker
+    std::vector<assign_statement *> Assigns; // Assignments printing GLSL
+    std::vector<for_statement *> Loops;      // Loops building objects
+    int Outs = 0;                            // Number of outputs (last output index + 1)
+    int Time = -1;                           // 'Time' slot of frame program, -1 for scene program
+  }; /* End of 'program' class */
+
+  /* Bytecode compiler class.
+   * Syntax tree nodes compile themselves through this class, registers
+   * are tagged by kind during compilation and resolved in 'Link'.
+   * Nodes without own 'Compile' are called through tree walker, stores
+   * write variables through, so such nodes read actual values.
+   * Frame programs evaluate 'Time' only expressions into outputs once per frame,
+   * other variables are taken as constants with their value on compile time.
+   */
+  class compiler
+  {
+  private:
+    static constexpr int KindShift = 28;
+    static constexpr int IndexMask = (1 << KindShift) - 1;
+
+    /* Register kind */
+    enum kind
+    {
+      eSlot,  // Variable
+      eConst, // Constant
+      eTemp,  // Temporary
+    }; /* End of 'kind' enum */
+
+    program Prog;
+    std::map<double, int> ConstIds;
+    std::vector<double> Consts;
+    int Top = 0, MaxTop = 0; // Temporaries stack
+
+    static int Tag(kind K, int Index)
+    {
+      return (K << KindShift) | Index;
+    }
+
+    void Add(opcode Op, int A = 0, int B = 0, int C = 0)
+    {
+      Prog.Code.push_back({Op, A, B, C});
+    }
+
+    void Release(int R)
+    {
+      if (R >> KindShift == eTemp && (R & IndexMask) == Top - 1)
+        Top--;
+    }
+
+    int Temp(void)
+    {
+      if (++Top > MaxTop)
+        MaxTop = Top;
+      return Tag(eTemp, Top - 1);
+    }
+
+  public:
+    /* Scene program compiler constructor */
+    compiler(void)
+    {
+    } /* End of 'compiler' constructor */
+
+    /* Frame program compiler constructor.
+     * ARGUMENTS:
+     *   - 'Time' symbol id:
+     *       int TimeId;
+     */
+    compiler(int TimeId)
+    {
+      Prog.Time = TimeId;
+      Slot(TimeId);
+    } /* End of 'compiler' constructor */
+
+    /* Check is frame program compiled function.
+     * ARGUMENTS: None.
+     * RETURNS: (bool) is frame program.
+     */
+    bool IsFrame(void) const
+    {
+      return Prog.Time >= 0;
+    } /* End of 'IsFrame' function */
+
+    /* Get variable register function.
+     * ARGUMENTS:
+     *   - variable symbol id:
+     *       int Id;
+     * RETURNS: (int) register.
+     */
+    int Slot(int Id)
+    {
+      if (Id >= Prog.Slots)
+        Prog.Slots = Id + 1;
+      return Tag(eSlot, Id);
+    } /* End of 'Slot' function */
+
+    /* Get constant register function.
+     * ARGUMENTS:
+     *   - constant value:
+     *       double Val;
+     * RETURNS: (int) register.
+     */
+    int Const(double Val)
+    {
+      auto it = ConstIds.find(Val);
+
+      if (it != ConstIds.end())
+        return it->second;
+
+      int r = Tag(eConst, (int)Consts.size());
+
+      Consts.push_back(Val);
+      ConstIds.emplace(Val, r);
+      return r;
+    } /* End of 'Const' function */
+
+    /* Add operation function.
+     * ARGUMENTS:
+     *   - operation code:
+     *       opcode Op;
+     *   - source registers:
+     *       int B, C;
+     * RETURNS: (int) result register.
+     */
+    int Op(opcode Op, int B, int C = 0)
+    {
+      // Sources are released before destination is taken, VM reads them first
+      Release(C);
+      Release(B);
+
+      int a = Temp();
+
+      Add(Op, a, B, C);
+      return a;
+    } /* End of 'Op' function */
+
+    /* Add store to variable function.
+     * ARGUMENTS:
+     *   - variable register:
+     *       int Slot;
+     *   - value register:
+     *       int R;
+     *   - truncate value to int flag:
+     *       bool IsInt;
+     * RETURNS: None.
+     */
+    void Store(int Slot, int R, bool IsInt)
+    {
+      Release(R);
+      Add(IsInt ? opcode::eStoreInt : opcode::eStore, Slot, R);
+    } /* End of 'Store' function */
+
+    /* Add output function.
+     * ARGUMENTS:
+     *   - value register:
+     *       int R;
+     *   - output index:
+     *       int At;
+     * RETURNS: (int) output index.
+     */
+    int Out(int R, int At)
+    {
+      Release(R);
+      Add(opcode::eOut, At, R);
+      Prog.Outs = std::max(Prog.Outs, At + 1);
+      return At;
+    } /* End of 'Out' function */
+
+    /* Add jump function.
+     * ARGUMENTS:
+     *   - jump operation code ('eJump' or 'eJumpIfZero'):
+     *       opcode Op;
+     *   - condition register:
+     *       int R;
+     * RETURNS: (int) instruction index to patch.
+     */
+    int Jump(opcode Op, int R = 0)
+    {
+      int at = Here();
+
+      if (Op == opcode::eJumpIfZero)
+      {
+        Release(R);
+        Add(Op, R, -1);
+      }
+      else
+        Add(Op, -1);
+      return at;
+    } /* End of 'Jump' function */
+
+    /* Set jump target function.
+     * ARGUMENTS:
+     *   - jump instruction index:
+     *       int At;
+     *   - target instruction index:
+     *       int Target;
+     * RETURNS: None.
+     */
+    void Patch(int At, int Target)
+    {
+      instr &i = Prog.Code[At];
+
+      if (i.Op == opcode::eJumpIfZero || i.Op == opcode::eLoop)
+        i.B = Target;
+      else
+        i.A = Target;
+    } /* End of 'Patch' function */
+
+    /* Get next instruction index function.
+     * ARGUMENTS: None.
+     * RETURNS: (int) index.
+     */
+    int Here(void) const
+    {
+      return (int)Prog.Code.size();
+    } /* End of 'Here' function */
+
+    /* Evaluate expression by tree walker function.
+     * ARGUMENTS:
+     *   - expression:
+     *       expr *E;
+     * RETURNS: (int) result register.
+     */
+    int Eval(expr *E)
+    {
+      int a = Temp();
+
+      Add(opcode::eEval, a, (int)Prog.Exprs.size());
+      Prog.Exprs.push_back(E);
+      return a;
+    } /* End of 'Eval' function */
+
+    /* Execute statement by tree walker function.
+     * ARGUMENTS:
+     *   - statement:
+     *       statement *S;
+     * RETURNS: None.
+     */
+    void Exec(statement *S)
+    {
+      Add(opcode::eExec, (int)Prog.Statements.size());
+      Prog.Statements.push_back(S);
+    } /* End of 'Exec' function */
+
+    /* Print assignment GLSL function.
+     * ARGUMENTS:
+     *   - assignment:
+     *       assign_statement *S;
+     * RETURNS: None.
+     */
+    void Print(assign_statement *S)
+    {
+      Add(opcode::ePrint, (int)Prog.Assigns.size());
+      Prog.Assigns.push_back(S);
+    } /* End of 'Print' function */
+
+    /* Start loop building objects function.
+     * ARGUMENTS:
+     *   - loop statement:
+     *       for_statement *S;
+     * RETURNS: (int) instruction index to patch with loop end.
+     */
+    int Loop(for_statement *S)
+    {
+      int at = Here();
+
+      Add(opcode::eLoop, (int)Prog.Loops.size(), -1);
+      Prog.Loops.push_back(S);
+      return at;
+    } /* End of 'Loop' function */
+
+    /* Add loop iteration end or loop end function.
+     * ARGUMENTS:
+     *   - loop start instruction index:
+     *       int At;
+     *   - loop end flag:
+     *       bool IsDone;
+     * RETURNS: None.
+     */
+    void Next(int At, bool IsDone)
+    {
+      Add(IsDone ? opcode::eDone : opcode::eNext, Prog.Code[At].A);
+    } /* End of 'Next' function */
+
+    /* Finish program function.
+     * ARGUMENTS: None.
+     * RETURNS: (program) program with resolved registers.
+     */
+    program Link(void)
+    {
+      int
+        slots = Prog.Slots,
+        base[] = {0, slots, slots + (int)Consts.size()};
+      auto fix = [&](int &R)
+      {
+        R = base[R >> KindShift] + (R & IndexMask);
+      };
+
+      Add(opcode::eHalt);
+      for (auto &i : Prog.Code)
+        switch (i.Op)
+        {
+        case opcode::eJump:
+        case opcode::eExec:
+        case opcode::ePrint:
+        case opcode::eLoop:
+        case opcode::eNext:
+        case opcode::eDone:
+        case opcode::eHalt:
+          break;
+        case opcode::eJumpIfZero:
+        case opcode::eEval:
+          fix(i.A);
+          break;
+        case opcode::eOut:
+          fix(i.B);
+          break;
+        case opcode::eStore:
+        case opcode::eStoreInt:
+        case opcode::eNeg:
+        case opcode::eSin:
+        case opcode::eCos:
+        case opcode::eAbs:
+          fix(i.A);
+          fix(i.B);
+          break;
+        default:
+          fix(i.A);
+          fix(i.B);
+          fix(i.C);
+          break;
+        }
+
+      Prog.Regs.assign(base[2] + MaxTop, 0);
+      std::copy(Consts.begin(), Consts.end(), Prog.Regs.begin() + slots);
+      return std::move(Prog);
+    } /* End of 'Link' function */
+  }; /* End of 'compiler' class */
+}
+
+#endif
+
+/* END OF 'bytecode.h' FILE */
@@ -0,0 +1,530 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : chain.cpp
+ * PURPOSE     : Ray marching project.
+ *               Parser module.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 02.04.2023
+ * NOTE        : None.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include <algorithm>
+
+#include "chain.h"
+#include "expr.h"
+#include "loop.h"
+
+thread_local std::vector<parser::chains::chain> parser::chains::Chains;
+thread_local int
+  parser::chains::Const = 0,
+  parser::chains::Frame = 0,
+  parser::chains::Steps = 0;
+
+/* Maximal number of nodes in tree of entry computed per frame */
+static constexpr int MaxSize = 64;
+
+/* Reset chains function.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+void parser::chains::Clear( void )
+{
+  Chains.clear();
+  Const = Frame = Steps = 0;
+} /* End of 'parser::chains::Clear' function */
+
+/* Get shape chain by symbol id function.
+ * ARGUMENTS:
+ *   - symbol id:
+ *       int Id;
+ * RETURNS: (chain &) chain.
+ */
+parser::chains::chain & parser::chains::At( int Id )
+{
+  if (Id >= (int)Chains.size())
+    Chains.resize(Id + 1);
+
+  chain &c = Chains[Id];
+
+  if (c.Nodes.empty())
+    c.Nodes = {{'#', 0}, {'#', 1}};
+  return c;
+} /* End of 'parser::chains::At' function */
+
+/* Add constant node function.
+ * ARGUMENTS:
+ *   - chain:
+ *       chain &C;
+ *   - value:
+ *       double Val;
+ * RETURNS: (int) node.
+ */
+int parser::chains::Num( chain &C, double Val )
+{
+  if (Val == 0 || Val == 1)
+    return (int)Val;
+  C.Nodes.push_back({'#', Val});
+  return (int)C.Nodes.size() - 1;
+} /* End of 'parser::chains::Num' function */
+
+/* Add sum node function.
+ * ARGUMENTS:
+ *   - chain:
+ *       chain &C;
+ *   - operand nodes:
+ *       int A, B;
+ * RETURNS: (int) node.
+ */
+int parser::chains::Sum( chain &C, int A, int B )
+{
+  const node &a = C.Nodes[A], &b = C.Nodes[B];
+
+  if (a.Op == '#' && b.Op == '#')
+    return Num(C, a.Val + b.Val);
+  if (A == 0)
+    return B;
+  if (B == 0)
+    return A;
+  C.Nodes.push_back({'+', 0, A, B, nullptr, a.Size + b.Size + 1});
+  return (int)C.Nodes.size() - 1;
+} /* End of 'parser::chains::Sum' function */
+
+/* Add product node function.
+ * ARGUMENTS:
+ *   - chain:
+ *       chain &C;
+ *   - operand nodes:
+ *       int A, B;
+ * RETURNS: (int) node.
+ */
+int parser::chains::Mul( chain &C, int A, int B )
+{
+  const node &a = C.Nodes[A], &b = C.Nodes[B];
+
+  if (a.Op == '#' && b.Op == '#')
+    return Num(C, a.Val * b.Val);
+  if (A == 0 || B == 0)
+    return 0;
+  if (A == 1)
+    return B;
+  if (B == 1)
+    return A;
+  C.Nodes.push_back({'*', 0, A, B, nullptr, a.Size + b.Size + 1});
+  return (int)C.Nodes.size() - 1;
+} /* End of 'parser::chains::Mul' function */
+
+/* Get modification matrix function.
+ * ARGUMENTS:
+ *   - chain:
+ *       chain &C;
+ *   - modification type:
+ *       obj::mod::type Type;
+ *   - arguments:
+ *       std::vector<arg> &Args;
+ *   - modified point is S * point + last column (out):
+ *       int S[3][4];
+ * RETURNS: (bool) can modification be fused.
+ */
+bool parser::chains::Step( chain &C, obj::mod::type Type, std::vector<arg> &Args, int S[3][4] )
+{
+  double v[3], a[3];
+  int n = Args[0].Value != nullptr ? Args[0].Value->Values(v) : 0;
+
+  for (int r = 0; r < 3; r++)
+    for (int c = 0; c < 4; c++)
+      S[r][c] = r == c;
+
+  // Repetition and mirror fold space, they aren't affine
+  if (Type == obj::mod::type::eRepeat || Type == obj::mod::type::eMirror)
+    return false;
+  if (Type == obj::mod::type::eTranslate)
+  {
+    // 'Translate' adds vector to point
+    if (n != 3)
+      return false;
+    for (int r = 0; r < 3; r++)
+      S[r][3] = Num(C, v[r]);
+    return true;
+  }
+  if (Type == obj::mod::type::eScale)
+  {
+    // 'Scale' divides point by vector
+    if (n != 3)
+      return false;
+    for (int r = 0; r < 3; r++)
+    {
+      if (v[r] == 0 || !isfinite(1 / v[r]))
+        return false;
+      S[r][r] = Num(C, 1 / v[r]);
+    }
+    return true;
+  }
+
+  // 'Rotate' applies inverse of 'MatrRotate' matrix, axis isn't normalized there
+  if (Args[1].Value == nullptr || Args[1].Value->Values(a) != 3)
+    return false;
+
+  double g[3][3] {{0, -a[2], a[1]}, {a[2], 0, -a[0]}, {-a[1], a[0], 0}};
+
+  if (n == 1)
+  {
+    double
+      rad = v[0] * 3.14159 / 180, sn = sin(rad), cs = cos(rad), q[3][3], det = 0;
+
+    for (int r = 0; r < 3; r++)
+      for (int c = 0; c < 3; c++)
+        q[r][c] = a[r] * a[c] * (1 - cs) + (r == c) * cs + g[r][c] * sn;
+    for (int c = 0; c < 3; c++)
+      det += q[0][c] * (q[1][(c + 1) % 3] * q[2][(c + 2) % 3] - q[1][(c + 2) % 3] * q[2][(c + 1) % 3]);
+    if (fabs(det) < 1e-12)
+      return false;
+    // Inverse is adjugate divided by determinant
+    for (int r = 0; r < 3; r++)
+      for (int c = 0; c < 3; c++)
+        S[r][c] = Num(C, (q[(c + 1) % 3][(r + 1) % 3] * q[(c + 2) % 3][(r + 2) % 3] -
+          q[(c + 1) % 3][(r + 2) % 3] * q[(c + 2) % 3][(r + 1) % 3]) / det);
+    return true;
+  }
+
+  // Inverse of rotation around unit axis is its transpose, angle is known per frame
+  expr *e = Args[0].Value;
+
+  // Entries are folded by axis values, so matrix isn't fused in parameters mode and in loops recorded
+  if (e == nullptr || !e->IsUniform || !uniforms::IsEnabled() || uniforms::IsParam() || uniforms::IsInLoop() ||
+      fabs(a[0] * a[0] + a[1] * a[1] + a[2] * a[2] - 1) > 1e-6)
+    return false;
+  C.Nodes.push_back({'e', 0, -1, -1, e});
+
+  int
+    ang = (int)C.Nodes.size() - 1,
+    rad = Mul(C, ang, Num(C, 3.14159 / 180)), sn, cs;
+
+  C.Nodes.push_back({'s', 0, rad, -1, nullptr, C.Nodes[rad].Size + 1});
+  sn = (int)C.Nodes.size() - 1;
+  C.Nodes.push_back({'c', 0, rad, -1, nullptr, C.Nodes[rad].Size + 1});
+  cs = (int)C.Nodes.size() - 1;
+  for (int r = 0; r < 3; r++)
+    for (int c = 0; c < 3; c++)
+      S[r][c] = Sum(C, Sum(C, Num(C, a[c] * a[r]), Mul(C, Num(C, (r == c) - a[c] * a[r]), cs)), Mul(C, Num(C, g[c][r]), sn));
+  return true;
+} /* End of 'parser::chains::Step' function */
+
+/* Compile entry node to frame program function.
+ * ARGUMENTS:
+ *   - chain:
+ *       chain &C;
+ *   - node:
+ *       int N;
+ *   - frame program compiler:
+ *       compiler &Comp;
+ * RETURNS: (int) register with node value.
+ */
+int parser::chains::Compile( chain &C, int N, compiler &Comp )
+{
+  const node &n = C.Nodes[N];
+
+  switch (n.Op)
+  {
+  case '#':
+    return Comp.Const(n.Val);
+  case 'e':
+    return n.E->Compile(Comp);
+  case 's':
+    return Comp.Op(opcode::eSin, Compile(C, n.A, Comp));
+  case 'c':
+    return Comp.Op(opcode::eCos, Compile(C, n.A, Comp));
+  default:
+    break;
+  }
+
+  int
+    a = Compile(C, n.A, Comp),
+    b = Compile(C, n.B, Comp);
+
+  return Comp.Op(n.Op == '+' ? opcode::eAdd : opcode::eMul, a, b);
+} /* End of 'parser::chains::Compile' function */
+
+/* Write GLSL text of entry node function.
+ * ARGUMENTS:
+ *   - chain:
+ *       chain &C;
+ *   - node:
+ *       int N;
+ *   - buffer to append text to:
+ *       std::string &Out;
+ * RETURNS: None.
+ */
+void parser::chains::Write( chain &C, int N, std::string &Out )
+{
+  const node &n = C.Nodes[N];
+
+  switch (n.Op)
+  {
+  case '#':
+    expr::Literal(Out, n.Val);
+    return;
+  case 'e':
+    // Expression is written as is, not as its own slot
+    uniforms::Enable(false);
+    n.E->Emit(Out);
+    uniforms::Enable(true);
+    return;
+  case 's':
+  case 'c':
+    Out += n.Op == 's' ? "sin(" : "cos(";
+    Write(C, n.A, Out);
+    Out += ')';
+    return;
+  default:
+    break;
+  }
+  Out += '(';
+  Write(C, n.A, Out);
+  Out += n.Op == '+' ? " + " : " * ";
+  Write(C, n.B, Out);
+  Out += ')';
+} /* End of 'parser::chains::Write' function */
+
+/* Write matrix entry function.
+ * ARGUMENTS:
+ *   - chain:
+ *       chain &C;
+ *   - node:
+ *       int N;
+ *   - buffer to append text to:
+ *       std::string &Out;
+ * RETURNS: (bool) is entry written (false if there are no free slots).
+ */
+bool parser::chains::Entry( chain &C, int N, std::string &Out )
+{
+  int slot;
+
+  if (C.Nodes[N].Op == '#')
+  {
+    // Each entry gets own parameter, equal values don't share it
+    if ((slot = uniforms::IsParam() ? uniforms::Param(C.Nodes[N].Val) : -1) < 0)
+    {
+      expr::Literal(Out, C.Nodes[N].Val);
+      return true;
+    }
+  }
+  else
+  {
+    // Equal entries of all chains share slot
+    std::string text;
+
+    Write(C, N, text);
+    if ((slot = uniforms::Compute(text, [&C, N](compiler &Comp) { return Compile(C, N, Comp); })) < 0)
+      return false;
+  }
+  Out += uniforms::Name(slot);
+  return true;
+} /* End of 'parser::chains::Entry' function */
+
+/* Apply modification to shape function.
+ * ARGUMENTS:
+ *   - shape variable symbol id:
+ *       int Var;
+ *   - modification type:
+ *       obj::mod::type Type;
+ *   - arguments:
+ *       std::vector<arg> &Args;
+ * RETURNS: (std::string) GLSL text setting point of shape.
+ */
+std::string parser::chains::Mod( int Var, obj::mod::type Type, std::vector<arg> &Args )
+{
+  chain &c = At(Var);
+  const std::string &var = symbols::GetName(Var);
+  int s[3][4], m[3][4];
+  double v[3];
+
+  // Inverse of scale stretches distance by maximal component of inverse at most
+  if (Type == obj::mod::type::eScale)
+  {
+    c.IsScaled = true;
+    if (Args[0].Value != nullptr && Args[0].Value->Values(v) == 3)
+      c.Factor *= std::min({fabs(v[0]), fabs(v[1]), fabs(v[2])});
+    else
+      c.IsFactor = false;
+  }
+
+  // Text must depend on scene structure only in parameters mode and in loops recorded
+  bool
+    old = uniforms::SetArgs(true),
+    is_fixed = uniforms::IsParam() || !uniforms::IsEnabled() || uniforms::IsInLoop();
+
+  // GLSL loop body modifies point of previous iteration, so it isn't fused
+  if (c.IsPoint && !loops::IsSymbolic() && Step(c, Type, Args, s))
+  {
+    bool
+      is_const = true,
+      is_diag = true,
+      is_move = false,
+      is_small = true;
+
+    // Modification is applied after ones fused before
+    for (int r = 0; r < 3; r++)
+      for (int col = 0; col < 4; col++)
+      {
+        m[r][col] = col == 3 ? s[r][3] : 0;
+        for (int k = 0; k < 3; k++)
+          m[r][col] = Sum(c, m[r][col], Mul(c, s[r][k], c.M[k][col]));
+
+        const node &n = c.Nodes[m[r][col]];
+
+        is_const &= n.Op == '#';
+        is_small &= n.Size <= MaxSize;
+        if (col == 3)
+          is_move |= m[r][col] != 0;
+        else if (r != col)
+          is_diag &= m[r][col] == 0;
+      }
+
+    std::string res = std::format("mod_{} = ", var);
+    bool is_ok = is_small;
+
+    if (is_ok && !is_fixed && is_const && is_diag)
+    {
+      // Scales and translations only
+      if (m[0][0] == 1 && m[1][1] == 1 && m[2][2] == 1)
+        res += "point";
+      else
+      {
+        res += "point * vec3(";
+        for (int r = 0; r < 3; r++)
+        {
+          if (r > 0)
+            res += ", ";
+          Entry(c, m[r][r], res);
+        }
+        res += ')';
+      }
+    }
+    else if (is_ok)
+    {
+      // Matrix is column major in GLSL
+      res += "mat3(";
+      for (int col = 0; col < 3 && is_ok; col++)
+        for (int r = 0; r < 3 && is_ok; r++)
+        {
+          if (r > 0 || col > 0)
+            res += ", ";
+          is_ok = Entry(c, m[r][col], res);
+        }
+      res += ") * point";
+    }
+    if (is_ok && (is_fixed || is_move))
+    {
+      res += " + vec3(";
+      for (int r = 0; r < 3 && is_ok; r++)
+      {
+        if (r > 0)
+          res += ", ";
+        is_ok = Entry(c, m[r][3], res);
+      }
+      res += ')';
+    }
+    if (is_ok)
+    {
+      uniforms::SetArgs(old);
+      std::copy(&m[0][0], &m[0][0] + 12, &c.M[0][0]);
+      (is_const ? Const : Frame)++;
+      file::Set(file::Name(Var, file::facet::eMod));
+      return res + ";\n";
+    }
+  }
+  uniforms::SetArgs(old);
+
+  // Point of shape isn't computed from scene point any more
+  c.IsPoint = false;
+  Steps++;
+
+  std::string res = obj::mod::ToStr.at(Type)(var, EmitArgs(Args));
+
+  file::Use(file::Name(Var, file::facet::eMod));
+  file::Set(file::Name(Var, file::facet::eMod));
+  return res;
+} /* End of 'parser::chains::Mod' function */
+
+/* Add distance correction to shape evaluation function.
+ * ARGUMENTS:
+ *   - shape variable symbol id:
+ *       int Var;
+ *   - shape evaluation GLSL text:
+ *       const std::string &Text;
+ * RETURNS: (std::string) GLSL text.
+ */
+std::string parser::chains::Scale( int Var, const std::string &Text )
+{
+  if (Var >= (int)Chains.size() || !Chains[Var].IsScaled || !Chains[Var].IsFactor)
+    return Text;
+
+  const std::string &name = symbols::GetName(Var);
+  std::string res, f = " * ";
+  bool old = uniforms::SetArgs(true);
+  bool is_fixed = uniforms::IsParam() || !uniforms::IsEnabled() || uniforms::IsInLoop();
+
+  // Text must depend on scene structure only in parameters mode and in loops recorded
+  if (!is_fixed && Chains[Var].Factor == 1)
+  {
+    uniforms::SetArgs(old);
+    return Text;
+  }
+
+  int slot = uniforms::IsParam() ? uniforms::Param(Chains[Var].Factor) : -1;
+
+  if (slot >= 0)
+    f += uniforms::Name(slot);
+  else
+    expr::Literal(f, Chains[Var].Factor);
+  uniforms::SetArgs(old);
+
+  // Factor goes to assignments of distance, so evaluation doesn't read shape it sets
+  for (size_t p = 0, end; p < Text.size(); p = end + 1)
+  {
+    end = Text.find('\n', p);
+    if (end == std::string::npos)
+      end = Text.size();
+
+    std::string_view line(Text.data() + p, end - p);
+
+    if (line.starts_with(name + " = ") && line.ends_with(';'))
+      res += std::string(line.substr(0, line.size() - 1)) + f + ';';
+    else
+      res += line;
+    if (end < Text.size())
+      res += '\n';
+  }
+  return res;
+} /* End of 'parser::chains::Scale' function */
+
+/* Get distance factor of shape function.
+ * ARGUMENTS:
+ *   - shape variable symbol id:
+ *       int Var;
+ * RETURNS: (double) factor shape distance is multiplied by.
+ */
+double parser::chains::GetFactor( int Var )
+{
+  if (Var >= (int)Chains.size() || !Chains[Var].IsScaled || !Chains[Var].IsFactor)
+    return 1;
+  return Chains[Var].Factor;
+} /* End of 'parser::chains::GetFactor' function */
+
+/* Get chains statistics function.
+ * ARGUMENTS: None.
+ * RETURNS: (std::string) report line.
+ */
+std::string parser::chains::GetStat( void )
+{
+  return std::format("modifications: {} fused to constant matrices, {} to per frame matrices, {} applied one by one",
+    Const, Frame, Steps);
+} /* End of 'parser::chains::GetStat' function */
+
+/* END OF 'chain.cpp' FILE */
@@ -0,0 +1,96 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+ /* FILE NAME   : chain.h
+  * PURPOSE     : Ray marching project.
+  *               Parser module.
+  * PROGRAMMER  : Vladislav Biserov.
+  * LAST UPDATE : 02.04.2023
+  * NOTE        : None.
+  *
+  * No part of this file may be changed without agreement of
+  * Computer Graphics Support Group of 30 Phys-Math Lyceum
+  */
+
+#ifndef __chain_h_
+#define __chain_h_
+
+#include <string>
+#include <vector>
+
+#include "obj/obj.h"
+
+namespace parser
+{
+  class expr;
+  class compiler;
+  struct arg;
+
+  /* Modification chains class.
+   * Point of shape is affine function of scene point, so all modifications
+   * applied to shape are fused on compile time to one matrix and translation:
+   *   mod_s = mat3(...) * point + vec3(...);
+   * Matrix of modifications with constant arguments is written as literals,
+   * rotation by angle depending on 'Time' only (around unit axis, not in
+   * parameters mode) makes matrix entries computed once per frame to 'FrameVal'
+   * uniform block.
+   * Modification which can't be fused (vector depending on 'Time' or
+   * hoisting disabled) is applied to point as before, next ones are applied
+   * to its result one by one, as modifications in GLSL loop body are.
+   * Scales aren't distance preserving, distance of scaled shape is multiplied
+   * by product of minimal absolute scale components, so it isn't overestimated.
+   */
+  class chains
+  {
+  private:
+    /* Matrix entry node structure */
+    struct node
+    {
+      char Op;            // '#' - constant, 'e' - expression, 's' - sine, 'c' - cosine, '+' - sum, '*' - product
+      double Val = 0;     // Value of constant
+      int A = -1, B = -1; // Operand nodes
+      expr *E = nullptr;  // Expression depending on 'Time' only
+      int Size = 1;       // Number of nodes in tree
+    }; /* End of 'node' structure */
+
+    /* Shape modifications structure */
+    struct chain
+    {
+      std::vector<node> Nodes;                                      // Entry nodes, constants 0 and 1 are first
+      int M[3][4] {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}};       // Point of shape is M * base point + last column
+      bool IsPoint = true;                                          // Is base point scene point (modification of base is fused)
+      bool IsScaled = false;                                        // Are there scales
+      bool IsFactor = true;                                         // Is distance factor known
+      double Factor = 1;                                            // Distance factor
+    }; /* End of 'chain' structure */
+
+    static thread_local std::vector<chain> Chains; // Chains by shape symbol id
+    static thread_local int Const, Frame, Steps;   // Fused to constant, to per frame matrices and not fused modifications
+
+    chains(void)
+    {
+    }
+
+    static chain & At(int Id);
+    static int Num(chain &C, double Val);
+    static int Sum(chain &C, int A, int B);
+    static int Mul(chain &C, int A, int B);
+    static bool Step(chain &C, obj::mod::type Type, std::vector<arg> &Args, int S[3][4]);
+    static int Compile(chain &C, int N, compiler &Comp);
+    static void Write(chain &C, int N, std::string &Out);
+    static bool Entry(chain &C, int N, std::string &Out);
+
+  public:
+    static void Clear(void);
+    static std::string Mod(int Var, obj::mod::type Type, std::vector<arg> &Args);
+    static std::string Scale(int Var, const std::string &Text);
+    static double GetFactor(int Var);
+    static std::string GetStat(void);
+  }; /* End of 'chains' class */
+}
+
+#endif
+
+/* END OF 'chain.h' FILE */
@@ -0,0 +1,54 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+ /* FILE NAME   : context.h
+  * PURPOSE     : Ray marching project.
+  *               Parser module.
+  * PROGRAMMER  : Vladislav Biserov.
+  * LAST UPDATE : 02.04.2023
+  * NOTE        : None.
+  *
+  * No part of this file may be changed without agreement of
+  * Computer Graphics Support Group of 30 Phys-Math Lyceum
+  */
+
+#ifndef __context_h_
+#define __context_h_
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "bytecode.h"
+
+namespace parser
+{
+  /* Scene compilation context structure.
+   * Switches compilation is run with and its results. Each caller owns
+   * its context, so scenes compiled at once by several threads (or by
+   * worker thread while render thread changes settings) don't share them.
+   * Working state is kept per thread by parser modules, 'Parse' copies all
+   * results here, so callers don't read module state after it.
+   */
+  struct compile_context
+  {
+    bool IsTable = false;          // Pass scene to fixed shader in storage buffers (see 'table')
+    bool IsParams = false;         // Pass constant object arguments through 'ParamVal' (see 'uniforms')
+    bool IsConvert = true;         // Convert images to '.g32' while parsing
+    std::optional<program> Frame;  // Frame uniforms program of last compiled scene
+    int WriteCnt = 0, SkipCnt = 0; // Shaders written and skipped (same as previous one) in this context
+    int Overflow = 0;              // Values of last compiled scene which didn't fit into 'FrameVal' or 'ParamVal'
+    std::string Shader;            // Shader text of last compiled scene
+    std::string Key;               // State shader is used with (see 'file::Write')
+    std::string Report;            // Compilation report of last compiled scene
+    bool IsTableUsed = false;      // Is last compiled scene passed in storage buffers (table may be refused)
+    std::vector<int> Head;         // Scene table flags, lights and program, empty if table isn't used
+    std::vector<float> Vals;       // Scene table constants, empty if table isn't used
+  }; /* End of 'compile_context' structure */
+}
+
+#endif
+
+/* END OF 'context.h' FILE */
@@ -7,7 +7,7 @@
   * PURPOSE     : Ray marching project.
   *               Parser module.
   * PROGRAMMER  : Vladislav Biserov.
-  * LAST UPDATE : 30.03.2023
+  * LAST UPDATE : 02.04.2023
   * NOTE        : None.
   *
   * No part of this file may be changed without agreement of
@@ -17,24 +17,298 @@
 #ifndef __expr_h_
 #define __expr_h_
 
+#include <algorithm>
+#include <charconv>
 #include <format>
+#include <map>
 #include <optional>
+#include <stdexcept>
 #include <math.h>
 
+#include "obj/obj.h"
+#include "bytecode.h"
+#include "fold.h"
+#include "uniform.h"
 #include "variable.h"
 #include "file.h"
+#include "table.h"
+#include "bound.h"
+#include "chain.h"
+#include "func.h"
+#include "loop.h"
 
 namespace parser
 {
+  /* Expression class.
+   * 'Eval' only computes value on compile time, GLSL text is produced
+   * separately by 'Emit' directly into the output buffer when it is needed.
+   * Values depending on loop variables are written as GLSL expressions in
+   * loop emitted from syntax tree.
+   */
   class expr
   {
+  protected:
+    /* Write GLSL text of node function.
+     * ARGUMENTS:
+     *   - buffer to append text to:
+     *       std::string &Out;
+     * RETURNS: None.
+     */
+    virtual void Write(std::string &/* Out */)
+    {
+    } /* End of 'Write' function */
+
+    /* Check is node leaf function.
+     * ARGUMENTS: None.
+     * RETURNS: (bool) is leaf.
+     */
+    virtual bool IsLeaf(void)
+    {
+      return false;
+    } /* End of 'IsLeaf' function */
+
+    /* Set folding result function.
+     * ARGUMENTS:
+     *   - folding pass state:
+     *       folder &F;
+     *   - is node constant, is node vector, are all operands known per frame flags:
+     *       bool Const, Vector, Uniform;
+     *   - does node read variable assigned in loop building objects flag:
+     *       bool Looped;
+     * RETURNS: (bool) is node constant.
+     */
+    bool SetFold(folder &F, bool Const, bool Vector, bool Uniform = false, bool Looped = false)
+    {
+      IsConst = Const;
+      IsVector = Vector;
+      IsUniform = !Const && !Vector && Uniform;
+      IsLooped = Looped;
+      if (IsConst && !IsVector)
+        F.Count++;
+      return IsConst;
+    } /* End of 'SetFold' function */
+
+    /* Check is value known once per frame function.
+     * ARGUMENTS:
+     *   - expression:
+     *       expr *E;
+     * RETURNS: (bool) is expression constant or depends on 'Time' only.
+     */
+    static bool IsPerFrame(expr *E)
+    {
+      return E->IsConst || E->IsUniform;
+    } /* End of 'IsPerFrame' function */
+
   public:
-    std::string Text;
+    bool IsConst = false;  // Doesn't depend on 'Time', set by 'Fold'
+    bool IsVector = false; // Value is vector or material (has no compile time value)
+    bool IsUniform = false; // Depends on 'Time' only, set by 'Fold'
+    bool IsLooped = false; // Reads variable assigned in loop building objects, set by 'Fold'
+
     virtual double Eval(void) = 0;
 
+    /* Emit GLSL text function.
+     * ARGUMENTS:
+     *   - buffer to append text to:
+     *       std::string &Out;
+     * RETURNS: None.
+     */
+    void Emit(std::string &Out)
+    {
+      if (IsConst && !IsVector && !(IsLooped && loops::IsSymbolic()))
+      {
+        double val = Eval();
+
+        if (isfinite(val))
+        {
+          int slot = uniforms::IsParam() ? uniforms::Param(val) : -1;
+
+          if (slot >= 0)
+            Out += uniforms::Name(slot);
+          else
+            Literal(Out, val);
+          return;
+        }
+      }
+      // Loop iterations text must be the same, their own values aren't hoisted
+      if (IsUniform && !IsLeaf() && uniforms::IsEnabled() && !(IsLooped && uniforms::IsInLoop()))
+      {
+        std::string text;
+
+        // Whole subtree goes to one slot
+        uniforms::Enable(false);
+        Write(text);
+        uniforms::Enable(true);
+
+        int slot = uniforms::Add(this, text);
+
+        Out += slot < 0 ? text : uniforms::Name(slot);
+        return;
+      }
+      Write(Out);
+    } /* End of 'Emit' function */
+
+    /* Fold constant subtrees function.
+     * ARGUMENTS:
+     *   - folding pass state:
+     *       folder &F;
+     * RETURNS: (bool) is expression constant.
+     */
+    virtual bool Fold(folder &/* F */)
+    {
+      return false;
+    } /* End of 'Fold' function */
+
+    /* Compile expression to bytecode function.
+     * ARGUMENTS:
+     *   - bytecode compiler:
+     *       compiler &C;
+     * RETURNS: (int) register with expression value.
+     */
+    virtual int Compile(compiler &C)
+    {
+      // Object functions have side effects only, leave them to tree walker
+      return C.Eval(this);
+    } /* End of 'Compile' function */
+
+    /* Get scene table operands function.
+     * ARGUMENTS:
+     *   - operands: one for number, three for vector, material kind and
+     *     its library index or five values for material (out):
+     *       int *Ops;
+     * RETURNS: (int) number of operands, 0 if value isn't known per frame.
+     */
+    virtual int Operands(int *Ops)
+    {
+      if (IsConst && !IsVector)
+      {
+        double val = Eval();
+
+        if (!isfinite(val))
+          return 0;
+        Ops[0] = table::Const(val);
+        return 1;
+      }
+      return IsUniform && table::Slot(this, Ops) ? 1 : 0;
+    } /* End of 'Operands' function */
+
+    /* Get compile time values function.
+     * ARGUMENTS:
+     *   - values: one for number, three for vector (out):
+     *       double *Vals;
+     * RETURNS: (int) number of values, 0 if value depends on 'Time'.
+     */
+    virtual int Values(double *Vals)
+    {
+      if (!IsConst || IsVector || (IsLooped && loops::IsSymbolic()))
+        return 0;
+
+      double val = Eval();
+
+      if (!isfinite(val))
+        return 0;
+      Vals[0] = val;
+      return 1;
+    } /* End of 'Values' function */
+
+    /* Check is GLSL text of expression boolean function.
+     * ARGUMENTS: None.
+     * RETURNS: (bool) is comparison or logical operation of comparisons.
+     */
+    virtual bool IsBool(void)
+    {
+      return false;
+    } /* End of 'IsBool' function */
+
+    /* Check can object function be emitted in GLSL loop body function.
+     * ARGUMENTS:
+     *   - shapes events of loop body by symbol id, 1 - modified before assignment, 2 - assigned (in/out):
+     *       std::map<int, int> &Shapes;
+     * RETURNS: (bool) can expression be emitted once for all iterations.
+     */
+    virtual bool IsLoopBody(std::map<int, int> &/* Shapes */)
+    {
+      return false;
+    } /* End of 'IsLoopBody' function */
+
+    /* Update compile time state of object function.
+     * Iterations of loop emitted from syntax tree are tracked without text.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    virtual void Track(void)
+    {
+    } /* End of 'Track' function */
+
+    /* Write GLSL float literal function.
+     * ARGUMENTS:
+     *   - buffer to append text to:
+     *       std::string &Out;
+     *   - value:
+     *       double Val;
+     * RETURNS: None.
+     */
+    static void Literal(std::string &Out, double Val)
+    {
+      // Shortest text which gives the same single precision value
+      char buf[64];
+      auto res = std::to_chars(buf, buf + sizeof(buf), (float)Val);
+      std::string_view num(buf, res.ptr - buf);
+
+      if (Val < 0)
+        Out += '(';
+      Out += num;
+      if (num.find_first_of(".e") == std::string_view::npos)
+        Out += ".0";
+      if (Val < 0)
+        Out += ')';
+    } /* End of 'Literal' function */
+
     virtual ~expr() {}
   };
 
+  /* Function argument structure */
+  struct arg
+  {
+    expr *Value;      // Parsed argument, nullptr if argument is kept as text
+    std::string Text; // Argument text (textures and shape names)
+  }; /* End of 'arg' structure */
+
+  /* Fold function arguments function.
+   * ARGUMENTS:
+   *   - folding pass state:
+   *       folder &F;
+   *   - arguments:
+   *       std::vector<arg> &Args;
+   * RETURNS: None.
+   */
+  inline void FoldArgs(folder &F, std::vector<arg> &Args)
+  {
+    for (auto &a : Args)
+      if (a.Value != nullptr)
+        a.Value->Fold(F);
+  } /* End of 'FoldArgs' function */
+
+  /* Get function arguments text function.
+   * ARGUMENTS:
+   *   - arguments:
+   *       std::vector<arg> &Args;
+   * RETURNS: (std::vector<std::string>) GLSL text of arguments.
+   */
+  inline std::vector<std::string> EmitArgs(std::vector<arg> &Args)
+  {
+    std::vector<std::string> res(Args.size());
+    bool old = uniforms::SetArgs(true);
+
+    for (size_t i = 0; i < Args.size(); i++)
+      if (Args[i].Value != nullptr)
+        Args[i].Value->Emit(res[i]);
+      else
+        res[i] = Args[i].Text;
+    uniforms::SetArgs(old);
+    return res;
+  } /* End of 'EmitArgs' function */
+
   class num_expr : public expr
   {
   private:
@@ -45,11 +319,25 @@ namespace parser
 
     double Eval(void) override
     {
-      Text = std::to_string(Val);
       return Val;
     }
-    ~num_expr()
-    {}
+
+    void Write(std::string &Out) override
+    {
+      Literal(Out, Val);
+    }
+
+    bool Fold(folder &/* F */) override
+    {
+      // Literal is already folded, it isn't counted
+      IsConst = true;
+      return true;
+    }
+
+    int Compile(compiler &C) override
+    {
+      return C.Const(Val);
+    }
   };
 
   class bin_expr : public expr
@@ -65,37 +353,118 @@ namespace parser
       this->Oper = O;
     }
 
-    ~bin_expr()
-    {
-      delete E1;
-      delete E2;
-    }
 
     double Eval(void) override
     {
-      double res;
       switch (Oper)
       {
       case '+':
-        res = E1->Eval() + E2->Eval();
-        Text = "(" + E1->Text + "+" + E2->Text + ")";
-        return res;
+        return E1->Eval() + E2->Eval();
       case '-':
-        res = E1->Eval() - E2->Eval();
-        Text = "(" + E1->Text + "-" + E2->Text + ")";
-        return res;
+        return E1->Eval() - E2->Eval();
       case '*':
-        res = E1->Eval() * E2->Eval();
-        Text = "(" + E1->Text + "*" + E2->Text + ")";
-        return res;
+        return E1->Eval() * E2->Eval();
       case '/':
-        res = E1->Eval() / E2->Eval();
-        Text = "(" + E1->Text + "/" + E2->Text + ")";
-        return res;
+        return E1->Eval() / E2->Eval();
       default:
         return 0;
       }
     }
+
+    void Write(std::string &Out) override
+    {
+      Out += '(';
+      E1->Emit(Out);
+      Out += Oper;
+      E2->Emit(Out);
+      Out += ')';
+    }
+
+    bool Fold(folder &F) override
+    {
+      bool
+        a = E1->Fold(F),
+        b = E2->Fold(F);
+
+      return SetFold(F, a && b, E1->IsVector || E2->IsVector, IsPerFrame(E1) && IsPerFrame(E2),
+        E1->IsLooped || E2->IsLooped);
+    }
+
+    int Operands(int *Ops) override
+    {
+      if (!IsVector)
+        return expr::Operands(Ops);
+
+      // Vector arithmetic is done on compile time, constant operands only
+      int a[3], b[3], n = E2->Operands(b);
+
+      if (E1->Operands(a) != 3 || (n != 1 && n != 3))
+        return 0;
+      for (int i = 0; i < 3; i++)
+      {
+        int j = n == 3 ? b[i] : b[0];
+
+        if (a[i] < 0 || j < 0)
+          return 0;
+
+        float
+          x = table::Value(a[i]),
+          y = table::Value(j),
+          r = Oper == '+' ? x + y : Oper == '-' ? x - y : Oper == '*' ? x * y : x / y;
+
+        if (!isfinite(r))
+          return 0;
+        Ops[i] = table::Const(r);
+      }
+      return 3;
+    }
+
+    int Values(double *Vals) override
+    {
+      if (!IsVector)
+        return expr::Values(Vals);
+
+      double a[3], b[3];
+      int
+        na = E1->Values(a),
+        nb = E2->Values(b);
+
+      if ((na != 1 && na != 3) || (nb != 1 && nb != 3))
+        return 0;
+      for (int i = 0; i < 3; i++)
+      {
+        double
+          x = na == 3 ? a[i] : a[0],
+          y = nb == 3 ? b[i] : b[0],
+          r = Oper == '+' ? x + y : Oper == '-' ? x - y : Oper == '*' ? x * y : x / y;
+
+        if (!isfinite(r))
+          return 0;
+        Vals[i] = r;
+      }
+      return 3;
+    }
+
+    int Compile(compiler &C) override
+    {
+      int
+        a = E1->Compile(C),
+        b = E2->Compile(C);
+
+      switch (Oper)
+      {
+      case '+':
+        return C.Op(opcode::eAdd, a, b);
+      case '-':
+        return C.Op(opcode::eSub, a, b);
+      case '*':
+        return C.Op(opcode::eMul, a, b);
+      case '/':
+        return C.Op(opcode::eDiv, a, b);
+      default:
+        return C.Const(0);
+      }
+    }
   };
 
   class cond_expr : public expr
@@ -124,53 +493,71 @@ namespace parser
       this->Type = O;
     }
 
-    ~cond_expr()
-    {
-      delete E1;
-      delete E2;
-    }
 
     double Eval(void) override
     {
-      double res;
       switch (Type)
       {
       case oper_type::eLT:
-        res = E1->Eval() < E2->Eval();
-        Text = "(" + E1->Text + "<" + E2->Text + ")";
-        return res;
+        return E1->Eval() < E2->Eval();
       case oper_type::eGT:
-        res = E1->Eval() > E2->Eval();
-        Text = "(" + E1->Text + ">" + E2->Text + ")";
-        return res;
+        return E1->Eval() > E2->Eval();
       case oper_type::eLTEQ:
-        res = E1->Eval() <= E2->Eval();
-        Text = "(" + E1->Text + "<=" + E2->Text + ")";
-        return res;
+        return E1->Eval() <= E2->Eval();
       case oper_type::eGTEQ:
-        res = E1->Eval() >= E2->Eval();
-        Text = "(" + E1->Text + ">=" + E2->Text + ")";
-        return res;
+        return E1->Eval() >= E2->Eval();
       case oper_type::eEQ:
-        res = E1->Eval() == E2->Eval();
-        Text = "(" + E1->Text + "==" + E2->Text + ")";
-        return res;
+        return E1->Eval() == E2->Eval();
       case oper_type::eNOTEQ:
-        res = E1->Eval() != E2->Eval();
-        Text = "(" + E1->Text + "!=" + E2->Text + ")";
-        return res;
+        return E1->Eval() != E2->Eval();
       case oper_type::eAND:
-        res = E1->Eval() && E2->Eval();
-        Text = "(" + E1->Text + "&&" + E2->Text + ")";
-        return res;
+        return E1->Eval() && E2->Eval();
       case oper_type::eOR:
-        res = E1->Eval() || E2->Eval();
-        Text = "(" + E1->Text + "||" + E2->Text + ")";
-        return res;
+        return E1->Eval() || E2->Eval();
       default:
         return 0;
       }
     }
+
+    void Write(std::string &Out) override
+    {
+      static const char *Opers[] = {"==", "!=", "<", "<=", ">", ">=", "&&", "||"};
+
+      Out += '(';
+      E1->Emit(Out);
+      Out += Opers[Type];
+      E2->Emit(Out);
+      Out += ')';
+    }
+
+    bool Fold(folder &F) override
+    {
+      bool
+        a = E1->Fold(F),
+        b = E2->Fold(F);
+
+      return SetFold(F, a && b, false, IsPerFrame(E1) && IsPerFrame(E2),
+        E1->IsLooped || E2->IsLooped);
+    }
+
+    int Compile(compiler &C) override
+    {
+      static const opcode Ops[] =
+      {
+        opcode::eEQ, opcode::eNOTEQ, opcode::eLT, opcode::eLTEQ,
+        opcode::eGT, opcode::eGTEQ, opcode::eAnd, opcode::eOr
+      };
+      int
+        a = E1->Compile(C),
+        b = E2->Compile(C);
+
+      return C.Op(Ops[Type], a, b);
+    }
+
+    bool IsBool(void) override
+    {
+      return Type < eAND || (E1->IsBool() && E2->IsBool());
+    }
   };
 
 
@@ -186,163 +573,523 @@ namespace parser
       this->Oper = O;
     }
 
-    ~un_expr()
-    {
-      delete E;
-    }
 
     double Eval(void) override
     {
-      double res;
       switch (Oper)
       {
       case '-':
-        res = -E->Eval();
-        Text = "-" + E->Text;
-        return res;
+        return -E->Eval();
       case '+':
         return E->Eval();
       default:
         return 0;
       }
     }
+
+    void Write(std::string &Out) override
+    {
+      if (Oper == '-')
+        Out += '-';
+      E->Emit(Out);
+    }
+
+    bool Fold(folder &F) override
+    {
+      bool is_const = E->Fold(F);
+
+      return SetFold(F, is_const, E->IsVector, IsPerFrame(E), E->IsLooped);
+    }
+
+    int Compile(compiler &C) override
+    {
+      int a = E->Compile(C);
+
+      switch (Oper)
+      {
+      case '-':
+        return C.Op(opcode::eNeg, a);
+      case '+':
+        return a;
+      default:
+        return C.Const(0);
+      }
+    }
   };
 
   class const_expr : public expr
   {
   private:
-    std::string Name;
+    int Id; // Variable symbol
   public:
-    const_expr(std::string Name) : Name(Name)
+    const_expr(int Id) : Id(Id)
+    {
+    }
+
+    double Eval(void) override
     {
+      return variables::Get(Id).Val;
     }
 
-    ~const_expr()
+    void Write(std::string &Out) override
     {
-      Name.clear();
+      // Function body can't see variables of scene, only values folded to literals
+      if (!functions::IsVisible(Id))
+        throw std::runtime_error(std::format("function can't read scene variable '{}', pass it as parameter!",
+          symbols::GetName(Id)));
+      Out += symbols::GetName(Id);
+      file::Use(file::Name(Id));
     }
 
-    double Eval(void) override
+    bool Fold(folder &F) override
+    {
+      var_type type = var_type::eFloat;
+
+      variables::GetType(Id, &type);
+      return SetFold(F, !F.IsDynamic(Id), type != var_type::eInt && type != var_type::eFloat, F.IsTime(Id),
+        F.IsLooped(Id));
+    }
+
+    int Operands(int *Ops) override
+    {
+      // Vectors and materials are taken as they were last assigned
+      if (IsVector)
+        return table::GetVar(Id, Ops);
+      return expr::Operands(Ops);
+    }
+
+    int Values(double *Vals) override
+    {
+      if (IsVector)
+        return bounds::GetVar(Id, Vals);
+      return expr::Values(Vals);
+    }
+
+    bool IsLeaf(void) override
+    {
+      return true;
+    }
+
+    int Compile(compiler &C) override
     {
-      Text = Name;
-      return variables::Get(Name).Val;
+      // Frame program takes other variables with their current value
+      if (C.IsFrame() && IsConst)
+        return C.Const(Eval());
+      return C.Slot(Id);
     }
   };
 
   class shape_expr : public expr
   {
   private:
-    std::vector<std::string> Params;
+    std::vector<arg> Params;
     obj::shape::type Type;
-    std::string Var;
+    int Var;
     bool IsTex;
 
   public:
-    shape_expr(std::string VarName, obj::shape::type Type, std::vector<std::string> Args, bool IsTex) :
-      Var(VarName), Type(Type), IsTex(IsTex)
+    shape_expr(int VarId, obj::shape::type Type, std::vector<arg> Args, bool IsTex) :
+      Type(Type), Var(VarId), IsTex(IsTex)
     {
       Params = std::move(Args);
     }
 
-    ~shape_expr()
+    double Eval(void) override
+    {
+      const std::string &var = symbols::GetName(Var);
+
+      // Arguments text records names it reads to chunk
+      file::Mark(Var);
+
+      std::vector<std::string> args = EmitArgs(Params);
+      std::string tmp = obj::shape::ToStr.at(Type)(var, args);
+      std::vector<int> uses = file::GetUses();
+      // Compile time state of GLSL loop body is updated by 'Track'
+      bool is_loop = loops::IsSymbolic();
+
+      if (is_loop)
+        variables::Keep(Var);
+      else
+        bounds::Shape(Var, Type, Params);
+      variables::SetShape(Var, tmp, std::move(uses), obj::shape::GetMtl(Type, args, IsTex));
+      // Primitive is centered at its first vector argument, segment shapes aren't
+      bool is_center = obj::shape::Types.at(Type)[0] == param::type::eVec &&
+        Type != obj::shape::type::eCylinder && Type != obj::shape::type::eCapsule;
+
+      file::Print(std::format("// apply SDF function to '{}'", var));
+      file::Print(bounds::Guard(Var, chains::Scale(Var, tmp), is_center ? args[0] : ""));
+      Material(Var);
+      if (!is_loop)
+        table::Shape(Var, Type, Params, IsTex);
+
+      return 0;
+    }
+
+    void Track(void) override
+    {
+      std::string buf;
+      std::vector<file::chunk> marks;
+
+      // Text of iteration is built aside, shape keeps it after loop
+      file::Swap(buf, marks);
+      file::Mark(Var);
+
+      std::vector<std::string> args = EmitArgs(Params);
+      std::string tmp = obj::shape::ToStr.at(Type)(symbols::GetName(Var), args);
+      std::vector<int> uses = file::GetUses();
+
+      file::Swap(buf, marks);
+      bounds::Shape(Var, Type, Params);
+      variables::SetShape(Var, tmp, std::move(uses), obj::shape::GetMtl(Type, args, IsTex));
+      table::Shape(Var, Type, Params, IsTex);
+    }
+
+    bool IsLoopBody(std::map<int, int> &Shapes) override
     {
+      Shapes[Var] |= 2;
+      return true;
+    }
+
+    /* Emit material of primitive function.
+     * Material has its own chunk after evaluation, so it is swept
+     * if nothing reads it (scene takes it by index at the end).
+     * ARGUMENTS:
+     *   - shape variable symbol id:
+     *       int Var;
+     * RETURNS: None.
+     */
+    static void Material(int Var)
+    {
+      obj::shape::mtl &m = variables::GetShapeMtl(Var);
+
+      if (m.Text.empty())
+        return;
+
+      const std::string &var = symbols::GetName(Var);
+
+      file::Mark(Var);
+      for (int u : variables::GetShapeUses(Var))
+        file::Use(u);
+      // Texture coordinates are written with distance
+      if (m.Tex >= 0)
+        file::Use(file::Name(Var));
+      file::Print(std::format("// set material of '{}'\n", var) + param::MtlOnly(obj::shape::MtlStr("mtl_" + var, var, m)));
+      file::Set(file::Name(Var, file::facet::eMtl));
+      m.Write = file::GetWrite();
+    } /* End of 'Material' function */
+
+    bool Fold(folder &F) override
+    {
+      FoldArgs(F, Params);
+      return false;
+    }
+  };
+
+  class call_expr : public expr
+  {
+  private:
+    std::vector<arg> Params;
+    int Var;  // Result shape variable symbol
+    int Func; // Scene function index
+
+  public:
+    call_expr(int VarId, int Func, std::vector<arg> Args) :
+      Var(VarId), Func(Func)
+    {
+      Params = std::move(Args);
     }
 
     double Eval(void) override
     {
-      std::string tmp = std::format("{}", obj::shape::ToStr.at(Type)(Var, Params, IsTex));
+      const std::string &var = symbols::GetName(Var);
 
-      file::Print(std::format("// apply SDF function to '{}'", Var));
-      file::Print(tmp);
-      variables::SetShape(Var, tmp);
+      // Arguments text records names it reads to chunk
+      file::Mark(Var);
+
+      std::string tmp = functions::Call(Func, Var, EmitArgs(Params));
+      std::vector<int> uses = file::GetUses();
+
+      bounds::Call(Var, Func);
+      variables::SetShape(Var, tmp, std::move(uses));
+      file::Print(std::format("// apply function '{}' to '{}'", symbols::GetName(functions::GetName(Func)), var));
+      file::Print(bounds::Guard(Var, chains::Scale(Var, tmp)));
+      table::Call(Var, Func);
 
       return 0;
     }
+
+    bool Fold(folder &F) override
+    {
+      FoldArgs(F, Params);
+      return false;
+    }
   };
 
   class mod_expr : public expr
   {
   private:
-    std::vector<std::string> Params;
+    std::vector<arg> Params;
     obj::mod::type Type;
-    std::string Var;
+    int Var;
 
   public:
-    mod_expr(std::string VarName, obj::mod::type Type, std::vector<std::string> Args) :
-      Var(VarName), Type(Type)
+    mod_expr(int VarId, obj::mod::type Type, std::vector<arg> Args) :
+      Type(Type), Var(VarId)
     {
       Params = std::move(Args);
     }
 
-    ~mod_expr()
-    {}
-
     double Eval(void) override
     {
-      file::Print(std::format("// apply modification function to '{}'", Var));
-      file::Print(std::format("{}", obj::mod::ToStr.at(Type)(Var, Params)));
+      const std::string &var = symbols::GetName(Var);
+      bool is_loop = loops::IsSymbolic();
+
+      if (!is_loop)
+        bounds::Mod(Var, Type, Params);
+      file::Mark(Var);
+      file::Print(std::format("// apply modification function to '{}'", var));
+      file::Print(chains::Mod(Var, Type, Params));
+      // Shape is evaluated by its own chunk, so evaluations overwritten by next modification are swept
+      file::Mark(Var);
+      // Shape text reads the same names its arguments did
+      for (int u : variables::GetShapeUses(Var))
+        file::Use(u);
+      file::Print(std::format("// evaluate modified '{}'", var));
+      file::Print(bounds::Guard(Var, chains::Scale(Var, variables::GetShape(Var))));
+      // Texture coordinates are changed by evaluation
+      shape_expr::Material(Var);
+      if (!is_loop)
+        table::Mod(Var, Type, Params);
       return 0;
     }
+
+    void Track(void) override
+    {
+      bounds::Mod(Var, Type, Params);
+      table::Mod(Var, Type, Params);
+    }
+
+    bool IsLoopBody(std::map<int, int> &Shapes) override
+    {
+      // Scale changes distance factor, which is known on compile time
+      if (Type == obj::mod::type::eScale)
+        return false;
+      // Modification before assignment evaluates text of shape assigned in previous iteration
+      Shapes.try_emplace(Var, 1);
+      return true;
+    }
+
+    bool Fold(folder &F) override
+    {
+      FoldArgs(F, Params);
+      return false;
+    }
   };
 
   class oper_expr : public expr
   {
   private:
     obj::oper::type Type;
-    std::string Var, P1, P2;
-    std::optional<std::string> K;
+    int Var;
+    std::vector<std::string> Ps; // Operands shape names, union takes any number of them
+    expr *K = nullptr;
 
   public:
-    oper_expr(std::string VarName, obj::oper::type Type, std::vector<std::string> Args) :
-      Var(VarName), Type(Type), P1(P1), P2(P2), K(K)
+    oper_expr(int VarId, obj::oper::type Type, std::vector<arg> Args) :
+      Type(Type), Var(VarId)
     {
       int s = (int)Args.size();
 
-      if (s < 2 || s > 3)
-        throw std::exception("incorrect count of parameters!");
-      P1 = Args[0];
-      P2 = Args[1];
+      if (s < 2)
+        throw std::runtime_error("incorrect count of parameters!");
+      if (Args.back().Value != nullptr)
+        K = Args[--s].Value;
+      for (int i = 0; i < s; i++)
+        Ps.push_back(Args[i].Text);
+      if (Ps.size() < 2 || (Ps.size() > 2 && Type != obj::oper::type::eUnion && Type != obj::oper::type::eUnionSmth))
+        throw std::runtime_error("incorrect count of parameters!");
+
+      const std::string &var = symbols::GetName(Var);
+      auto self = std::find(Ps.begin(), Ps.end(), var);
+
+      if (!variables::IsExists(Var) && self != Ps.end())
+        throw std::runtime_error("incorrect parameters!");
+      // Result is written by every step of n-ary union, so it is read first
+      if (self != Ps.end() && self - Ps.begin() >= 2)
+        std::rotate(Ps.begin(), self, self + 1);
+    }
 
-      if (s == 3)
-        K = Args[2];
+    double Eval(void) override
+    {
+      const std::string &var = symbols::GetName(Var);
+      std::optional<std::string> k;
+      obj::oper::type type = Type;
+      expr *coef = K;
+      double kv = 0;
+
+      // Values of constant coefficient are known on compile time only
+      if (K != nullptr && K->IsConst && !K->IsVector && (kv = K->Eval()) == 0)
+      {
+        type = Type == obj::oper::type::eUnionSmth ? obj::oper::type::eUnion :
+          Type == obj::oper::type::eDiffSmth ? obj::oper::type::eDiff : obj::oper::type::eInter;
+        coef = nullptr;
+        obj::oper::Count(obj::oper::simp::eZeroK);
+      }
+      obj::oper::Count();
+
+      const std::string *same = Ps.size() > 2 ? nullptr : Same(type, coef, kv);
 
-      if (!variables::IsExists(Var) && (Var == P1 || Var == P2))
-        throw std::exception("incorrect parameters!");
+      if (same != nullptr)
+      {
+        std::string text = obj::oper::Copy(var, *same);
+
+        if (!text.empty())
+        {
+          file::Mark(Var);
+          file::Print(std::format("// apply operation to '{}', result is '{}'", var, *same));
+          file::Print(text);
+          Access({*same});
+        }
+      }
+      else
+      {
+        file::Mark(Var);
+        if (coef != nullptr)
+        {
+          bool old = uniforms::SetArgs(true);
+
+          coef->Emit(k.emplace());
+          uniforms::SetArgs(old);
+        }
+        file::Print(std::format("// apply operation to '{}'", var));
+        if (Ps.size() == 2)
+          file::Print(obj::oper::ToStr.at(type)(var, Ps[0], Ps[1], k));
+        else if (type == obj::oper::type::eUnion)
+          file::Print(obj::oper::Nary(var, Ps));
+        else
+        {
+          std::string text;
+
+          // Smooth union blends materials of each step as binary one does
+          for (size_t i = 1; i < Ps.size(); i++)
+            text += obj::oper::ToStr.at(type)(var, i == 1 ? Ps[0] : var, Ps[i], k);
+          file::Print(text);
+        }
+        Access(Ps);
+      }
+      // N-ary union is a chain of unions for other passes
+      for (size_t i = 1; i < Ps.size(); i++)
+      {
+        table::Oper(Var, type, i == 1 ? Ps[0] : var, Ps[i], coef);
+        bounds::Oper(Var, type, i == 1 ? Ps[0] : var, Ps[i], coef);
+      }
+      return 0;
     }
 
-    ~oper_expr()
-    {}
+    /* Record names operation text accesses function.
+     * Result distance and material are assigned after all operands are read.
+     * ARGUMENTS:
+     *   - operands shape names:
+     *       const std::vector<std::string> &Ops;
+     * RETURNS: None.
+     */
+    void Access(const std::vector<std::string> &Ops)
+    {
+      for (auto &p : Ops)
+      {
+        int id = symbols::Find(p);
 
-    double Eval(void) override
+        file::Use(file::Name(id));
+        file::Use(file::Name(id, file::facet::eMtl));
+      }
+      file::Set(file::Name(Var));
+      file::Set(file::Name(Var, file::facet::eMtl));
+    } /* End of 'Access' function */
+
+    /* Find operand equal to operation result function.
+     * ARGUMENTS:
+     *   - operation type:
+     *       obj::oper::type Type;
+     *   - smoothness coefficient and its value if it is constant:
+     *       expr *Coef;
+     *       double Val;
+     * RETURNS: (const std::string *) operand name, nullptr if result isn't one of operands.
+     */
+    const std::string * Same(obj::oper::type Type, expr *Coef, double Val)
     {
-      file::Print(std::format("// apply operation to '{}'", Var));
-      file::Print(std::format("{}", obj::oper::ToStr.at(Type)(Var, P1, P2, K)));
-      return 0;
+      const std::string &a = Ps[0], &b = Ps[1];
+      int
+        p1 = symbols::Find(a),
+        p2 = symbols::Find(b);
+
+      if ((Type == obj::oper::type::eUnion || Type == obj::oper::type::eInter) && a == b)
+      {
+        obj::oper::Count(obj::oper::simp::eSame);
+        return &a;
+      }
+      // Smooth operations change operand closer than coefficient to other one only
+      bool is_known = Coef == nullptr || (Coef->IsConst && !Coef->IsVector);
+
+      if ((Type == obj::oper::type::eUnion || Type == obj::oper::type::eUnionSmth) && is_known)
+      {
+        if (bounds::IsInside(p2, p1, fabs(Val)))
+        {
+          obj::oper::Count(obj::oper::simp::eInside);
+          return &a;
+        }
+        if (bounds::IsInside(p1, p2, fabs(Val)))
+        {
+          obj::oper::Count(obj::oper::simp::eInside);
+          return &b;
+        }
+      }
+      if ((Type == obj::oper::type::eDiff || Type == obj::oper::type::eDiffSmth) && is_known && bounds::IsApart(p1, p2, fabs(Val)))
+      {
+        obj::oper::Count(obj::oper::simp::eApart);
+        return &a;
+      }
+      return nullptr;
+    } /* End of 'Same' function */
+
+    bool Fold(folder &F) override
+    {
+      for (size_t i = 1; i < Ps.size(); i++)
+        bounds::Use(Var, Type, Ps[0], Ps[i]);
+      if (K != nullptr)
+        K->Fold(F);
+      return false;
     }
   };
 
   class light_expr : public expr
   {
   private:
-    std::vector<std::string> Params;
+    std::vector<arg> Params;
     obj::light::type Type;
-    std::string Var;
+    int Var;
 
   public:
-    light_expr(std::string VarName, obj::light::type Type, std::vector<std::string> Args) :
-      Var(VarName), Type(Type)
+    light_expr(int VarId, obj::light::type Type, std::vector<arg> Args) :
+      Type(Type), Var(VarId)
     {
       Params = std::move(Args);
     }
 
-    ~light_expr()
-    {}
-
     double Eval(void) override
     {
-      obj::light::Add.at(Type)(Var, Params);
+      // Light arrays are global constants, they can't read frame uniforms
+      uniforms::Enable(false);
+      obj::light::Add.at(Type)(Var, EmitArgs(Params));
+      uniforms::Enable(true);
+      table::Light(Var, Type, Params);
       return 0;
     }
+
+    bool Fold(folder &F) override
+    {
+      FoldArgs(F, Params);
+      return false;
+    }
   };
 
   class sin_expr : public expr
@@ -355,16 +1102,29 @@ namespace parser
     {
     }
 
-    ~sin_expr()
+
+    double Eval(void) override
     {
-      delete E;
+      return sin(E->Eval());
     }
 
-    double Eval(void) override
+    void Write(std::string &Out) override
     {
-      double val = E->Eval();
-      Text = std::format("sin({0})", E->Text);
-      return sin(val);
+      Out += "sin(";
+      E->Emit(Out);
+      Out += ')';
+    }
+
+    bool Fold(folder &F) override
+    {
+      bool is_const = E->Fold(F);
+
+      return SetFold(F, is_const, false, IsPerFrame(E), E->IsLooped);
+    }
+
+    int Compile(compiler &C) override
+    {
+      return C.Op(opcode::eSin, E->Compile(C));
     }
   };
 
@@ -378,16 +1138,29 @@ namespace parser
     {
     }
 
-    ~cos_expr()
+
+    double Eval(void) override
     {
-      delete E;
+      return cos(E->Eval());
     }
 
-    double Eval(void) override
+    void Write(std::string &Out) override
     {
-      double val = E->Eval();
-      Text = std::format("cos({0})", E->Text);
-      return cos(val);
+      Out += "cos(";
+      E->Emit(Out);
+      Out += ')';
+    }
+
+    bool Fold(folder &F) override
+    {
+      bool is_const = E->Fold(F);
+
+      return SetFold(F, is_const, false, IsPerFrame(E), E->IsLooped);
+    }
+
+    int Compile(compiler &C) override
+    {
+      return C.Op(opcode::eCos, E->Compile(C));
     }
   };
 
@@ -401,16 +1174,29 @@ namespace parser
     {
     }
 
-    ~abs_expr()
+
+    double Eval(void) override
     {
-      delete E;
+      return fabs(E->Eval());
     }
 
-    double Eval(void) override
+    void Write(std::string &Out) override
     {
-      double val = E->Eval();
-      Text = std::format("abs({0})", E->Text);
-      return fabs(val);
+      Out += "abs(";
+      E->Emit(Out);
+      Out += ')';
+    }
+
+    bool Fold(folder &F) override
+    {
+      bool is_const = E->Fold(F);
+
+      return SetFold(F, is_const, false, IsPerFrame(E), E->IsLooped);
+    }
+
+    int Compile(compiler &C) override
+    {
+      return C.Op(opcode::eAbs, E->Compile(C));
     }
   };
 
@@ -424,19 +1210,38 @@ namespace parser
     {
     }
 
-    ~fmod_expr()
+
+    double Eval(void) override
     {
-      delete E1;
-      delete E2;
+      return fmod(E1->Eval(), E2->Eval());
     }
 
-    double Eval(void) override
+    void Write(std::string &Out) override
     {
-      double
-        val1 = E1->Eval(),
-        val2 = E2->Eval();
-      Text = std::format("mod({0}, {1})", E1->Text, E2->Text);
-      return fmod(val1, val2);
+      Out += "mod(";
+      E1->Emit(Out);
+      Out += ", ";
+      E2->Emit(Out);
+      Out += ')';
+    }
+
+    bool Fold(folder &F) override
+    {
+      bool
+        a = E1->Fold(F),
+        b = E2->Fold(F);
+
+      return SetFold(F, a && b, false, IsPerFrame(E1) && IsPerFrame(E2),
+        E1->IsLooped || E2->IsLooped);
+    }
+
+    int Compile(compiler &C) override
+    {
+      int
+        a = E1->Compile(C),
+        b = E2->Compile(C);
+
+      return C.Op(opcode::eMod, a, b);
     }
   };
 
@@ -460,29 +1265,73 @@ namespace parser
         C = Args[2];
       }
       else
-        throw std::exception("incorrect count of parameters!");
+        throw std::runtime_error("incorrect count of parameters!");
+    }
+
+    double Eval(void) override
+    {
+      return 0;
     }
-    ~vec_expr()
+
+    void Write(std::string &Out) override
     {
+      Out += "vec3(";
+      A->Emit(Out);
       if (s == 1)
-        delete A;
-      else if (s == 3)
       {
-        delete A;
-        delete B;
-        delete C;
+        Out += ')';
+        return;
       }
-      
+      Out += ", ";
+      B->Emit(Out);
+      Out += ", ";
+      C->Emit(Out);
+      Out += ')';
     }
 
-    double Eval(void) override
+    bool Fold(folder &F) override
     {
-      double
-        a = A->Eval(),
-        b = B->Eval(),
-        c = C->Eval();
-      Text = std::format("vec3({0}, {1}, {2})", A->Text, B->Text, C->Text);
-      return 0;
+      bool is_const = A->Fold(F);
+
+      // Single component is shared by all three
+      if (s == 3)
+      {
+        bool
+          b = B->Fold(F),
+          c = C->Fold(F);
+
+        is_const = is_const && b && c;
+      }
+      return SetFold(F, is_const, true);
+    }
+
+    int Operands(int *Ops) override
+    {
+      if (A->Operands(Ops) != 1)
+        return 0;
+      if (s == 1)
+      {
+        Ops[1] = Ops[2] = Ops[0];
+        return 3;
+      }
+      return B->Operands(Ops + 1) == 1 && C->Operands(Ops + 2) == 1 ? 3 : 0;
+    }
+
+    int Values(double *Vals) override
+    {
+      if (A->Values(Vals) != 1)
+        return 0;
+      if (s == 1)
+      {
+        Vals[1] = Vals[2] = Vals[0];
+        return 3;
+      }
+      return B->Values(Vals + 1) == 1 && C->Values(Vals + 2) == 1 ? 3 : 0;
+    }
+
+    int Compile(compiler &Comp) override
+    {
+      return Comp.Const(0);
     }
   };
 
@@ -490,49 +1339,77 @@ namespace parser
   {
   private:
     expr* Alb, * Rough, * Met;
-    bool IsLib;
-    std::string Mat;
+    expr* Index = nullptr; // Material library index
 
   public:
-    mtl_expr(expr *A, expr *R, expr *M, bool Is = false, std::string Text = "")
+    mtl_expr(expr *A, expr *R, expr *M) : Alb(A), Rough(R), Met(M)
     {
-      Alb = A;
-      Rough = R;
-      Met = M;
-
-      IsLib = Is;
-      Mat = Text;
     }
-    ~mtl_expr()
+
+    mtl_expr(expr *LibIndex) : Alb(nullptr), Rough(nullptr), Met(nullptr), Index(LibIndex)
     {
-      if (!IsLib)
-      {
-        delete Alb;
-        delete Rough;
-        delete Met;
-      }
     }
 
     double Eval(void) override
     {
-      if (!IsLib)
+      return 0;
+    }
+
+    void Write(std::string &Out) override
+    {
+      if (Index != nullptr)
       {
-        double
-          a = Alb->Eval(),
-          b = Rough->Eval(),
-          c = Met->Eval();
-        Text = std::format("mtl({0}, {1}, {2})", Alb->Text, Rough->Text, Met->Text);
+        if (Index->IsConst && !(Index->IsLooped && loops::IsSymbolic()) && isfinite(Index->Eval()))
+          Out += std::format("MtlLib[{}]", (int)Index->Eval());
+        else
+        {
+          Out += "MtlLib[int(";
+          Index->Emit(Out);
+          Out += ")]";
+        }
+        return;
       }
-      else
-        Text = Mat;
+      bool old = uniforms::SetArgs(true);
+
+      Out += "mtl(";
+      Alb->Emit(Out);
+      Out += ", ";
+      Rough->Emit(Out);
+      Out += ", ";
+      Met->Emit(Out);
+      Out += ')';
+      uniforms::SetArgs(old);
+    }
 
-//      file::Print(Text);
-      
-      return 0;
+    bool Fold(folder &F) override
+    {
+      if (Index != nullptr)
+        return SetFold(F, Index->Fold(F), true);
+
+      bool
+        a = Alb->Fold(F),
+        r = Rough->Fold(F),
+        m = Met->Fold(F);
+
+      return SetFold(F, a && r && m, true);
+    }
+
+    int Operands(int *Ops) override
+    {
+      // Library material is kind 0, material given by values is kind 1
+      Ops[0] = Index == nullptr;
+      if (Index != nullptr)
+        return Index->Operands(Ops + 1) == 1 ? 2 : 0;
+      return Alb->Operands(Ops + 1) == 3 && Rough->Operands(Ops + 4) == 1 && Met->Operands(Ops + 5) == 1 ? 6 : 0;
+    }
+
+    int Compile(compiler &C) override
+    {
+      return C.Const(0);
     }
   };
 }
 
 #endif
 
-/* END OF 'expr.h' FILE */
\ No newline at end of file
+/* END OF 'expr.h' FILE */
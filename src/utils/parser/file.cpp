@@ -7,7 +7,7 @@
  * PURPOSE     : Ray marching project.
  *               Parser module.
  * PROGRAMMER  : Vladislav Biserov.
- * LAST UPDATE : 30.03.2023
+ * LAST UPDATE : 01.04.2023
  * NOTE        : None.
  *
  * No part of this file may be changed without agreement of
@@ -16,6 +16,15 @@
 
 #include "file.h"
 
-std::string parser::file::CurBuf = "";
+thread_local std::string parser::file::CurBuf = "";
+thread_local std::vector<parser::file::chunk> parser::file::Chunks;
+thread_local std::vector<int> parser::file::Writes;
+thread_local int parser::file::WriteNo = 0;
+std::mutex parser::file::Lock;
+std::unordered_map<std::string, size_t> parser::file::Hashes;
+thread_local std::string
+  parser::file::Last,
+  parser::file::LastKey;
+thread_local std::string parser::report::Buf = "";
 
 /* END OF 'file.cpp' FILE */
\ No newline at end of file
@@ -7,7 +7,7 @@
   * PURPOSE     : Ray marching project.
   *               Parser module.
   * PROGRAMMER  : Vladislav Biserov.
-  * LAST UPDATE : 30.03.2023
+  * LAST UPDATE : 02.04.2023
   * NOTE        : None.
   *
   * No part of this file may be changed without agreement of
@@ -18,16 +18,176 @@
 #define __file_h_
 
 #include <fstream>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <unordered_map>
+#include <vector>
 #include <format>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace parser
 {
+  /* Read-only memory mapped file class */
+  class mapping
+  {
+  private:
+#ifdef _WIN32
+    HANDLE hFile = INVALID_HANDLE_VALUE; // File handle
+    HANDLE hMap = nullptr;               // File mapping handle
+#endif
+    const char *Data = nullptr;          // Mapped view
+    size_t Size = 0;                     // View size in bytes
+
+  public:
+    /* Map file constructor.
+     * ARGUMENTS:
+     *   - file name:
+     *       const std::string &Name;
+     */
+    mapping(const std::string &Name)
+    {
+#ifdef _WIN32
+      hFile = CreateFileA(Name.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+      if (hFile == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("incorrect file!");
+
+      LARGE_INTEGER len;
+      GetFileSizeEx(hFile, &len);
+      Size = (size_t)len.QuadPart;
+
+      // Empty files can't be mapped
+      if (Size == 0)
+        return;
+      hMap = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (hMap != nullptr)
+        Data = (const char *)MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+      if (Data == nullptr)
+      {
+        Close();
+        throw std::runtime_error("can't map file!");
+      }
+#else
+      int fd = open(Name.c_str(), O_RDONLY);
+      struct stat st;
+
+      if (fd < 0)
+        throw std::runtime_error("incorrect file!");
+      if (fstat(fd, &st) == 0 && st.st_size > 0)
+      {
+        Size = (size_t)st.st_size;
+        void *p = mmap(nullptr, Size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (p != MAP_FAILED)
+          Data = (const char *)p, madvise(p, Size, MADV_SEQUENTIAL);
+      }
+      close(fd);
+      if (Size != 0 && Data == nullptr)
+        throw std::runtime_error("can't map file!");
+#endif
+    } /* End of 'mapping' constructor */
+
+    mapping(const mapping &) = delete;
+    mapping & operator=(const mapping &) = delete;
+
+    /* Unmap file destructor */
+    ~mapping()
+    {
+      Close();
+    } /* End of 'mapping' destructor */
+
+    /* Unmap file function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    void Close(void)
+    {
+#ifdef _WIN32
+      if (Data != nullptr)
+        UnmapViewOfFile(Data);
+      if (hMap != nullptr)
+        CloseHandle(hMap);
+      if (hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(hFile);
+      hMap = nullptr;
+      hFile = INVALID_HANDLE_VALUE;
+#else
+      if (Data != nullptr)
+        munmap((void *)Data, Size);
+#endif
+      Data = nullptr;
+      Size = 0;
+    } /* End of 'Close' function */
+
+    /* Get mapped text function.
+     * ARGUMENTS: None.
+     * RETURNS: (std::string_view) whole file contents.
+     */
+    std::string_view View(void) const
+    {
+      if (Data == nullptr)
+        return {};
+      return std::string_view(Data, Size);
+    } /* End of 'View' function */
+  }; /* End of 'mapping' class */
+
   class file
   {
+  public:
+    /* Output name part of variable */
+    enum class facet
+    {
+      eVal, // Variable itself (distance of shape)
+      eMod, // Point of shape 'mod_'
+      eMtl, // Material of shape 'mtl_'
+    };
+
+    static constexpr int
+      Res = -1,      // 'res' output name
+      SceneMtl = -2, // 'Mtl' output name
+      ResId = -3;    // 'res_id' output name
+
+    /* Output name access structure */
+    struct access
+    {
+      enum kind
+      {
+        eKill, // Name assigned unconditionally
+        eDef,  // Name assigned partially or conditionally
+        eUse,  // Name read
+      } Kind;
+      int Name; // Output name (see 'Name')
+    }; /* End of 'access' structure */
+
+    /* Output chunk structure */
+    struct chunk
+    {
+      size_t Start;            // Text start offset in buffer
+      int Owner;               // Variable symbol the text belongs to, -1 for scene root
+      bool IsDecl;             // Is declaration of owner
+      int Loop;                // 1 starts GLSL loop body (2 if it may run no times), -1 ends it, 0 for statements
+      std::vector<access> Acc; // Names accessed by text in statements order
+    }; /* End of 'chunk' structure */
+
   private:
-    static std::string CurBuf;
+    static thread_local std::string CurBuf;
+    static thread_local std::vector<chunk> Chunks;
+    static thread_local std::vector<int> Writes;           // Last assignment number by output name
+    static thread_local int WriteNo;                       // Assignments recorded
+    static std::mutex Lock;                                // Written shaders guard, shared by all threads
+    static std::unordered_map<std::string, size_t> Hashes; // Last written shader hash by file name
+    static thread_local std::string Last, LastKey;         // Last shader text and key of this thread
 
     file() {}
     ~file()
@@ -40,35 +200,273 @@ namespace parser
       CurBuf += Data + "\n";
     }
 
-    static void PrintFile(const std::string& InName, const std::string& OutName,
-      const std::string& LgtBuf, const std::string& TexBuf, const std::string &FlagBuf)
+    /* Get output buffer function.
+     * ARGUMENTS: None.
+     * RETURNS: (std::string &) shader text being generated.
+     */
+    static std::string & GetBuf(void)
+    {
+      return CurBuf;
+    } /* End of 'GetBuf' function */
+
+    /* Start new output chunk function.
+     * ARGUMENTS:
+     *   - variable symbol the following text belongs to (-1 for scene root):
+     *       int Owner;
+     *   - is text declaration of owner:
+     *       bool IsDecl;
+     * RETURNS: None.
+     */
+    static void Mark(int Owner, bool IsDecl = false)
+    {
+      Chunks.push_back({CurBuf.size(), Owner, IsDecl, 0, {}});
+    } /* End of 'Mark' function */
+
+    /* Get output name function.
+     * ARGUMENTS:
+     *   - variable symbol id:
+     *       int Id;
+     *   - part of variable:
+     *       facet Part;
+     * RETURNS: (int) output name.
+     */
+    static int Name(int Id, facet Part = facet::eVal)
+    {
+      return Id * 3 + (int)Part;
+    } /* End of 'Name' function */
+
+    /* Record name access of current chunk function.
+     * Emitters record accesses in the order their text does them,
+     * dead code elimination works on these records only.
+     * ARGUMENTS:
+     *   - access kind:
+     *       access::kind Kind;
+     *   - output name (see 'Name'):
+     *       int Name;
+     * RETURNS: None.
+     */
+    static void Access(access::kind Kind, int Name)
+    {
+      if (Chunks.empty())
+        return;
+      Chunks.back().Acc.push_back({Kind, Name});
+      if (Kind != access::eUse && Name >= 0)
+      {
+        if (Name >= (int)Writes.size())
+          Writes.resize(Name + 1);
+        Writes[Name] = ++WriteNo;
+      }
+    } /* End of 'Access' function */
+
+    /* Get assignment number function.
+     * Numbers grow in output order and aren't changed by loop folding.
+     * ARGUMENTS:
+     *   - output name (see 'Name'), -1 for number of last assignment of all names:
+     *       int Name;
+     * RETURNS: (int) number of last assignment of name, 0 if it isn't assigned.
+     */
+    static int GetWrite(int Name = -1)
+    {
+      if (Name < 0)
+        return WriteNo;
+      return Name < (int)Writes.size() ? Writes[Name] : 0;
+    } /* End of 'GetWrite' function */
+
+    /* Append text to output chunk function.
+     * Text of following chunks is moved.
+     * ARGUMENTS:
+     *   - chunk index:
+     *       size_t Chunk;
+     *   - GLSL text:
+     *       const std::string &Text;
+     *   - names accessed by text in statements order:
+     *       const std::vector<access> &Acc;
+     * RETURNS: None.
+     */
+    static void Append(size_t Chunk, const std::string &Text, const std::vector<access> &Acc)
+    {
+      CurBuf.insert(Chunk + 1 < Chunks.size() ? Chunks[Chunk + 1].Start : CurBuf.size(), Text);
+      for (size_t i = Chunk + 1; i < Chunks.size(); i++)
+        Chunks[i].Start += Text.size();
+      Chunks[Chunk].Acc.insert(Chunks[Chunk].Acc.end(), Acc.begin(), Acc.end());
+    } /* End of 'Append' function */
+
+    /* Record name read function.
+     * ARGUMENTS:
+     *   - output name (see 'Name'):
+     *       int Name;
+     * RETURNS: None.
+     */
+    static void Use(int Name)
+    {
+      Access(access::eUse, Name);
+    } /* End of 'Use' function */
+
+    /* Record name assignment function.
+     * ARGUMENTS:
+     *   - output name (see 'Name'):
+     *       int Name;
+     *   - is assignment partial or conditional:
+     *       bool IsPart;
+     * RETURNS: None.
+     */
+    static void Set(int Name, bool IsPart = false)
+    {
+      Access(IsPart ? access::eDef : access::eKill, Name);
+    } /* End of 'Set' function */
+
+    /* Get names read by current chunk function.
+     * ARGUMENTS: None.
+     * RETURNS: (std::vector<int>) output names in reading order.
+     */
+    static std::vector<int> GetUses(void)
+    {
+      std::vector<int> res;
+
+      if (!Chunks.empty())
+        for (auto &a : Chunks.back().Acc)
+          if (a.Kind == access::eUse)
+            res.push_back(a.Name);
+      return res;
+    } /* End of 'GetUses' function */
+
+    /* Get output chunks function.
+     * ARGUMENTS: None.
+     * RETURNS: (std::vector<chunk> &) chunks in output order.
+     */
+    static std::vector<chunk> & GetChunks(void)
+    {
+      return Chunks;
+    } /* End of 'GetChunks' function */
+
+    /* Exchange output buffer function.
+     * ARGUMENTS:
+     *   - text and chunks to output to, previous ones are returned in them:
+     *       std::string &Buf;
+     *       std::vector<chunk> &Marks;
+     * RETURNS: None.
+     */
+    static void Swap(std::string &Buf, std::vector<chunk> &Marks)
+    {
+      CurBuf.swap(Buf);
+      Chunks.swap(Marks);
+    } /* End of 'Swap' function */
+
+    /* Clear output buffer function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    static void Clear(void)
+    {
+      CurBuf.clear();
+      Chunks.clear();
+      Writes.clear();
+      WriteNo = 0;
+    } /* End of 'Clear' function */
+
+    /* Write shader file function.
+     * ARGUMENTS:
+     *   - template and output file names:
+     *       const std::string &InName, &OutName;
+     *   - light, texture, flag and scene functions sections text:
+     *       const std::string &LgtBuf, &TexBuf, &FlagBuf, &FuncBuf;
+     *   - state shader is used with which isn't in its text (texture file names):
+     *       const std::string &Key;
+     * RETURNS: (bool) was file written (false if it is the same as the last one).
+     */
+    static bool PrintFile(const std::string& InName, const std::string& OutName,
+      const std::string& LgtBuf, const std::string& TexBuf, const std::string &FlagBuf,
+      const std::string &FuncBuf, const std::string &Key = "")
     {
-      std::ofstream FOut(OutName);
       std::ifstream FIn(InName);
 
-      if (!FIn.is_open() || !FOut.is_open())
-        throw std::exception("incorrect file!");
+      if (!FIn.is_open())
+        throw std::runtime_error("incorrect file!");
 
-      std::string line;
+      std::string line, out;
 
       while (getline(FIn, line))
       {
         if (line == "SCENE")
-          FOut << CurBuf;
+          out += CurBuf;
         else if (line == "TEXTURE")
-          FOut << TexBuf;
+          out += TexBuf;
         else if (line == "LIGHT")
-          FOut << LgtBuf;
+          out += LgtBuf;
         else if (line == "FLAG")
-          FOut << FlagBuf;
+          out += FlagBuf;
+        else if (line == "FUNCTION")
+          out += FuncBuf;
         else
-          FOut << line << std::endl;
+          out += line + "\n";
       }
 
-      FOut.close();
       FIn.close();
       CurBuf.clear();
-    }
+      Chunks.clear();
+      return Write(OutName, std::move(out), Key);
+    } /* End of 'PrintFile' function */
+
+    /* Write shader text function.
+     * ARGUMENTS:
+     *   - output file name:
+     *       const std::string &OutName;
+     *   - shader text:
+     *       std::string &&Text;
+     *   - state shader is used with which isn't in its text (texture file names):
+     *       const std::string &Key;
+     * RETURNS: (bool) was file written (false if it is the same as the last one).
+     */
+    static bool Write(const std::string &OutName, std::string &&Text, const std::string &Key)
+    {
+      // Scene structure didn't change, shader can be kept
+      size_t
+        hash = std::hash<std::string>()(Text),
+        key = std::hash<std::string>()(Key);
+
+      hash ^= key + 0x9E3779B9 + (hash << 6) + (hash >> 2);
+      Last = std::move(Text);
+      LastKey = Key;
+
+      // Scenes may be compiled by several threads, each output file is written by one at a time
+      std::lock_guard<std::mutex> guard(Lock);
+      auto last = Hashes.find(OutName);
+
+      // File written by previous run is already used by shader loaded on start
+      if (last == Hashes.end() && ReadFile(OutName) == Last)
+        last = Hashes.emplace(OutName, hash).first;
+      if (last != Hashes.end() && last->second == hash)
+      {
+        return false;
+      }
+
+      std::ofstream FOut(OutName);
+
+      if (!FOut.is_open())
+        throw std::runtime_error("incorrect file!");
+      FOut << Last;
+      FOut.close();
+      Hashes[OutName] = hash;
+      return true;
+    } /* End of 'Write' function */
+
+    /* Get last shader text function.
+     * ARGUMENTS: None.
+     * RETURNS: (const std::string &) text of shader written (or skipped) by this thread last.
+     */
+    static const std::string & GetLast(void)
+    {
+      return Last;
+    } /* End of 'GetLast' function */
+
+    /* Get last shader key function.
+     * ARGUMENTS: None.
+     * RETURNS: (const std::string &) state last shader is used with.
+     */
+    static const std::string & GetLastKey(void)
+    {
+      return LastKey;
+    } /* End of 'GetLastKey' function */
 
     static std::string ReadFile(const std::string& Name)
     {
@@ -83,6 +481,46 @@ namespace parser
       return Buf;
     }
   };
+
+  /* Compilation report class.
+   * Collects one line messages of optimization passes for the last 'Parse'.
+   */
+  class report
+  {
+  private:
+    static thread_local std::string Buf;
+
+    report() {}
+  public:
+    /* Add report line function.
+     * ARGUMENTS:
+     *   - message:
+     *       const std::string &Line;
+     * RETURNS: None.
+     */
+    static void Add(const std::string &Line)
+    {
+      Buf += Line + "\n";
+    } /* End of 'Add' function */
+
+    /* Get report text function.
+     * ARGUMENTS: None.
+     * RETURNS: (const std::string &) all report lines.
+     */
+    static const std::string & Get(void)
+    {
+      return Buf;
+    } /* End of 'Get' function */
+
+    /* Clear report function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    static void Clear(void)
+    {
+      Buf.clear();
+    } /* End of 'Clear' function */
+  }; /* End of 'report' class */
 }
 
 #endif
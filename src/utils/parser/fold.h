@@ -0,0 +1,151 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+ /* FILE NAME   : fold.h
+  * PURPOSE     : Ray marching project.
+  *               Parser module.
+  * PROGRAMMER  : Vladislav Biserov.
+  * LAST UPDATE : 30.03.2023
+  * NOTE        : None.
+  *
+  * No part of this file may be changed without agreement of
+  * Computer Graphics Support Group of 30 Phys-Math Lyceum
+  */
+
+#ifndef __fold_h_
+#define __fold_h_
+
+#include <vector>
+
+#include "symbol.h"
+
+namespace parser
+{
+  /* Constant folding pass state class.
+   * Variable is dynamic if any of its assignments depends on 'Time'
+   * (directly or through other dynamic variables). Syntax tree is folded
+   * until no more variables become dynamic, expression nodes which don't
+   * depend on dynamic variables are emitted as literals.
+   * Variables assigned in loops building objects are marked as looped:
+   * values depending on them differ between iterations, so they aren't
+   * hoisted to frame uniforms while loop is recorded.
+   */
+  class folder
+  {
+  private:
+    std::vector<bool> Dynamic; // Dynamic flags by symbol id
+    std::vector<bool> Looped;  // Assigned in loop building objects flags by symbol id
+    int Loops = 0;             // Depth of loops building objects being folded
+    bool IsChanged = false;    // Was new dynamic or looped variable found on this pass
+    int Time;                  // 'Time' symbol id
+
+  public:
+    int Count = 0; // Number of folded nodes on this pass
+
+    folder(void) : Time(symbols::Find("Time"))
+    {
+      SetDynamic(Time);
+    }
+
+    /* Check is variable 'Time' function.
+     * ARGUMENTS:
+     *   - symbol id:
+     *       int Id;
+     * RETURNS: (bool) is 'Time'.
+     */
+    bool IsTime(int Id) const
+    {
+      return Id == Time;
+    } /* End of 'IsTime' function */
+
+    /* Check is variable dynamic function.
+     * ARGUMENTS:
+     *   - symbol id:
+     *       int Id;
+     * RETURNS: (bool) is dynamic.
+     */
+    bool IsDynamic(int Id) const
+    {
+      return Id >= 0 && Id < (int)Dynamic.size() && Dynamic[Id];
+    } /* End of 'IsDynamic' function */
+
+    /* Mark variable as dynamic function.
+     * ARGUMENTS:
+     *   - symbol id:
+     *       int Id;
+     * RETURNS: None.
+     */
+    void SetDynamic(int Id)
+    {
+      if (Id < 0 || IsDynamic(Id))
+        return;
+      if (Id >= (int)Dynamic.size())
+        Dynamic.resize(Id + 1);
+      Dynamic[Id] = true;
+      IsChanged = true;
+    } /* End of 'SetDynamic' function */
+
+    /* Check is variable assigned in loop building objects function.
+     * ARGUMENTS:
+     *   - symbol id:
+     *       int Id;
+     * RETURNS: (bool) is looped.
+     */
+    bool IsLooped(int Id) const
+    {
+      return Id >= 0 && Id < (int)Looped.size() && Looped[Id];
+    } /* End of 'IsLooped' function */
+
+    /* Mark variable assigned (looped inside loop building objects) function.
+     * ARGUMENTS:
+     *   - symbol id:
+     *       int Id;
+     * RETURNS: None.
+     */
+    void SetAssigned(int Id)
+    {
+      if (Loops == 0 || Id < 0 || IsLooped(Id))
+        return;
+      if (Id >= (int)Looped.size())
+        Looped.resize(Id + 1);
+      Looped[Id] = true;
+      IsChanged = true;
+    } /* End of 'SetAssigned' function */
+
+    /* Enter or leave loop building objects function.
+     * ARGUMENTS:
+     *   - is loop entered flag:
+     *       bool IsEnter;
+     * RETURNS: None.
+     */
+    void Loop(bool IsEnter)
+    {
+      Loops += IsEnter ? 1 : -1;
+    } /* End of 'Loop' function */
+
+    /* Start new pass function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    void Begin(void)
+    {
+      IsChanged = false;
+      Count = 0;
+    } /* End of 'Begin' function */
+
+    /* Check is last pass changed nothing function.
+     * ARGUMENTS: None.
+     * RETURNS: (bool) is folding finished.
+     */
+    bool IsStable(void) const
+    {
+      return !IsChanged;
+    } /* End of 'IsStable' function */
+  }; /* End of 'folder' class */
+}
+
+#endif
+
+/* END OF 'fold.h' FILE */
@@ -0,0 +1,299 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : func.cpp
+ * PURPOSE     : Ray marching project.
+ *               Parser module.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 02.04.2023
+ * NOTE        : None.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include "func.h"
+#include "bound.h"
+#include "live.h"
+#include "loop.h"
+#include "variable.h"
+
+thread_local std::vector<parser::functions::func> parser::functions::Funcs;
+thread_local std::vector<int> parser::functions::Owner;
+thread_local std::string parser::functions::Text;
+thread_local int
+  parser::functions::Cur = -1,
+  parser::functions::Time = -1,
+  parser::functions::Calls = 0;
+
+/* Reset functions function.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+void parser::functions::Clear( void )
+{
+  Funcs.clear();
+  Owner.clear();
+  Text.clear();
+  Cur = -1;
+  Time = symbols::Find("Time");
+  Calls = 0;
+} /* End of 'parser::functions::Clear' function */
+
+/* Get function owning name function.
+ * ARGUMENTS:
+ *   - symbol id:
+ *       int Id;
+ * RETURNS: (int) function index, -1 for scene names.
+ */
+int parser::functions::GetOwner( int Id )
+{
+  return Id >= 0 && Id < (int)Owner.size() ? Owner[Id] : -1;
+} /* End of 'parser::functions::GetOwner' function */
+
+/* Find function by name function.
+ * Function being defined isn't found, so it can't call itself.
+ * ARGUMENTS:
+ *   - function symbol id:
+ *       int Name;
+ * RETURNS: (int) function index, -1 if there is no such function.
+ */
+int parser::functions::Find( int Name )
+{
+  for (int i = 0; i < (int)Funcs.size(); i++)
+    if (Funcs[i].Name == Name && i != Cur)
+      return i;
+  return -1;
+} /* End of 'parser::functions::Find' function */
+
+/* Start function definition function.
+ * Declarations of body names are printed to function text until 'EndDecl'.
+ * ARGUMENTS:
+ *   - function symbol id:
+ *       int Name;
+ * RETURNS: (int) function index.
+ */
+int parser::functions::Declare( int Name )
+{
+  Funcs.push_back({Name, {}, {}, {}});
+  Cur = (int)Funcs.size() - 1;
+  file::Swap(Funcs[Cur].Text, Funcs[Cur].Chunks);
+  return Cur;
+} /* End of 'parser::functions::Declare' function */
+
+/* Add parameter to function being defined function.
+ * ARGUMENTS:
+ *   - parameter symbol id (see 'Intern'):
+ *       int Id;
+ *   - parameter type:
+ *       var_type Type;
+ * RETURNS: None.
+ */
+void parser::functions::Param( int Id, var_type Type )
+{
+  if (Type == var_type::eShape || Type == var_type::eLight)
+    throw std::runtime_error("incorrect parameter type!");
+  if (variables::IsExists(Id))
+    throw std::runtime_error("such varibale is already exists!");
+  variables::Set(Id, Type, 0);
+  Funcs[Cur].Params.push_back({Id, Type});
+} /* End of 'parser::functions::Param' function */
+
+/* Finish function definition function.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+void parser::functions::EndDecl( void )
+{
+  file::Swap(Funcs[Cur].Text, Funcs[Cur].Chunks);
+  Cur = -1;
+} /* End of 'parser::functions::EndDecl' function */
+
+/* Intern declared name function.
+ * ARGUMENTS:
+ *   - identifier:
+ *       std::string_view Name;
+ * RETURNS: (int) symbol id, name of function body gets function name prefix.
+ */
+int parser::functions::Intern( std::string_view Name )
+{
+  if (Cur < 0)
+    return symbols::Intern(Name);
+
+  int id = symbols::Intern(symbols::GetName(Funcs[Cur].Name) + "_" + std::string(Name));
+
+  if (id >= (int)Owner.size())
+    Owner.resize(id + 1, -1);
+  Owner[id] = Cur;
+  return id;
+} /* End of 'parser::functions::Intern' function */
+
+/* Find used name function.
+ * ARGUMENTS:
+ *   - identifier:
+ *       std::string_view Name;
+ * RETURNS: (int) symbol id (name of function body is preferred), -1 if there is no such name.
+ */
+int parser::functions::Lookup( std::string_view Name )
+{
+  if (Cur >= 0)
+  {
+    int id = symbols::Find(symbols::GetName(Funcs[Cur].Name) + "_" + std::string(Name));
+
+    if (GetOwner(id) == Cur)
+      return id;
+  }
+
+  // Names of bodies are reached through their prefix only
+  int id = symbols::Find(Name);
+
+  return GetOwner(id) < 0 ? id : -1;
+} /* End of 'parser::functions::Lookup' function */
+
+/* Check is name of current scope function.
+ * ARGUMENTS:
+ *   - symbol id:
+ *       int Id;
+ * RETURNS: (bool) is name of function being defined (of scene outside of functions).
+ */
+bool parser::functions::IsLocal( int Id )
+{
+  return GetOwner(Id) == Cur;
+} /* End of 'parser::functions::IsLocal' function */
+
+/* Check can variable be read by GLSL text function.
+ * ARGUMENTS:
+ *   - symbol id:
+ *       int Id;
+ * RETURNS: (bool) is variable of current scope or 'Time'.
+ */
+bool parser::functions::IsVisible( int Id )
+{
+  return IsLocal(Id) || Id == Time;
+} /* End of 'parser::functions::IsVisible' function */
+
+/* Start function body compilation function.
+ * ARGUMENTS:
+ *   - function index:
+ *       int Func;
+ * RETURNS: None.
+ */
+void parser::functions::Begin( int Func )
+{
+  Cur = Func;
+  file::Swap(Funcs[Func].Text, Funcs[Func].Chunks);
+} /* End of 'parser::functions::Begin' function */
+
+/* Finish function body compilation function.
+ * ARGUMENTS:
+ *   - function index:
+ *       int Func;
+ *   - returned shape symbol id:
+ *       int Res;
+ * RETURNS: None.
+ */
+void parser::functions::End( int Func, int Res )
+{
+  func &f = Funcs[Func];
+  const std::string
+    &name = symbols::GetName(f.Name),
+    &res = symbols::GetName(Res);
+  std::string full, dist;
+
+  // Returned shape is the only result of body
+  file::Mark(-1);
+  file::GetBuf() += param::MtlOnly(std::format("Mtl = mtl_{};\n", res)) + std::format("return {};\n", res);
+  file::Use(file::Name(Res, file::facet::eMtl));
+  file::Set(file::SceneMtl);
+  file::Use(file::Name(Res));
+  liveness::Sweep(name);
+  file::Swap(f.Text, f.Chunks);
+  Cur = -1;
+
+  // Materials are dropped from distance only copy
+  for (auto &p : f.Params)
+  {
+    const char *type =
+      p.second == var_type::eInt ? "int" :
+      p.second == var_type::eFloat ? "float" :
+      p.second == var_type::eVec ? "vec3" : "mtl";
+    std::string par = std::format(", {} {}", type, symbols::GetName(p.first));
+
+    full += par;
+    if (p.second != var_type::eMtl)
+      dist += par;
+  }
+
+  Text += std::format("// scene function '{0}'\n"
+    "#ifndef SCENE_DIST\n"
+    "float SDFUser_{0}( in vec3 point, out mtl Mtl{1} )\n"
+    "#else\n"
+    "float SDFUser_{0}( in vec3 point{2} )\n"
+    "#endif\n"
+    "{{\n"
+    "float tmp;\n\n", name, full, dist) + param::MtlOnly("mtl tmp_mtl;\nint tmp_id;\n") + "\n";
+  Text += f.Text;
+  Text += "}\n\n";
+  f.Text.clear();
+  f.Chunks.clear();
+  bounds::Result(Func, Res);
+} /* End of 'parser::functions::End' function */
+
+/* Get function call GLSL text function.
+ * ARGUMENTS:
+ *   - function index:
+ *       int Func;
+ *   - result shape symbol id:
+ *       int Var;
+ *   - arguments GLSL text:
+ *       const std::vector<std::string> &Args;
+ * RETURNS: (std::string) GLSL text.
+ */
+std::string parser::functions::Call( int Func, int Var, const std::vector<std::string> &Args )
+{
+  const func &f = Funcs[Func];
+  const std::string
+    &var = symbols::GetName(Var),
+    &name = symbols::GetName(f.Name);
+  std::string
+    full = std::format("{0} = SDFUser_{1}(mod_{0}, mtl_{0}", var, name),
+    dist = std::format("{0} = SDFUser_{1}(mod_{0}", var, name);
+
+  for (size_t i = 0; i < Args.size(); i++)
+  {
+    // Numbers are float in GLSL text
+    std::string a = f.Params[i].second == var_type::eInt ? "int(" + Args[i] + ")" : Args[i];
+
+    full += ", " + a;
+    if (f.Params[i].second != var_type::eMtl)
+      dist += ", " + a;
+  }
+  Calls++;
+  return "#ifndef SCENE_DIST\n" + full + ");\n#else\n" + dist + ");\n#endif\n";
+} /* End of 'parser::functions::Call' function */
+
+/* Get functions definition function.
+ * ARGUMENTS: None.
+ * RETURNS: (std::string) GLSL text.
+ */
+std::string parser::functions::GetStr( void )
+{
+  if (Text.empty())
+    return Text;
+
+  // Functions are defined twice, 'SceneDist' calls copies without material
+  return loops::GetStr(Text) + Text + "#define SCENE_DIST\n" + Text + "#undef SCENE_DIST\n\n";
+} /* End of 'parser::functions::GetStr' function */
+
+/* Get functions statistics function.
+ * ARGUMENTS: None.
+ * RETURNS: (std::string) report line.
+ */
+std::string parser::functions::GetStat( void )
+{
+  return std::format("scene functions: {} defined, {} calls", Funcs.size(), Calls);
+} /* End of 'parser::functions::GetStat' function */
+
+/* END OF 'func.cpp' FILE */
@@ -0,0 +1,122 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+ /* FILE NAME   : func.h
+  * PURPOSE     : Ray marching project.
+  *               Parser module.
+  * PROGRAMMER  : Vladislav Biserov.
+  * LAST UPDATE : 02.04.2023
+  * NOTE        : None.
+  *
+  * No part of this file may be changed without agreement of
+  * Computer Graphics Support Group of 30 Phys-Math Lyceum
+  */
+
+#ifndef __func_h_
+#define __func_h_
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "file.h"
+#include "symbol.h"
+#include "token.h"
+
+namespace parser
+{
+  /* Scene functions class.
+   * Function builds shape from its parameters:
+   *   func leg(vec3 p, double r)
+   *   {
+   *     shape l = capsule(p, p - vec3(0, 2, 0), r, MtlLib[3]);
+   *     return l;
+   *   }
+   *   shape l1 = leg(vec3(-1, -5, 0), 0.5);
+   *   l1 = rotate(30, vec3(0, 0, 1));
+   * Body is compiled once to GLSL function, every call is one line of scene
+   * code with point of called shape, so its modifications transform whole result.
+   * Names of body are local, they are interned with function name prefix.
+   * Body reads its parameters, its variables, constants and 'Time' only,
+   * its control flow is resolved on compile time, so it can't depend on parameters.
+   */
+  class functions
+  {
+  private:
+    /* Function structure */
+    struct func
+    {
+      int Name;                                     // Function symbol
+      std::vector<std::pair<int, var_type>> Params; // Parameter symbols and types
+      std::string Text;                             // Body text while it is generated
+      std::vector<file::chunk> Chunks;              // Body output chunks
+    }; /* End of 'func' structure */
+
+    static thread_local std::vector<func> Funcs; // Functions in definition order
+    static thread_local std::vector<int> Owner;  // Function index by symbol id, -1 for scene names
+    static thread_local std::string Text;        // GLSL text of all functions
+    static thread_local int Cur;                 // Function being parsed or compiled, -1 for scene
+    static thread_local int Time;                // 'Time' symbol id
+    static thread_local int Calls;               // Number of calls compiled
+
+    functions(void)
+    {
+    }
+
+    static int GetOwner(int Id);
+
+  public:
+    static void Clear(void);
+    static int Find(int Name);
+    static int Declare(int Name);
+    static void Param(int Id, var_type Type);
+    static void EndDecl(void);
+    static int Intern(std::string_view Name);
+    static int Lookup(std::string_view Name);
+    static bool IsLocal(int Id);
+    static bool IsVisible(int Id);
+    static void Begin(int Func);
+    static void End(int Func, int Res);
+    static std::string Call(int Func, int Var, const std::vector<std::string> &Args);
+    static std::string GetStr(void);
+    static std::string GetStat(void);
+
+    /* Check is function body generated function.
+     * ARGUMENTS: None.
+     * RETURNS: (bool) is output in function body.
+     */
+    static bool IsBody(void)
+    {
+      return Cur >= 0;
+    } /* End of 'IsBody' function */
+
+    /* Get function symbol function.
+     * ARGUMENTS:
+     *   - function index:
+     *       int Func;
+     * RETURNS: (int) symbol id.
+     */
+    static int GetName(int Func)
+    {
+      return Funcs[Func].Name;
+    } /* End of 'GetName' function */
+
+    /* Get function parameters function.
+     * ARGUMENTS:
+     *   - function index:
+     *       int Func;
+     * RETURNS: (const std::vector<std::pair<int, var_type>> &) parameter symbols and types.
+     */
+    static const std::vector<std::pair<int, var_type>> & GetParams(int Func)
+    {
+      return Funcs[Func].Params;
+    } /* End of 'GetParams' function */
+  }; /* End of 'functions' class */
+}
+
+#endif
+
+/* END OF 'func.h' FILE */
@@ -0,0 +1,204 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+ /* FILE NAME   : keyword.h
+  * PURPOSE     : Ray marching project.
+  *               Parser module.
+  * PROGRAMMER  : Vladislav Biserov.
+  * LAST UPDATE : 02.04.2023
+  * NOTE        : None.
+  *
+  * No part of this file may be changed without agreement of
+  * Computer Graphics Support Group of 30 Phys-Math Lyceum
+  */
+
+#ifndef __keyword_h_
+#define __keyword_h_
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "obj/obj.h"
+
+#include "token.h"
+
+namespace parser
+{
+  /* Keyword table class.
+   * All reserved words of the scene language are classified through
+   * a perfect hash built at compile time, so the lexer does one hash
+   * and one compare per word instead of probing several maps.
+   */
+  class keyword
+  {
+  public:
+    /* Keyword kind */
+    enum class kind
+    {
+      eNone,  // Plain statement keyword
+      eType,  // Variable type ('Id' is 'var_type')
+      eState, // Render state ('Id' is 'state_type')
+      eShape, // Shape function ('Id' is 'obj::shape::type')
+      eMod,   // Modification function ('Id' is 'obj::mod::type')
+      eLight, // Light function ('Id' is 'obj::light::type')
+      eOper,  // Operation function ('Id' is 'obj::oper::type')
+    }; /* End of 'kind' enum */
+
+    /* Keyword entry structure */
+    struct entry
+    {
+      std::string_view Name; // Keyword text
+      token_type Type;       // Token type to emit
+      kind Kind;             // Keyword kind
+      int Id;                // Kind specific enum value
+      bool IsText;           // Keep keyword text in token
+    }; /* End of 'entry' structure */
+
+  private:
+    /* Keywords (must be kept in sync with 'obj::*::Table', 'var_type' and 'state_type') */
+    static constexpr entry Entries[] =
+    {
+      {"int",        token_type::eType,  kind::eType,  (int)var_type::eInt,   true},
+      {"double",     token_type::eType,  kind::eType,  (int)var_type::eFloat, true},
+      {"vec3",       token_type::eType,  kind::eType,  (int)var_type::eVec,   true},
+      {"shape",      token_type::eType,  kind::eType,  (int)var_type::eShape, true},
+      {"light",      token_type::eType,  kind::eType,  (int)var_type::eLight, true},
+      {"mtl",        token_type::eType,  kind::eType,  (int)var_type::eMtl,   true},
+
+      {"rm_ao",      token_type::eState, kind::eState, (int)state_type::eAO,      true},
+      {"rm_reflect", token_type::eState, kind::eState, (int)state_type::eReflect, true},
+      {"rm_shadow",  token_type::eState, kind::eState, (int)state_type::eShadow,  true},
+      {"rm_skybox",  token_type::eState, kind::eState, (int)state_type::eSky,     true},
+      {"rm_lod",     token_type::eState, kind::eState, (int)state_type::eLod,     true},
+      {"rm_lod_debug", token_type::eState, kind::eState, (int)state_type::eLodDebug, true},
+
+      {"sphere",     token_type::eFunc,  kind::eShape, (int)obj::shape::type::eSphere,    true},
+      {"box",        token_type::eFunc,  kind::eShape, (int)obj::shape::type::eBox,       true},
+      {"cylinder",   token_type::eFunc,  kind::eShape, (int)obj::shape::type::eCylinder,  true},
+      {"plane",      token_type::eFunc,  kind::eShape, (int)obj::shape::type::ePlane,     true},
+      {"torus",      token_type::eFunc,  kind::eShape, (int)obj::shape::type::eTorus,     true},
+      {"ellipsoid",  token_type::eFunc,  kind::eShape, (int)obj::shape::type::eEllipsoid, true},
+      {"capsule",    token_type::eFunc,  kind::eShape, (int)obj::shape::type::eCapsule,   true},
+      {"water",      token_type::eFunc,  kind::eShape, (int)obj::shape::type::eWater,     true},
+
+      {"rotate",     token_type::eFunc,  kind::eMod,   (int)obj::mod::type::eRotate,    true},
+      {"translate",  token_type::eFunc,  kind::eMod,   (int)obj::mod::type::eTranslate, true},
+      {"scale",      token_type::eFunc,  kind::eMod,   (int)obj::mod::type::eScale,     true},
+      {"repeat",     token_type::eFunc,  kind::eMod,   (int)obj::mod::type::eRepeat,    true},
+      {"mirror",     token_type::eFunc,  kind::eMod,   (int)obj::mod::type::eMirror,    true},
+
+      {"point",      token_type::eFunc,  kind::eLight, (int)obj::light::type::ePoint, true},
+      {"dir",        token_type::eFunc,  kind::eLight, (int)obj::light::type::eDir,   true},
+      {"spot",       token_type::eFunc,  kind::eLight, (int)obj::light::type::eSpot,  true},
+
+      {"union",      token_type::eFunc,  kind::eOper,  (int)obj::oper::type::eUnion,     true},
+      {"smth_union", token_type::eFunc,  kind::eOper,  (int)obj::oper::type::eUnionSmth, true},
+      {"diff",       token_type::eFunc,  kind::eOper,  (int)obj::oper::type::eDiff,      true},
+      {"smth_diff",  token_type::eFunc,  kind::eOper,  (int)obj::oper::type::eDiffSmth,  true},
+      {"inter",      token_type::eFunc,  kind::eOper,  (int)obj::oper::type::eInter,     true},
+      {"smth_inter", token_type::eFunc,  kind::eOper,  (int)obj::oper::type::eInterSmth, true},
+
+      {"print",      token_type::ePrint, kind::eNone,  0, false},
+      {"if",         token_type::eIf,    kind::eNone,  0, false},
+      {"else",       token_type::eElse,  kind::eNone,  0, false},
+      {"while",      token_type::eWhile, kind::eNone,  0, false},
+      {"add",        token_type::eAdd,   kind::eNone,  0, false},
+      {"for",        token_type::eFor,   kind::eNone,  0, false},
+      {"true",       token_type::eTrue,  kind::eNone,  0, false},
+      {"false",      token_type::eFalse, kind::eNone,  0, false},
+      {"func",       token_type::eDef,   kind::eNone,  0, false},
+      {"return",     token_type::eReturn, kind::eNone, 0, false},
+    };
+
+    static constexpr int Count = (int)(sizeof(Entries) / sizeof(Entries[0]));
+    static constexpr std::uint32_t TableSize = 256;
+
+    /* Seeded FNV-1a hash function.
+     * ARGUMENTS:
+     *   - word to hash:
+     *       std::string_view Word;
+     *   - hash seed:
+     *       std::uint32_t Salt;
+     * RETURNS: (std::uint32_t) table slot.
+     */
+    static constexpr std::uint32_t Hash(std::string_view Word, std::uint32_t Salt)
+    {
+      std::uint32_t h = 2166136261u ^ Salt;
+
+      for (char c : Word)
+        h = (h ^ (std::uint8_t)c) * 16777619u;
+      return (h ^ (h >> 15)) & (TableSize - 1);
+    } /* End of 'Hash' function */
+
+    /* Find collision free seed function.
+     * ARGUMENTS: None.
+     * RETURNS: (std::uint32_t) seed, 0 if there is no one.
+     */
+    static constexpr std::uint32_t FindSeed(void)
+    {
+      for (std::uint32_t seed = 1; seed < 4096; seed++)
+      {
+        std::array<bool, TableSize> used {};
+        bool ok = true;
+
+        for (int i = 0; i < Count && ok; i++)
+        {
+          std::uint32_t h = Hash(Entries[i].Name, seed);
+
+          if (used[h])
+            ok = false;
+          used[h] = true;
+        }
+        if (ok)
+          return seed;
+      }
+      return 0;
+    } /* End of 'FindSeed' function */
+
+    /* Build slot table function.
+     * ARGUMENTS: None.
+     * RETURNS: (std::array<signed char, TableSize>) slot to entry index table.
+     */
+    static constexpr std::array<signed char, TableSize> BuildSlots(void)
+    {
+      std::array<signed char, TableSize> slots {};
+
+      for (auto &s : slots)
+        s = -1;
+      for (int i = 0; i < Count; i++)
+        slots[Hash(Entries[i].Name, Seed)] = (signed char)i;
+      return slots;
+    } /* End of 'BuildSlots' function */
+
+  public:
+    static const std::uint32_t Seed;                        // Collision free hash seed
+    static const std::array<signed char, TableSize> Slots; // Slot to entry index table
+
+    /* Find keyword function.
+     * ARGUMENTS:
+     *   - word to classify:
+     *       std::string_view Word;
+     * RETURNS: (const entry *) keyword entry, nullptr if word is not a keyword.
+     */
+    static constexpr const entry * Find(std::string_view Word)
+    {
+      int i = Slots[Hash(Word, Seed)];
+
+      if (i < 0 || Entries[i].Name != Word)
+        return nullptr;
+      return &Entries[i];
+    } /* End of 'Find' function */
+  }; /* End of 'keyword' class */
+
+  inline constexpr std::uint32_t keyword::Seed = keyword::FindSeed();
+  static_assert(keyword::Seed != 0, "no perfect hash seed for keyword table");
+
+  inline constexpr std::array<signed char, keyword::TableSize> keyword::Slots = keyword::BuildSlots();
+}
+
+#endif
+
+/* END OF 'keyword.h' FILE */
@@ -7,7 +7,7 @@
   * PURPOSE     : Ray marching project.
   *               Parser module.
   * PROGRAMMER  : Vladislav Biserov.
-  * LAST UPDATE : 30.03.2023
+  * LAST UPDATE : 31.03.2023
   * NOTE        : None.
   *
   * No part of this file may be changed without agreement of
@@ -17,57 +17,34 @@
 #ifndef __lexer_h_
 #define __lexer_h_
 
-#include <algorithm>
-#include <map>
+#include <stdexcept>
+#include <string_view>
 
-#include "obj/obj.h"
+#include "keyword.h"
 
 #include "token.h"
 
 namespace parser
 {
+  /* Streaming lexer class.
+   * Tokens are produced one by one on 'Scan' request and refer
+   * to the input text directly, nothing is copied.
+   */
   class lexer
   {
   private:
-    /* Some constants */
-    std::map<std::string, token_type> OPERS =
-    {
-      {"+", token_type::ePlus},
-      {"-", token_type::eMinus},
-      {"*", token_type::eStar},
-      {"/", token_type::eSlash},
-      {"(", token_type::eLParen},
-      {")", token_type::eRParen},
-      {"=", token_type::eEQ},
-      {"<", token_type::eLT},
-      {">", token_type::eGT},
-      {"{", token_type::eLBRACE},
-      {"}", token_type::eRBRACE},
-      {"[", token_type::eLBracket},
-      {"]", token_type::eRBracket},
-      {",", token_type::eSemicolon},
-      {"\"", token_type::eCav},
-
-      {"!", token_type::eEXCL},
-      {"|", token_type::eBAR},
-      {"&", token_type::eAMP},
-
-      {"==", token_type::eEQEQ},
-      {"!=", token_type::eEXCLEQ},
-      {"<=", token_type::eLTEQ},
-      {">=", token_type::eGTEQ},
-
-      {"&&", token_type::eAMPAMP},
-      {"||", token_type::eBARBAR},
-    };
-
-    std::string Input;
-    std::vector<token> Tokens;
+    std::string_view Input;
     int CurPos, Len;
+    int Parens = 0, Braces = 0; // Open tags balance
+
+    static bool IsDigit(char C)
+    {
+      return C >= '0' && C <= '9';
+    }
 
-    void AddToken(std::string Text, token_type Type)
+    static bool IsAlpha(char C)
     {
-      Tokens.push_back(token(Text, Type));
+      return (C >= 'a' && C <= 'z') || (C >= 'A' && C <= 'Z');
     }
 
     char Peek(int RelPos)
@@ -86,105 +63,108 @@ namespace parser
       return Peek(0);
     }
 
-    void TokenizeNumber(void)
+    token TokenizeNumber(void)
     {
-      std::string res;
+      int start = CurPos;
+      bool is_dot = false;
       char cur = Peek(0);
 
       while (true)
       {
         if (cur == '.')
         {
-          if (res.find('.') != std::string::npos)
-            throw std::exception("incorrect number");
+          if (is_dot)
+            throw std::runtime_error("incorrect number");
+          is_dot = true;
         }
-        else if (!isdigit(cur))
+        else if (!IsDigit(cur))
           break;
-        res += cur;
         cur = Next();
       }
 
-      AddToken(res, token_type::eNumber);
+      return token(Input.substr(start, CurPos - start), token_type::eNumber);
     }
 
-    void TokenizeWord(void)
+    token TokenizeWord(void)
     {
-      std::string res;
+      int start = CurPos;
       char cur = Peek(0);
 
-      while (true)
-      {
-        if (!(isalpha(cur) || isdigit(cur) || cur == '_'))
-          break;
-        res += cur;
+      while (IsAlpha(cur) || IsDigit(cur) || cur == '_')
         cur = Next();
-      }
 
-      if (TYPES.find(res) != TYPES.end())
-        AddToken(res, token_type::eType);
-      else if (STATES.find(res) != STATES.end())
-        AddToken(res, token_type::eState);
-      else if (obj::shape::Table.find(res) != obj::shape::Table.end())
-        AddToken(res, token_type::eFunc);
-      else if (obj::mod::Table.find(res) != obj::mod::Table.end())
-        AddToken(res, token_type::eFunc);
-      else if (obj::light::Table.find(res) != obj::light::Table.end())
-        AddToken(res, token_type::eFunc);
-      else if (obj::oper::Table.find(res) != obj::oper::Table.end())
-        AddToken(res, token_type::eFunc);
-      else if (res == "print")
-        AddToken("", token_type::ePrint);
-      else if (res == "if")
-        AddToken("", token_type::eIf);
-      else if (res == "else")
-        AddToken("", token_type::eElse);
-      else if (res == "while")
-        AddToken("", token_type::eWhile);
-      else if (res == "add")
-        AddToken("", token_type::eAdd);
-      else if (res == "for")
-        AddToken("", token_type::eFor);
-      else if (res == "true")
-        AddToken("", token_type::eTrue);
-      else if (res == "false")
-        AddToken("", token_type::eFalse);
-      else
-        AddToken(res, token_type::eWord);
+      std::string_view res = Input.substr(start, CurPos - start);
+      const keyword::entry *kw = keyword::Find(res);
+
+      if (kw == nullptr)
+        return token(res, token_type::eWord);
+      return token(kw->IsText ? res : std::string_view(), kw->Type);
     }
 
-    void TokenizeOperator(void)
+    /* Operator classification function.
+     * ARGUMENTS:
+     *   - operator first and second characters:
+     *       char C, C1;
+     *   - operator length (out):
+     *       int *Size;
+     * RETURNS: (token_type) operator token type, 'eEOF' if it isn't operator.
+     */
+    static token_type Operator(char C, char C1, int *Size)
     {
-      char cur = Peek(0);
-
-      if (cur == '/')
+      *Size = 2;
+      switch (C)
       {
-        if (Peek(1) == '/')
-        {
-          Next();
-          Next();
-          TokenizeComment();
-          return;
-        }
-        else if (Peek(1) == '*')
-        {
-          Next();
-          Next();
-          TokenizeMultiComment();
-          return;
-        }
+      case '=':
+        if (C1 == '=')
+          return token_type::eEQEQ;
+        break;
+      case '!':
+        if (C1 == '=')
+          return token_type::eEXCLEQ;
+        break;
+      case '<':
+        if (C1 == '=')
+          return token_type::eLTEQ;
+        break;
+      case '>':
+        if (C1 == '=')
+          return token_type::eGTEQ;
+        break;
+      case '&':
+        if (C1 == '&')
+          return token_type::eAMPAMP;
+        break;
+      case '|':
+        if (C1 == '|')
+          return token_type::eBARBAR;
+        break;
       }
-      std::string cur_str;
 
-      while (true)
+      *Size = 1;
+      switch (C)
       {
-        if (OPERS.find(cur_str + cur) == OPERS.end() && !cur_str.empty())
-        {
-          AddToken(cur_str, OPERS.find(cur_str)->second);
-          return;
-        }
-        cur_str += cur;
-        cur = Next();
+      case '+':  return token_type::ePlus;
+      case '-':  return token_type::eMinus;
+      case '*':  return token_type::eStar;
+      case '/':  return token_type::eSlash;
+      case '(':  return token_type::eLParen;
+      case ')':  return token_type::eRParen;
+      case '=':  return token_type::eEQ;
+      case '<':  return token_type::eLT;
+      case '>':  return token_type::eGT;
+      case '{':  return token_type::eLBRACE;
+      case '}':  return token_type::eRBRACE;
+      case '[':  return token_type::eLBracket;
+      case ']':  return token_type::eRBracket;
+      case ',':  return token_type::eSemicolon;
+      case '"':  return token_type::eCav;
+      case '!':  return token_type::eEXCL;
+      case '|':  return token_type::eBAR;
+      case '&':  return token_type::eAMP;
       }
+
+      *Size = 0;
+      return token_type::eEOF;
     }
 
     void TokenizeComment(void)
@@ -202,7 +182,7 @@ namespace parser
       while (true)
       {
         if (cur == '\0')
-          throw std::exception("missing close tag!");
+          throw std::runtime_error("missing close tag!");
         if (cur == '*' && Peek(1) == '/')
           break;
         cur = Next();
@@ -211,57 +191,87 @@ namespace parser
       Next();
     }
 
-    bool Check(void)
+    void Count(token_type Type)
     {
-      int lp, rp, lb, rb;
-      lp = rp = lb = rb = 0;
-
-      for (auto& t : Tokens)
-      {
-        if (t.Type == token_type::eLParen)
-          lp++;
-        if (t.Type == token_type::eRParen)
-          rp++;
-        if (t.Type == token_type::eLBRACE)
-          lb++;
-        if (t.Type == token_type::eRBRACE)
-          rb++;
-      }
-
-      return lp == rp && lb == rb;
+      if (Type == token_type::eLParen)
+        Parens++;
+      else if (Type == token_type::eRParen)
+        Parens--;
+      else if (Type == token_type::eLBRACE)
+        Braces++;
+      else if (Type == token_type::eRBRACE)
+        Braces--;
     }
 
   public:
-    lexer(std::string NewInput) : Input(NewInput), CurPos(0), Len((int)Input.size())
+    lexer(std::string_view NewInput) : Input(NewInput), CurPos(0), Len((int)Input.size())
     {
     }
 
-    std::vector<token> Tokenize(void)
+    /* Get next token function.
+     * ARGUMENTS: None.
+     * RETURNS: (token) next token, 'eEOF' token at the end of input.
+     */
+    token Scan(void)
     {
       while (CurPos < Len)
       {
         char cur = Peek(0);
-        std::string cur_str;
-        cur_str += cur;
-
-        if (isdigit(cur))
-          TokenizeNumber();
-        else if (isalpha(cur))
-          TokenizeWord();
-        else if (OPERS.find(cur_str) != OPERS.end())
-          TokenizeOperator();
-        else
+
+        if (IsDigit(cur))
+          return TokenizeNumber();
+        if (IsAlpha(cur))
+          return TokenizeWord();
+
+        int size;
+        token_type type = Operator(cur, Peek(1), &size);
+
+        if (size == 0)
+        {
           Next();
+          continue;
+        }
+        if (type == token_type::eSlash && Peek(1) == '/')
+        {
+          CurPos += 2;
+          TokenizeComment();
+          continue;
+        }
+        if (type == token_type::eSlash && Peek(1) == '*')
+        {
+          CurPos += 2;
+          TokenizeMultiComment();
+          continue;
+        }
+
+        token res(Input.substr(CurPos, size), type);
+
+        CurPos += size;
+        Count(type);
+        return res;
       }
 
-      if (!Check())
-        throw std::exception("incorrect count of tags");
+      if (Parens != 0 || Braces != 0)
+        throw std::runtime_error("incorrect count of tags");
+      return token("", token_type::eEOF);
+    }
+
+    /* Tokenize whole input function.
+     * ARGUMENTS: None.
+     * RETURNS: (std::vector<token>) all tokens without 'eEOF'.
+     */
+    std::vector<token> Tokenize(void)
+    {
+      std::vector<token> tokens;
+
+      for (token t = Scan(); t.Type != token_type::eEOF; t = Scan())
+        tokens.push_back(t);
 
-      return Tokens;
+      return tokens;
     }
   };
 }
 
 #endif
 
-/* END OF 'lexer.h' FILE */
\ No newline at end of file
+/* END OF 'lexer.h' FILE */
@@ -0,0 +1,227 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+ /* FILE NAME   : live.h
+  * PURPOSE     : Ray marching project.
+  *               Parser module.
+  * PROGRAMMER  : Vladislav Biserov.
+  * LAST UPDATE : 02.04.2023
+  * NOTE        : None.
+  *
+  * No part of this file may be changed without agreement of
+  * Computer Graphics Support Group of 30 Phys-Math Lyceum
+  */
+
+#ifndef __live_h_
+#define __live_h_
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+#include "file.h"
+#include "symbol.h"
+
+namespace parser
+{
+  /* Dead code elimination class.
+   * Generated scene code is straight line (control flow is resolved on
+   * compile time) apart from GLSL loops, so chunks are walked backwards
+   * from the 'SceneSDF' results and only chunks assigning a live name are
+   * kept. Names are taken from accesses recorded by emitters, chunk text
+   * isn't read. Declarations are kept for names mentioned by kept code.
+   */
+  class liveness
+  {
+  private:
+    using names = std::unordered_set<int>;
+
+    static constexpr int MaxLogNames = 16; // Eliminated names listed in report
+
+    liveness(void)
+    {
+    }
+
+    /* Apply chunk accesses backwards function.
+     * ARGUMENTS:
+     *   - output chunk:
+     *       const file::chunk &C;
+     *   - names live after chunk, replaced with names live before it:
+     *       names &Live;
+     * RETURNS: None.
+     */
+    static void Apply(const file::chunk &C, names &Live)
+    {
+      // Name read after its assignment isn't live before chunk
+      for (auto a = C.Acc.rbegin(); a != C.Acc.rend(); a++)
+        if (a->Kind == file::access::eKill)
+          Live.erase(a->Name);
+        else if (a->Kind == file::access::eUse)
+          Live.insert(a->Name);
+    } /* End of 'Apply' function */
+
+    /* Walk chunks backwards function.
+     * ARGUMENTS:
+     *   - output chunks:
+     *       const std::vector<file::chunk> &Chunks;
+     *   - chunks range (last is excluded):
+     *       int First, Last;
+     *   - names live after range, replaced with names live before it:
+     *       names &Live;
+     *   - chunks to keep flags (out):
+     *       std::vector<bool> &Keep;
+     * RETURNS: None.
+     */
+    static void Walk(const std::vector<file::chunk> &Chunks, int First, int Last, names &Live, std::vector<bool> &Keep)
+    {
+      for (int i = Last - 1; i >= First; i--)
+      {
+        const file::chunk &c = Chunks[i];
+
+        if (c.IsDecl)
+          continue;
+        if (c.Loop < 0)
+        {
+          int start = i, depth = 1;
+
+          while (depth > 0)
+          {
+            int l = Chunks[--start].Loop;
+
+            depth -= l > 0 ? 1 : l;
+          }
+
+          // Body runs again after itself, so names it and loop header read are live at its end too,
+          // it runs at least once unless header says it may not, so its assignments are done before loop ends
+          const file::chunk &h = Chunks[start];
+          names out = Live, in, next;
+
+          for (auto &a : h.Acc)
+            if (a.Kind == file::access::eUse)
+              out.insert(a.Name);
+          in = out;
+          Walk(Chunks, start + 1, i, in, Keep);
+          for (;;)
+          {
+            next = out;
+            next.insert(in.begin(), in.end());
+            Walk(Chunks, start + 1, i, next, Keep);
+            if (next == in)
+              break;
+            in = std::move(next);
+          }
+          Keep[start] = Keep[i] = std::find(Keep.begin() + start + 1, Keep.begin() + i, true) != Keep.begin() + i;
+          if (Keep[start])
+          {
+            if (h.Loop > 1)
+              in.insert(out.begin(), out.end());
+            Apply(h, in);
+            Live = std::move(in);
+          }
+          i = start;
+          continue;
+        }
+
+        // Chunk is live if it assigns nothing or any name it assigns is read later
+        bool is_live = true;
+
+        for (auto &a : c.Acc)
+          if (a.Kind != file::access::eUse)
+          {
+            is_live = Live.contains(a.Name);
+            if (is_live)
+              break;
+          }
+        Keep[i] = is_live;
+        if (!is_live)
+          continue;
+
+        // Accesses are walked backwards too
+        Apply(c, Live);
+      }
+    } /* End of 'Walk' function */
+
+  public:
+    /* Remove dead chunks from output function.
+     * ARGUMENTS:
+     *   - scene function name for report, empty for scene:
+     *       const std::string &Func;
+     * RETURNS: None.
+     */
+    static void Sweep(const std::string &Func = "")
+    {
+      std::string &buf = file::GetBuf();
+      auto &chunks = file::GetChunks();
+      int n = (int)chunks.size();
+
+      if (n == 0)
+        return;
+
+      auto text = [&](int I) -> std::string_view
+      {
+        size_t end = I + 1 < n ? chunks[I + 1].Start : buf.size();
+
+        return std::string_view(buf).substr(chunks[I].Start, end - chunks[I].Start);
+      };
+
+      // Results of 'SceneSDF' (scene functions return the same way)
+      names live = {file::Res, file::SceneMtl};
+      std::vector<bool> keep(n, true), mentioned(symbols::GetCount(), false);
+      int total = 0, removed = 0;
+
+      Walk(chunks, 0, n, live, keep);
+      for (int i = 0; i < n; i++)
+        if (!chunks[i].IsDecl)
+        {
+          // Loop header is counted with its body, its counter is mentioned if loop is kept
+          if (chunks[i].Loop == 0)
+          {
+            total++;
+            removed += !keep[i];
+          }
+          if (!keep[i])
+            continue;
+          for (auto &a : chunks[i].Acc)
+            if (a.Name >= 0)
+              mentioned[a.Name / 3] = true;
+        }
+
+      std::string res(buf, 0, chunks[0].Start), dead;
+      int dead_cnt = 0;
+
+      for (int i = 0; i < n; i++)
+      {
+        if (chunks[i].IsDecl && !mentioned[chunks[i].Owner])
+        {
+          // Lights have no declaration text
+          if (!text(i).empty() && dead_cnt++ < MaxLogNames)
+            dead += (dead.empty() ? "" : ", ") + symbols::GetName(chunks[i].Owner);
+          continue;
+        }
+        if (!keep[i])
+          continue;
+        // Last statement of loop body may be removed
+        if (chunks[i].Loop < 0)
+          while (res.ends_with("\n\n"))
+            res.pop_back();
+        res += text(i);
+      }
+      buf = std::move(res);
+      chunks.clear();
+
+      std::string where = Func.empty() ? "" : std::format(" in function '{}'", Func);
+
+      report::Add(std::format("dead code elimination{}: {} of {} statements removed", where, removed, total));
+      if (dead_cnt > MaxLogNames)
+        dead += std::format(" and {} more", dead_cnt - MaxLogNames);
+      if (dead_cnt > 0)
+        report::Add("eliminated variables" + where + ": " + dead);
+    } /* End of 'Sweep' function */
+  }; /* End of 'liveness' class */
+}
+
+#endif
+
+/* END OF 'live.h' FILE */
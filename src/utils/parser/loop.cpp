@@ -0,0 +1,362 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : loop.cpp
+ * PURPOSE     : Ray marching project.
+ *               Parser module.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 30.03.2023
+ * NOTE        : None.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include <algorithm>
+#include <ctype.h>
+
+#include "loop.h"
+#include "expr.h"
+
+thread_local std::vector<std::vector<double>> parser::loops::Data;
+thread_local int
+  parser::loops::Unrolled = 0,
+  parser::loops::Depth = 0,
+  parser::loops::Emitted = 0,
+  parser::loops::Direct = 0;
+
+/* Split text to numbers and the rest function.
+ * ARGUMENTS:
+ *   - iteration text:
+ *       std::string_view Text;
+ *   - numbers found (out):
+ *       std::vector<number> &Nums;
+ * RETURNS: (std::string) text with numbers replaced by '\1' (float) and '\2' (int) marks.
+ */
+std::string parser::loops::Split( std::string_view Text, std::vector<number> &Nums )
+{
+  std::string res;
+  size_t p = 0, n = Text.size();
+
+  while (p < n)
+  {
+    char c = Text[p];
+
+    // Comments and names are kept as is, even if they have digits
+    if (c == '/' && p + 1 < n && Text[p + 1] == '/')
+    {
+      size_t end = Text.find('\n', p);
+
+      if (end == std::string_view::npos)
+        end = n;
+      res += Text.substr(p, end - p);
+      p = end;
+      continue;
+    }
+    if (isalpha((unsigned char)c) || c == '_')
+    {
+      size_t start = p;
+
+      while (p < n && (isalnum((unsigned char)Text[p]) || Text[p] == '_'))
+        p++;
+      res += Text.substr(start, p - start);
+      continue;
+    }
+
+    // Negative literals are written in parentheses, negative zero is not
+    bool
+      is_neg = c == '(' && p + 2 < n && Text[p + 1] == '-' && isdigit((unsigned char)Text[p + 2]),
+      is_zero = c == '-' && p + 1 < n && isdigit((unsigned char)Text[p + 1]) && !res.empty() &&
+        std::string_view("(,= ").find(res.back()) != std::string_view::npos;
+
+    if (isdigit((unsigned char)c) || is_neg || is_zero)
+    {
+      size_t
+        start = is_neg ? p + 1 : p,
+        end = is_neg ? p + 2 : p + is_zero;
+
+      while (end < n && (isalnum((unsigned char)Text[end]) || Text[end] == '.' ||
+             ((Text[end] == '+' || Text[end] == '-') && Text[end - 1] == 'e')))
+        end++;
+      if (!is_neg || (end < n && Text[end] == ')'))
+      {
+        std::string_view num = Text.substr(start, end - start);
+        bool is_int = num.find_first_of(".e") == std::string_view::npos;
+
+        Nums.push_back({num, is_int});
+        res += is_int ? '\2' : '\1';
+        p = is_neg ? end + 1 : end;
+        continue;
+      }
+    }
+    res += c;
+    p++;
+  }
+  return res;
+} /* End of 'parser::loops::Split' function */
+
+/* Replace loop iterations text with GLSL loop function.
+ * Iterations are compared chunk by chunk, body of GLSL loop keeps chunks
+ * of first iteration, so dead code elimination sees its statements.
+ * ARGUMENTS:
+ *   - loop id, set on first replace (-1 if not set yet):
+ *       int &Id;
+ *   - loop text start offset in output buffer:
+ *       size_t Start;
+ *   - iterations text end offsets:
+ *       const std::vector<size_t> &Ends;
+ * RETURNS: None.
+ */
+void parser::loops::Emit( int &Id, size_t Start, const std::vector<size_t> &Ends )
+{
+  std::string &buf = file::GetBuf();
+  auto &chunks = file::GetChunks();
+  int n = (int)Ends.size();
+
+  if (n < MinCount)
+    return;
+
+  // Iterations chunks, text before first chunk can't be kept
+  int first = (int)chunks.size();
+
+  while (first > 0 && chunks[first - 1].Start >= Start)
+    first--;
+  if (first == (int)chunks.size() || chunks[first].Start != Start)
+  {
+    Unrolled += Start != Ends.back();
+    return;
+  }
+
+  std::vector<std::vector<number>> nums(n);
+  std::vector<std::string> texts;
+  int cnt = 0, c = first;
+
+  for (int i = 0; i < n; i++)
+  {
+    size_t from = i == 0 ? Start : Ends[i - 1];
+    int k = 0;
+
+    if (from < Ends[i] && (c == (int)chunks.size() || chunks[c].Start != from))
+    {
+      Unrolled++;
+      return;
+    }
+    for (; c < (int)chunks.size() && chunks[c].Start < Ends[i]; c++, k++)
+    {
+      size_t end = c + 1 < (int)chunks.size() ? std::min(chunks[c + 1].Start, Ends[i]) : Ends[i];
+      std::string cur = Split(std::string_view(buf).substr(chunks[c].Start, end - chunks[c].Start), nums[i]);
+
+      if (i == 0)
+      {
+        texts.push_back(std::move(cur));
+        continue;
+      }
+
+      const file::chunk &a = chunks[first + k], &b = chunks[c];
+      bool is_same = k < cnt && cur == texts[k] && a.Owner == b.Owner && a.Loop == b.Loop &&
+        a.Acc.size() == b.Acc.size() &&
+        std::equal(a.Acc.begin(), a.Acc.end(), b.Acc.begin(),
+          [](const file::access &A, const file::access &B) { return A.Kind == B.Kind && A.Name == B.Name; });
+
+      if (!is_same)
+      {
+        Unrolled++;
+        return;
+      }
+    }
+    if (i == 0)
+      cnt = k;
+    else if (k != cnt)
+    {
+      Unrolled++;
+      return;
+    }
+  }
+
+  // Numbers differing between iterations become array elements
+  int
+    vals_cnt = (int)nums[0].size(),
+    stride = 0;
+  std::vector<int> index(vals_cnt, -1), column;
+  auto is_same = [&](int J1, int J2)
+  {
+    for (int i = 0; i < n; i++)
+      if (nums[i][J1].Text != nums[i][J2].Text)
+        return false;
+    return true;
+  };
+
+  for (int j = 0; j < vals_cnt; j++)
+    for (int i = 1; i < n; i++)
+      if (nums[i][j].Text != nums[0][j].Text)
+      {
+        // Shapes are printed again by modifications, their numbers repeat
+        for (int k = 0; k < stride && index[j] < 0; k++)
+          if (is_same(j, column[k]))
+            index[j] = k;
+        if (index[j] < 0)
+        {
+          index[j] = stride++;
+          column.push_back(j);
+        }
+        break;
+      }
+
+  if (Id < 0)
+  {
+    Id = (int)Data.size();
+    Data.emplace_back();
+  }
+
+  std::vector<double> &data = Data[Id], vals;
+
+  for (int i = 0; i < n; i++)
+    for (int j : column)
+    {
+      double val = 0;
+
+      std::from_chars(nums[i][j].Text.data(), nums[i][j].Text.data() + nums[i][j].Text.size(), val);
+      vals.push_back(val);
+    }
+
+  // Inner loops usually get the same values in each outer iteration
+  auto found = std::search(data.begin(), data.end(), vals.begin(), vals.end());
+  size_t base = found - data.begin();
+
+  if (found == data.end())
+    data.insert(data.end(), vals.begin(), vals.end());
+
+  std::string name = Name(Id);
+  std::vector<std::string> body(cnt);
+  bool is_line = true;
+  int j = 0;
+
+  for (int k = 0; k < cnt; k++)
+    for (char ch : texts[k])
+    {
+      std::string &res = body[k];
+
+      if (is_line && ch != '\n')
+        res += "  ";
+      is_line = ch == '\n';
+      if (ch != '\1' && ch != '\2')
+      {
+        res += ch;
+        continue;
+      }
+
+      std::string_view num = nums[0][j].Text;
+
+      if (index[j] < 0)
+        res += num[0] == '-' ? std::format("({})", num) : std::string(num);
+      else
+      {
+        std::string elem = std::format("{0}[{0}_b + {0}_n", name);
+
+        if (stride > 1)
+          elem += std::format(" * {}", stride);
+        if (index[j] > 0)
+          elem += std::format(" + {}", index[j]);
+        elem += ']';
+        res += ch == '\2' ? "int(" + elem + ")" : elem;
+      }
+      j++;
+    }
+  while (cnt > 0 && body[cnt - 1].ends_with("\n\n"))
+    body[cnt - 1].pop_back();
+
+  std::vector<file::chunk> marks(chunks.begin() + first, chunks.begin() + first + cnt);
+
+  buf.resize(Start);
+  chunks.resize(first);
+  file::Mark(-1);
+  chunks.back().Loop = 1;
+  buf += std::format("// loop of objects\n"
+    "for (int {0}_n = 0, {0}_b = {1}; {0}_n < {2}; {0}_n++)\n{{\n", name, base, n);
+  for (int k = 0; k < cnt; k++)
+  {
+    file::Mark(marks[k].Owner);
+    chunks.back().Loop = marks[k].Loop;
+    chunks.back().Acc = std::move(marks[k].Acc);
+    buf += body[k];
+  }
+  file::Mark(-1);
+  chunks.back().Loop = -1;
+  buf += "}\n\n";
+} /* End of 'parser::loops::Emit' function */
+
+/* Indent loop body text function.
+ * ARGUMENTS:
+ *   - body text start offset in output buffer:
+ *       size_t Start;
+ * RETURNS: None.
+ */
+void parser::loops::Indent( size_t Start )
+{
+  std::string &buf = file::GetBuf();
+  auto &chunks = file::GetChunks();
+  std::string res;
+  std::vector<size_t> offs(buf.size() - Start + 1);
+  bool is_line = true;
+
+  for (size_t p = Start; p < buf.size(); p++)
+  {
+    offs[p - Start] = Start + res.size();
+    if (is_line && buf[p] != '\n')
+      res += "  ";
+    is_line = buf[p] == '\n';
+    res += buf[p];
+  }
+  offs.back() = Start + res.size();
+  for (auto &c : chunks)
+    if (c.Start >= Start)
+      c.Start = offs[c.Start - Start];
+  buf.resize(Start);
+  buf += res;
+} /* End of 'parser::loops::Indent' function */
+
+/* Get loop arrays declaration function.
+ * ARGUMENTS:
+ *   - scene code (arrays of removed loops are skipped):
+ *       const std::string &Scene;
+ * RETURNS: (std::string) GLSL text.
+ */
+std::string parser::loops::GetStr( const std::string &Scene )
+{
+  std::string res;
+
+  for (int i = 0; i < (int)Data.size(); i++)
+  {
+    std::string name = Name(i);
+
+    if (Data[i].empty() || Scene.find(name + "[") == std::string::npos)
+      continue;
+    res += std::format("const float {}[] = float[](", name);
+    for (size_t j = 0; j < Data[i].size(); j++)
+    {
+      if (j > 0)
+        res += j % 8 == 0 ? ",\n  " : ", ";
+      expr::Literal(res, Data[i][j]);
+    }
+    res += ");\n";
+  }
+  return res.empty() ? res : res + "\n";
+} /* End of 'parser::loops::GetStr' function */
+
+/* Get loops statistics function.
+ * ARGUMENTS: None.
+ * RETURNS: (std::string) report line.
+ */
+std::string parser::loops::GetStat( void )
+{
+  size_t vals = 0;
+
+  for (auto &d : Data)
+    vals += d.size();
+  return std::format("GLSL loops: {} emitted from syntax tree, {} from iterations text with {} array values, {} left unrolled",
+    Direct, Data.size(), vals, Unrolled);
+} /* End of 'parser::loops::GetStat' function */
+
+/* END OF 'loop.cpp' FILE */
@@ -0,0 +1,132 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+ /* FILE NAME   : loop.h
+  * PURPOSE     : Ray marching project.
+  *               Parser module.
+  * PROGRAMMER  : Vladislav Biserov.
+  * LAST UPDATE : 30.03.2023
+  * NOTE        : None.
+  *
+  * No part of this file may be changed without agreement of
+  * Computer Graphics Support Group of 30 Phys-Math Lyceum
+  */
+
+#ifndef __loop_h_
+#define __loop_h_
+
+#include <format>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace parser
+{
+  /* GLSL loops class.
+   * Loops building objects which syntax tree fits GLSL are emitted once with
+   * counter kept in GLSL. Other loops are executed on compile time as before,
+   * but if text of all iterations differs in numbers only, it is replaced with
+   * one GLSL 'for' loop reading the numbers from constant array.
+   */
+  class loops
+  {
+  private:
+    /* Number in iteration text structure */
+    struct number
+    {
+      std::string_view Text; // Literal text
+      bool IsInt;            // Is literal integer
+    }; /* End of 'number' structure */
+
+    static thread_local std::vector<std::vector<double>> Data; // Arrays by loop id
+    static thread_local int Unrolled;                         // Number of loops left unrolled
+    static thread_local int Depth;                            // Nesting depth of loops being recorded
+    static thread_local int Emitted;                          // Nesting depth of loops emitted from syntax tree
+    static thread_local int Direct;                           // Number of loops emitted from syntax tree
+
+    loops(void)
+    {
+    }
+
+    static std::string Split(std::string_view Text, std::vector<number> &Nums);
+
+  public:
+    static constexpr int MinCount = 2; // Minimal number of iterations to make GLSL loop
+
+    /* Reset loops function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    static void Clear(void)
+    {
+      Data.clear();
+      Unrolled = Depth = Emitted = Direct = 0;
+    } /* End of 'Clear' function */
+
+    /* Start or finish loop recording function.
+     * ARGUMENTS:
+     *   - is loop started:
+     *       bool IsStart;
+     * RETURNS: None.
+     */
+    static void Record(bool IsStart)
+    {
+      Depth += IsStart ? 1 : -1;
+    } /* End of 'Record' function */
+
+    /* Check is loop being recorded function.
+     * Text of loop iteration is emitted once, so it can't keep per iteration values.
+     * ARGUMENTS: None.
+     * RETURNS: (bool) is output in recorded loop.
+     */
+    static bool IsRecording(void)
+    {
+      return Depth > 0;
+    } /* End of 'IsRecording' function */
+
+    /* Start or finish loop emission from syntax tree function.
+     * ARGUMENTS:
+     *   - is loop started:
+     *       bool IsStart;
+     * RETURNS: None.
+     */
+    static void Symbolic(bool IsStart)
+    {
+      Direct += IsStart;
+      Emitted += IsStart ? 1 : -1;
+    } /* End of 'Symbolic' function */
+
+    /* Check is loop being emitted from syntax tree function.
+     * Values depending on loop variables are written as GLSL expressions then.
+     * ARGUMENTS: None.
+     * RETURNS: (bool) is output in GLSL loop body.
+     */
+    static bool IsSymbolic(void)
+    {
+      return Emitted > 0;
+    } /* End of 'IsSymbolic' function */
+
+    /* Get loop array GLSL name function.
+     * Scene identifiers start with a letter, so generated names can't clash with them.
+     * ARGUMENTS:
+     *   - loop id:
+     *       int Id;
+     * RETURNS: (std::string) name.
+     */
+    static std::string Name(int Id)
+    {
+      return std::format("_loop{}", Id);
+    } /* End of 'Name' function */
+
+    static void Emit(int &Id, size_t Start, const std::vector<size_t> &Ends);
+    static void Indent(size_t Start);
+    static std::string GetStr(const std::string &Scene);
+    static std::string GetStat(void);
+  }; /* End of 'loops' class */
+}
+
+#endif
+
+/* END OF 'loop.h' FILE */
@@ -14,12 +14,15 @@
  * Computer Graphics Support Group of 30 Phys-Math Lyceum
  */
 
+#include <algorithm>
+
+#include "../symbol.h"
 #include "light.h"
 
-std::map<std::string, std::pair<std::string, bool>>
+thread_local std::vector<parser::obj::light::source>
   parser::obj::light::Point {}, parser::obj::light::Spot {}, parser::obj::light::Dir {};
 
-int
+thread_local int
   parser::obj::light::PointCnt = 0,
   parser::obj::light::DirCnt = 0,
   parser::obj::light::SpotCnt = 0;
@@ -38,27 +41,76 @@ const std::map<parser::obj::light::type, std::vector<parser::param::type>> parse
   {parser::obj::light::type::eSpot, {param::type::eVec, param::type::eVec, param::type::eVec}},
 };
 
-const std::map<parser::obj::light::type, std::function<void(std::string, std::vector<std::string>)>> parser::obj::light::Add
+/* Get light source by symbol id function.
+ * ARGUMENTS:
+ *   - sources of one type:
+ *       std::vector<source> &Src;
+ *   - symbol id:
+ *       int Id;
+ * RETURNS: (source &) light source.
+ */
+parser::obj::light::source & parser::obj::light::At( std::vector<source> &Src, int Id )
+{
+  if (Id >= (int)Src.size())
+    Src.resize(Id + 1);
+  return Src[Id];
+} /* End of 'parser::obj::light::At' function */
+
+/* Join enabled sources function.
+ * ARGUMENTS:
+ *   - sources of one type:
+ *       const std::vector<source> &Src;
+ * RETURNS: (std::string) comma separated constructors ordered by light name.
+ */
+std::string parser::obj::light::Join( const std::vector<source> &Src )
+{
+  std::vector<int> ids;
+  std::string res;
+
+  for (int i = 0; i < (int)Src.size(); i++)
+    if (Src[i].IsEnabled)
+      ids.push_back(i);
+  std::sort(ids.begin(), ids.end(), [](int A, int B) { return symbols::GetName(A) < symbols::GetName(B); });
+
+  for (int id : ids)
+  {
+    if (!res.empty())
+      res += ", ";
+    res += Src[id].Text;
+  }
+  return res;
+} /* End of 'parser::obj::light::Join' function */
+
+const std::map<parser::obj::light::type, std::function<void(int, std::vector<std::string>)>> parser::obj::light::Add
 {
   /* Point light */
   {
-    parser::obj::light::type::ePoint, std::function([](std::string Var, std::vector<std::string> P) -> void
+    parser::obj::light::type::ePoint, std::function([](int Id, std::vector<std::string> P) -> void
     {
-      Point.emplace(Var, std::make_pair(std::format("point_light({0}, {1}, 0.4, 0.6, 0.06)", P[0], P[1]), false));
+      source &s = At(Point, Id);
+
+      if (!s.IsAdded)
+        s = {std::format("point_light({0}, {1}, 0.4, 0.6, 0.06)", P[0], P[1]), true, false};
     })
   }, /* End of 'Point Light' */
   /* Dir light */
   {
-    parser::obj::light::type::eDir, std::function([](std::string Var, std::vector<std::string> P) -> void
+    parser::obj::light::type::eDir, std::function([](int Id, std::vector<std::string> P) -> void
     {
-      Dir.emplace(Var, std::make_pair(std::format("dir_light({0}, {1})", P[0], P[1]), false));
+      source &s = At(Dir, Id);
+
+      if (!s.IsAdded)
+        s = {std::format("dir_light({0}, {1})", P[0], P[1]), true, false};
     })
   }, /* End of 'Dir Light' */
   /* Spot light */
   {
-    parser::obj::light::type::eSpot, std::function([](std::string Var, std::vector<std::string> P) -> void
+    parser::obj::light::type::eSpot, std::function([](int Id, std::vector<std::string> P) -> void
     {
-      Spot.emplace(Var, std::make_pair(std::format("spot_light({0}, {1}, {2}, cos(0.1), cos(1.1))", P[0], P[1], P[2]), false));
+      source &s = At(Spot, Id);
+
+      if (!s.IsAdded)
+        s = {std::format("spot_light({0}, {1}, {2}, cos(0.1), cos(1.1))", P[0], P[1], P[2]), true, false};
     })
   }, /* End of 'Spot Light' */
 };
@@ -69,16 +121,8 @@ std::string parser::obj::light::GetStr( void )
 
   if (PointCnt != 0)
   {
-    std::string Buf;
-    bool flag = false;
-
-    for (auto &l : Point)
-      if (l.second.second)
-      {
-        if (flag)
-          Buf += ", ";
-        Buf += l.second.first, flag = true;
-      }
+    std::string Buf = Join(Point);
+
     res += std::format("bool IsPointLgt = true;\n");
     res += std::format("const int PointLgtCnt = {};\n", PointCnt);
     res += std::format("const point_light PointLgt[PointLgtCnt] = {{{}}}; \n", Buf);
@@ -91,16 +135,7 @@ std::string parser::obj::light::GetStr( void )
   }
   if (DirCnt != 0)
   {
-    std::string Buf;
-    bool flag = false;
-
-    for (auto &l : Dir)
-      if (l.second.second)
-      {
-        if (flag)
-          Buf += ", ";
-        Buf += l.second.first, flag = true;
-      }
+    std::string Buf = Join(Dir);
 
     res += std::format("bool IsDirLgt = true;\n");
     res += std::format("const int DirLgtCnt = {};\n", DirCnt);
@@ -114,16 +149,7 @@ std::string parser::obj::light::GetStr( void )
   }
   if (SpotCnt != 0)
   {
-    std::string Buf;
-    bool flag = false;
-
-    for (auto &l : Spot)
-      if (l.second.second)
-      {
-        if (flag)
-          Buf += ", ";
-        Buf += l.second.first, flag = true;
-      }
+    std::string Buf = Join(Spot);
     
     res += std::format("bool IsSpotLgt = true;\n");
     res += std::format("const int SpotLgtCnt = {};\n", SpotCnt);
@@ -147,22 +173,22 @@ std::string parser::obj::light::GetStr( void )
   return res;
 }
 
-void parser::obj::light::Enable(const std::string &Name)
+void parser::obj::light::Enable( int Id )
 {
-  if (Point.find(Name) != Point.end())
+  if (Id < (int)Point.size() && Point[Id].IsAdded)
   {
-    if (!Point[Name].second)
-      Point[Name].second = true, PointCnt++;
+    if (!Point[Id].IsEnabled)
+      Point[Id].IsEnabled = true, PointCnt++;
   }
-  else if (Spot.find(Name) != Spot.end())
+  else if (Id < (int)Spot.size() && Spot[Id].IsAdded)
   {
-    if (!Spot[Name].second)
-      Spot[Name].second = true, SpotCnt++;
+    if (!Spot[Id].IsEnabled)
+      Spot[Id].IsEnabled = true, SpotCnt++;
   }
-  else if (Dir.find(Name) != Dir.end())
+  else if (Id < (int)Dir.size() && Dir[Id].IsAdded)
   {
-    if (!Dir[Name].second)
-      Dir[Name].second = true, DirCnt++;
+    if (!Dir[Id].IsEnabled)
+      Dir[Id].IsEnabled = true, DirCnt++;
   }
 }
 
@@ -34,12 +34,23 @@ namespace parser
     class light
     {
     private:
-      static std::map<std::string, std::pair<std::string, bool>> Point, Spot, Dir;
-      static int 
+      /* Light source structure */
+      struct source
+      {
+        std::string Text;       // GLSL constructor
+        bool IsAdded = false;   // Is light created
+        bool IsEnabled = false; // Is light added to scene
+      }; /* End of 'source' structure */
+
+      static thread_local std::vector<source> Point, Spot, Dir; // Sources by symbol id
+      static thread_local int 
         PointCnt,
         SpotCnt,
         DirCnt;
 
+      static source & At(std::vector<source> &Src, int Id);
+      static std::string Join(const std::vector<source> &Src);
+
     public:
       /* Light type */
       enum class type
@@ -54,9 +65,9 @@ namespace parser
 
       static const std::map<type, std::vector<param::type>> Types;
 
-      static const std::map<type, std::function<void(std::string, std::vector<std::string>)>> Add;
+      static const std::map<type, std::function<void(int, std::vector<std::string>)>> Add;
 
-      static void Enable(const std::string &Name);
+      static void Enable(int Id);
 
       static std::string GetStr(void);
     }; /* End of 'light' class */
@@ -23,6 +23,8 @@ const std::map<std::string, parser::obj::mod::type> parser::obj::mod::Table =
   {"rotate", parser::obj::mod::type::eRotate},
   {"translate", parser::obj::mod::type::eTranslate},
   {"scale", parser::obj::mod::type::eScale},
+  {"repeat", parser::obj::mod::type::eRepeat},
+  {"mirror", parser::obj::mod::type::eMirror},
 };
 
 const std::map<parser::obj::mod::type, std::vector<parser::param::type>> parser::obj::mod::Types = 
@@ -30,6 +32,8 @@ const std::map<parser::obj::mod::type, std::vector<parser::param::type>> parser:
   {parser::obj::mod::type::eRotate, {param::type::eNum, param::type::eVec}},
   {parser::obj::mod::type::eTranslate, {param::type::eVec}},
   {parser::obj::mod::type::eScale, {param::type::eVec}},
+  {parser::obj::mod::type::eRepeat, {param::type::eVec, param::type::eVec}},
+  {parser::obj::mod::type::eMirror, {param::type::eVec}},
 };
 
 const std::map<parser::obj::mod::type, std::function<std::string(std::string, std::vector<std::string>)>> parser::obj::mod::ToStr
@@ -37,22 +41,33 @@ const std::map<parser::obj::mod::type, std::function<std::string(std::string, st
   { // Rotate
     parser::obj::mod::type::eRotate, std::function([](std::string Var, std::vector<std::string> P) -> std::string
     {
-      return std::format("mod_{0} = Rotate({1}, {2}, mod_{0});\n", Var, P[0], P[1]) +
-             variables::GetShape(Var);
+      return std::format("mod_{0} = Rotate({1}, {2}, mod_{0});\n", Var, P[0], P[1]);
     })
   },
   { // Scale
     parser::obj::mod::type::eScale, std::function([](std::string Var, std::vector<std::string> P) -> std::string
     {
-      return std::format("mod_{0} = Scale({1}, mod_{0});\n", Var, P[0]) +
-             variables::GetShape(Var);
+      return std::format("mod_{0} = Scale({1}, mod_{0});\n", Var, P[0]);
     })
   },
   { // Translate
     parser::obj::mod::type::eTranslate, std::function([](std::string Var, std::vector<std::string> P) -> std::string
     {
-      return std::format("mod_{0} = Translate({1}, mod_{0});\n", Var, P[0]) +
-             variables::GetShape(Var);
+      return std::format("mod_{0} = Translate({1}, mod_{0});\n", Var, P[0]);
+    })
+  },
+  { // Repeat
+    parser::obj::mod::type::eRepeat, std::function([](std::string Var, std::vector<std::string> P) -> std::string
+    {
+      if (P.size() < 2)
+        return std::format("mod_{0} = Replication({1}, mod_{0});\n", Var, P[0]);
+      return std::format("mod_{0} = ReplicationLimited({1}, {2}, mod_{0});\n", Var, P[0], P[1]);
+    })
+  },
+  { // Mirror
+    parser::obj::mod::type::eMirror, std::function([](std::string Var, std::vector<std::string> P) -> std::string
+    {
+      return std::format("mod_{0} = Mirror({1}, mod_{0});\n", Var, P[0]);
     })
   },
 };
@@ -7,7 +7,7 @@
   * PURPOSE     : Ray marching project.
   *               Parser module.
   * PROGRAMMER  : Vladislav Biserov.
-  * LAST UPDATE : 30.03.2023
+  * LAST UPDATE : 02.04.2023
   * NOTE        : None.
   *
   * No part of this file may be changed without agreement of
@@ -37,6 +37,8 @@ namespace parser
         eRotate,
         eTranslate,
         eScale,
+        eRepeat,   // Domain repetition by period, count of cells is optional
+        eMirror,   // Reflection of half-space behind plane by its normal
       };
 
       static const std::map<std::string, type> Table;
@@ -7,17 +7,23 @@
  * PURPOSE     : Ray marching project.
  *               Parser module.
  * PROGRAMMER  : Vladislav Biserov.
- * LAST UPDATE : 30.03.2023
+ * LAST UPDATE : 02.04.2023
  * NOTE        : None.
  *
  * No part of this file may be changed without agreement of
  * Computer Graphics Support Group of 30 Phys-Math Lyceum
  */
 
+#include <algorithm>
+
 #include "oper.h"
 
 #include "../variable.h"
 
+thread_local int
+  parser::obj::oper::Total = 0,
+  parser::obj::oper::Simps[4] {};
+
 const std::map<std::string, parser::obj::oper::type> parser::obj::oper::Table =
 {
   {"union", parser::obj::oper::type::eUnion},
@@ -41,11 +47,9 @@ const std::map<parser::obj::oper::type, std::vector<parser::param::type>> parser
 const std::map<parser::obj::oper::type, std::function<std::string(std::string, std::string, std::string, std::optional<std::string>)>> parser::obj::oper::ToStr
 {
   { // Union
-    parser::obj::oper::type::eUnion, std::function([](std::string Var, std::string P1, std::string P2, std::optional<std::string> K) -> std::string
+    parser::obj::oper::type::eUnion, std::function([](std::string Var, std::string P1, std::string P2, std::optional<std::string>) -> std::string
     { 
-      return CheckParamsMtl(Var, P1, P2) + 
-             std::format("{0} = SDFUnion({1}, {2});\n", Var, P1, P2) +
-             GetMtl(Var, P1, P2); 
+      return Select(Var, P1, P2, "SDFUnion", "<");
     })
   },
   { // Smooth union
@@ -57,7 +61,7 @@ const std::map<parser::obj::oper::type, std::function<std::string(std::string, s
     })
   },
   { // Difference
-    parser::obj::oper::type::eDiff, std::function([](std::string Var, std::string P1, std::string P2, std::optional<std::string> K) -> std::string
+    parser::obj::oper::type::eDiff, std::function([](std::string Var, std::string P1, std::string P2, std::optional<std::string>) -> std::string
     { 
       return CheckParamsMtl(Var, P1, P2) + 
              std::format("{0} = SDFDifer({1}, {2});\n", Var, P1, P2) +
@@ -73,11 +77,9 @@ const std::map<parser::obj::oper::type, std::function<std::string(std::string, s
     })
   },
   { // Intersection
-    parser::obj::oper::type::eInter, std::function([](std::string Var, std::string P1, std::string P2, std::optional<std::string> K) -> std::string
+    parser::obj::oper::type::eInter, std::function([](std::string Var, std::string P1, std::string P2, std::optional<std::string>) -> std::string
     { 
-      return CheckParamsMtl(Var, P1, P2) + 
-             std::format("{0} = SDFInter({1}, {2});\n", Var, P1, P2) +
-             GetMtl(Var, P1, P2); 
+      return Select(Var, P1, P2, "SDFInter", ">");
     })
   },
   { // Smooth intersectioin
@@ -90,4 +92,84 @@ const std::map<parser::obj::oper::type, std::function<std::string(std::string, s
   },
 };
 
+/* Get n-ary union text function.
+ * Union is found in single pass: distance is running minimum and only index
+ * of nearest operand is tracked, material is taken by index once at the end.
+ * ARGUMENTS:
+ *   - result shape name:
+ *       const std::string &Var;
+ *   - operands shape names:
+ *       const std::vector<std::string> &Ps;
+ * RETURNS: (std::string) GLSL text.
+ */
+std::string parser::obj::oper::Nary( const std::string &Var, const std::vector<std::string> &Ps )
+{
+  std::string res = std::format("tmp = {};\n", Ps[0]);
+
+  // Equal distances keep earlier operand as chain of unions does
+  for (size_t i = 1; i < Ps.size(); i++)
+    res += param::MtlOnly(std::format("tmp_id = {} < tmp ? {} : {};\n", Ps[i], i, i == 1 ? "0" : "tmp_id")) +
+      std::format("tmp = SDFUnion(tmp, {});\n", Ps[i]);
+  return res + std::format("{} = tmp;\n", Var) + param::MtlOnly(Switch("mtl_" + Var, Ps));
+} /* End of 'parser::obj::oper::Nary' function */
+
+/* Get material selection by nearest shape index text function.
+ * ARGUMENTS:
+ *   - material variable name:
+ *       const std::string &Dst;
+ *   - shape names in index order:
+ *       const std::vector<std::string> &Ps;
+ * RETURNS: (std::string) GLSL text reading 'tmp_id'.
+ */
+std::string parser::obj::oper::Switch( const std::string &Dst, const std::vector<std::string> &Ps )
+{
+  std::string res = "switch (tmp_id)\n{\n";
+
+  for (size_t i = 0; i < Ps.size(); i++)
+    if (Dst != "mtl_" + Ps[i])
+      res += std::format("case {}:\n  {} = mtl_{};\n  break;\n", i, Dst, Ps[i]);
+  return res + "}\n";
+} /* End of 'parser::obj::oper::Switch' function */
+
+/* Reset operations statistics function.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+void parser::obj::oper::Clear( void )
+{
+  Total = 0;
+  std::fill(Simps, Simps + 4, 0);
+} /* End of 'parser::obj::oper::Clear' function */
+
+/* Count compiled operation function.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+void parser::obj::oper::Count( void )
+{
+  Total++;
+} /* End of 'parser::obj::oper::Count' function */
+
+/* Count operation simplification function.
+ * ARGUMENTS:
+ *   - simplification kind:
+ *       simp Kind;
+ * RETURNS: None.
+ */
+void parser::obj::oper::Count( simp Kind )
+{
+  Simps[(int)Kind]++;
+} /* End of 'parser::obj::oper::Count' function */
+
+/* Get operations statistics function.
+ * ARGUMENTS: None.
+ * RETURNS: (std::string) report line.
+ */
+std::string parser::obj::oper::GetStat( void )
+{
+  return std::format("operations: {} compiled, {} smooth with zero coefficient, {} of shape with itself, "
+    "{} unions with inner shape, {} differences with shape apart",
+    Total, Simps[(int)simp::eZeroK], Simps[(int)simp::eSame], Simps[(int)simp::eInside], Simps[(int)simp::eApart]);
+} /* End of 'parser::obj::oper::GetStat' function */
+
 /* END OF 'oper.cpp' FILE */
\ No newline at end of file
@@ -7,7 +7,7 @@
   * PURPOSE     : Ray marching project.
   *               Parser module.
   * PROGRAMMER  : Vladislav Biserov.
-  * LAST UPDATE : 30.03.2023
+  * LAST UPDATE : 02.04.2023
   * NOTE        : None.
   *
   * No part of this file may be changed without agreement of
@@ -49,13 +49,77 @@ namespace parser
 
       static const std::map<type, std::function<std::string(std::string, std::string, std::string, std::optional<std::string>)>> ToStr;
 
+      /* Operation simplification kind */
+      enum class simp
+      {
+        eZeroK,  // Smooth operation with zero coefficient is the plain one
+        eSame,   // Union or intersection of shape with itself
+        eInside, // Union with shape inside other operand
+        eApart,  // Difference with shape apart from first operand
+      };
+
+      static std::string Nary(const std::string &Var, const std::vector<std::string> &Ps);
+      static std::string Switch(const std::string &Dst, const std::vector<std::string> &Ps);
+      static void Clear(void);
+      static void Count(void);
+      static void Count(simp Kind);
+      static std::string GetStat(void);
+
+      /* Get operand copy text function.
+       * ARGUMENTS:
+       *   - result and operand shape names:
+       *       const std::string &Var, &P;
+       * RETURNS: (std::string) GLSL text, empty if result is the operand.
+       */
+      static std::string Copy(const std::string &Var, const std::string &P)
+      {
+        if (Var == P)
+          return "";
+        return std::format("{0} = {1};\n", Var, P) + param::MtlOnly(std::format("mtl_{0} = mtl_{1};\n", Var, P));
+      } /* End of 'Copy' function */
+
     private:
+      static thread_local int Total;    // Operations compiled
+      static thread_local int Simps[4]; // Simplified operations by kind
+
+      /* Get plain union or intersection text function.
+       * Result is one of operands, so its material is taken without blending.
+       * Operands are compared before result replaces one of them, equal
+       * distances keep material of result (of first operand for new result).
+       * ARGUMENTS:
+       *   - result and operands shape names:
+       *       const std::string &Var, &P1, &P2;
+       *   - GLSL function name:
+       *       const char *Func;
+       *   - comparison choosing second operand:
+       *       const char *Cmp;
+       * RETURNS: (std::string) GLSL text.
+       */
+      static std::string Select(const std::string &Var, const std::string &P1, const std::string &P2, const char *Func, const char *Cmp)
+      {
+        std::string res = std::format("{0} = {3}({1}, {2});\n", Var, P1, P2, Func);
+
+        if (Var == P1 || Var == P2)
+        {
+          const std::string &par = Var == P1 ? P2 : P1;
+
+          return param::MtlOnly(std::format(
+            "if ({1} {2} {0})\n"
+            "  mtl_{0} = mtl_{1};\n", Var, par, Cmp)) + res;
+        }
+        return res + param::MtlOnly(std::format(
+          "if ({2} {3} {1})\n"
+          "  mtl_{0} = mtl_{2};\n"
+          "else\n"
+          "  mtl_{0} = mtl_{1};\n", Var, P1, P2, Cmp));
+      } /* End of 'Select' function */
+
       static std::string CheckParamsMtl(const std::string& Val, const std::string& P1, const std::string& P2)
       {
         if (Val == P1 || Val == P2)
-          return std::format(
+          return param::MtlOnly(std::format(
             "tmp = {0};\n"
-            "tmp_mtl = mtl_{0};\n", Val);
+            "tmp_mtl = mtl_{0};\n", Val));
         else
           return "";
 
@@ -71,21 +135,21 @@ namespace parser
           par = P1;
 
         if (par == "")
-          return std::format(
+          return param::MtlOnly(std::format(
             "if ({0} == {1})\n"
             "  mtl_{0} = mtl_{1};\n"
             "else if ({0} == {2})\n"
             "  mtl_{0} = mtl_{2};\n"
             "else\n"
-            "  mtl_{0} = SDFSurfaceSmoothUnion({1}, mtl_{1}, {2}, mtl_{2}, 0.5);\n", Val, P1, P2);
+            "  mtl_{0} = SDFSurfaceSmoothUnion({1}, mtl_{1}, {2}, mtl_{2}, 0.5);\n", Val, P1, P2));
         else
-          return std::format(
+          return param::MtlOnly(std::format(
             "if ({0} == {1})\n"
             "  mtl_{0} = {1}_mtl;\n"
             "else if ({0} == {2})\n"
             "  mtl_{0} = mtl_{2};\n"
             "else\n"
-            "  mtl_{0} = SDFSurfaceSmoothUnion({1}, {1}_mtl, {2}, mtl_{2}, 0.5);\n", Val, tmp, par);
+            "  mtl_{0} = SDFSurfaceSmoothUnion({1}, {1}_mtl, {2}, mtl_{2}, 0.5);\n", Val, tmp, par));
       }
     };
   }
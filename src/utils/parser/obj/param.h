@@ -34,6 +34,20 @@ namespace parser
       eTex,
       eShp
     };
+
+    /* Mark material only GLSL text function.
+     * Marked text is skipped in distance only scene function ('SceneDist' in shader).
+     * ARGUMENTS:
+     *   - GLSL text:
+     *       const std::string &Text;
+     * RETURNS: (std::string) marked text.
+     */
+    static std::string MtlOnly(const std::string &Text)
+    {
+      if (Text.empty())
+        return Text;
+      return "#ifndef SCENE_DIST\n" + Text + "#endif\n";
+    } /* End of 'MtlOnly' function */
   };
 }
 
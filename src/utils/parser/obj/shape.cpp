@@ -7,18 +7,21 @@
  * PURPOSE     : Ray marching project.
  *               Parser module.
  * PROGRAMMER  : Vladislav Biserov.
- * LAST UPDATE : 30.03.2023
+ * LAST UPDATE : 31.03.2023
  * NOTE        : None.
  *
  * No part of this file may be changed without agreement of
  * Computer Graphics Support Group of 30 Phys-Math Lyceum
  */
 
+#include <algorithm>
+
 #include "shape.h"
-#include "../../../animation/animation.h"
 
-std::map<std::string, trm::texture::tex_data>& parser::obj::shape::Textures = trm::animation::GetPtr()->Textures;
-int parser::obj::shape::CountOfTex = 1;
+thread_local std::map<std::string, trm::tex_data> parser::obj::shape::Textures;
+thread_local std::map<std::string, trm::tex_data> parser::obj::shape::Kept;
+thread_local int parser::obj::shape::CountOfTex = 1;
+thread_local bool parser::obj::shape::IsConvert = true;
 
 const std::map<std::string, parser::obj::shape::type> parser::obj::shape::Table =
 {
@@ -44,97 +47,131 @@ const std::map<parser::obj::shape::type, std::vector<parser::param::type>> parse
   {parser::obj::shape::type::eWater, {param::type::eNum, param::type::eNum, param::type::eNum, param::type::eMat}},
 };
 
-const std::map<parser::obj::shape::type, std::function<std::string(std::string, std::vector<std::string>, bool)>> parser::obj::shape::ToStr 
+const std::map<parser::obj::shape::type, std::function<std::string(std::string, std::vector<std::string>)>> parser::obj::shape::ToStr 
 {
   { // Plane
-    parser::obj::shape::type::ePlane, std::function([](std::string Var, std::vector<std::string> P, bool IsT) -> std::string
+    parser::obj::shape::type::ePlane, std::function([](std::string Var, std::vector<std::string> P) -> std::string
     {
-      std::string tex = "";
-      if (IsT)
-        tex = std::format("mtl_{0}.Albedo = texture(Tex{1}, tex_{0}).bgr;\n", Var, AddTex(P[3]));
-
-      return std::format("{0} = SDFPlane(mod_{0}, plane({1}, {2}), tex_{0});\nmtl_{0} = {3};\n", Var, P[0], P[1], P[2])+ tex;
+      return std::format("{0} = SDFPlane(mod_{0}, plane({1}, {2}), tex_{0});\n", Var, P[0], P[1]);
     })
   },
   { // Box
-    parser::obj::shape::type::eBox, std::function([](std::string Var, std::vector<std::string> P, bool IsT) -> std::string
+    parser::obj::shape::type::eBox, std::function([](std::string Var, std::vector<std::string> P) -> std::string
     {
-      std::string tex = "";
-      if (IsT)
-        tex = std::format("mtl_{0}.Albedo = texture(Tex{1}, tex_{0}).bgr;\n", Var, AddTex(P[3]));
-
-      return std::format("{0} = SDFBox(mod_{0}, box({1}, {2}), tex_{0});\nmtl_{0} = {3};\n", Var, P[0], P[1], P[2])+ tex;
+      return std::format("{0} = SDFBox(mod_{0}, box({1}, {2}), tex_{0});\n", Var, P[0], P[1]);
     })
   },
   { // Ellipsoid
-    parser::obj::shape::type::eEllipsoid, std::function([](std::string Var, std::vector<std::string> P, bool IsT) -> std::string
+    parser::obj::shape::type::eEllipsoid, std::function([](std::string Var, std::vector<std::string> P) -> std::string
     {
-      std::string tex = "";
-      if (IsT)
-        tex = std::format("mtl_{0}.Albedo = texture(Tex{1}, tex_{0}).bgr;\n", Var, AddTex(P[3]));
-
-      return std::format("{0} = SDFEllipsoid(mod_{0}, ellipsoid({1}, {2}), tex_{0});\nmtl_{0} = {3};\n", Var, P[0], P[1], P[2])+ tex;
+      return std::format("{0} = SDFEllipsoid(mod_{0}, ellipsoid({1}, {2}), tex_{0});\n", Var, P[0], P[1]);
     })
   },
   { // Sphere
-    parser::obj::shape::type::eSphere, std::function([](std::string Var, std::vector<std::string> P, bool IsT) -> std::string
+    parser::obj::shape::type::eSphere, std::function([](std::string Var, std::vector<std::string> P) -> std::string
     {
-      std::string tex = "";
-      if (IsT)
-        tex = std::format("mtl_{0}.Albedo = texture(Tex{1}, tex_{0}).bgr;\n", Var, AddTex(P[3]));
-
-      return std::format("{0} = SDFSphere(mod_{0}, sphere({1}, {2}), tex_{0});\nmtl_{0} = {3};\n", Var, P[0], P[1], P[2]) + tex;
+      return std::format("{0} = SDFSphere(mod_{0}, sphere({1}, {2}), tex_{0});\n", Var, P[0], P[1]);
     })
   },
   { // Torus
-    parser::obj::shape::type::eTorus, std::function([](std::string Var, std::vector<std::string> P, bool IsT) -> std::string
+    parser::obj::shape::type::eTorus, std::function([](std::string Var, std::vector<std::string> P) -> std::string
     {
-      std::string tex = "";
-      if (IsT)
-        tex = std::format("mtl_{0}.Albedo = texture(Tex{1}, tex_{0}).bgr;\n", Var, AddTex(P[5]));
-
-      return std::format("{0} = SDFTorus(mod_{0}, torus({1}, {2}, {3}, {4}), tex_{0});\nmtl_{0} = {5};\n", Var, P[0], P[1], P[2], P[3], P[4])+ tex;
+      return std::format("{0} = SDFTorus(mod_{0}, torus({1}, {2}, {3}, {4}), tex_{0});\n", Var, P[0], P[1], P[2], P[3]);
     })
   },
   { // Cylinder
-    parser::obj::shape::type::eCylinder, std::function([](std::string Var, std::vector<std::string> P, bool IsT) -> std::string
+    parser::obj::shape::type::eCylinder, std::function([](std::string Var, std::vector<std::string> P) -> std::string
     {
-      std::string tex = "";
-      if (IsT)
-        tex = std::format("mtl_{0}.Albedo = texture(Tex{1}, tex_{0}).bgr;\n", Var, AddTex(P[5]));
-
-      return std::format("{0} = SDFCylinder(mod_{0}, cylinder({1}, {2}, {3}, {4}), tex_{0});\nmtl_{0} = {5};\n", Var, P[0], P[1], P[2], P[3], P[4])+ tex;
+      return std::format("{0} = SDFCylinder(mod_{0}, cylinder({1}, {2}, {3}, {4}), tex_{0});\n", Var, P[0], P[1], P[2], P[3]);
     })
   },
   { // Capsule
-    parser::obj::shape::type::eCapsule, std::function([](std::string Var, std::vector<std::string> P, bool IsT) -> std::string
+    parser::obj::shape::type::eCapsule, std::function([](std::string Var, std::vector<std::string> P) -> std::string
     {
-      std::string tex = "";
-      if (IsT)
-        tex = std::format("mtl_{0}.Albedo = texture(Tex{1}, tex_{0}).bgr;\n", Var, AddTex(P[4]));
-
-      return std::format("{0} = SDFCapsule(mod_{0}, capsule({1}, {2}, {3}), tex_{0});\nmtl_{0} = {4};\n", Var, P[0], P[1], P[2], P[3]) + tex;
+      return std::format("{0} = SDFCapsule(mod_{0}, capsule({1}, {2}, {3}), tex_{0});\n", Var, P[0], P[1], P[2]);
     })
   },
   { // Water
-    parser::obj::shape::type::eWater, std::function([](std::string Var, std::vector<std::string> P, bool IsT) -> std::string
+    parser::obj::shape::type::eWater, std::function([](std::string Var, std::vector<std::string> P) -> std::string
     {
-      return std::format("{0} = SDFSea(mod_{0}, sea({1}, {2}, {3}));\nmtl_{0} = {4};\n", Var, P[0], P[1], P[2], P[3]);
+      return std::format("{0} = SDFSea(mod_{0}, sea({1}, {2}, {3}));\n", Var, P[0], P[1], P[2]);
     })
   },
 };
 
-std::string parser::obj::shape::GetTexStr(void)
+/* Get material text of shape function.
+ * Material is separate from distance, so it is computed only if it is read.
+ * ARGUMENTS:
+ *   - shape type:
+ *       type Type;
+ *   - arguments GLSL text:
+ *       const std::vector<std::string> &P;
+ *   - is texture set:
+ *       bool IsTex;
+ * RETURNS: (mtl) material argument text and texture sampler number.
+ */
+parser::obj::shape::mtl parser::obj::shape::GetMtl( type Type, const std::vector<std::string> &P, bool IsTex )
+{
+  const std::vector<param::type> &types = Types.at(Type);
+  mtl res;
+
+  for (size_t i = 0; i < types.size() && i < P.size(); i++)
+    if (types[i] == param::type::eMat)
+      res.Text = P[i];
+    else if (types[i] == param::type::eTex && IsTex)
+      res.Tex = AddTex(P[i]);
+  return res;
+} /* End of 'parser::obj::shape::GetMtl' function */
+
+/* Get material assignment text function.
+ * ARGUMENTS:
+ *   - destination material variable name:
+ *       const std::string &Dst;
+ *   - shape name, its texture coordinates are read:
+ *       const std::string &Var;
+ *   - shape material:
+ *       const mtl &M;
+ * RETURNS: (std::string) GLSL text.
+ */
+std::string parser::obj::shape::MtlStr( const std::string &Dst, const std::string &Var, const mtl &M )
+{
+  std::string res = std::format("{} = {};\n", Dst, M.Text);
+
+  if (M.Tex >= 0)
+    res += std::format("{0}.Albedo = texture(Tex{1}, tex_{2}).bgr;\n", Dst, M.Tex, Var);
+  return res;
+} /* End of 'parser::obj::shape::MtlStr' function */
+
+/* Get texture samplers declaration function.
+ * ARGUMENTS:
+ *   - minimal number of samplers:
+ *       int Count;
+ * RETURNS: (std::string) GLSL text.
+ */
+std::string parser::obj::shape::GetTexStr( int Count )
 {
   std::string res;
 
-  for (int i = 1; i < CountOfTex; i++)
+  for (int i = 1; i < std::max(CountOfTex, Count + 1); i++)
   {
     res += std::format("layout(binding = {0}) uniform sampler2D Tex{0};\n", i);
     res += std::format("uniform bool IsTexture{};\n", i);
   }
 
   return res;
-}
+} /* End of 'parser::obj::shape::GetTexStr' function */
+
+/* Get texture set key function.
+ * ARGUMENTS: None.
+ * RETURNS: (std::string) texture file names with their sampler numbers.
+ */
+std::string parser::obj::shape::GetTexKey(void)
+{
+  std::string res;
+
+  for (auto &tex : Textures)
+    res += std::format("{}:{};", tex.first, tex.second.n);
+  return res;
+} /* End of 'parser::obj::shape::GetTexKey' function */
 
 /* END OF 'shape.cpp' FILE */
\ No newline at end of file
@@ -22,10 +22,11 @@
 #include <vector>
 #include <functional>
 #include <format>
+#include <mutex>
 #include <optional>
 
 #include "param.h"
-#include "../../../animation/render/resource/texture.h"
+#include "../../../animation/render/resource/tex_data.h"
 
 namespace parser
 {
@@ -33,7 +34,7 @@ namespace parser
   {
     class shape
     {
-    private:
+    public:
       static int AddTex(const std::string& Name)
       {
         int s = (int)Name.size();
@@ -48,19 +49,33 @@ namespace parser
 		}
 		else
 		{
-          if (ext != "g32")
+          auto kept = Kept.find(res_name);
+
+          // Textures of previous parse are already converted and loaded
+          if (kept != Kept.end())
           {
+            Textures.emplace(res_name, trm::tex_data {CountOfTex, kept->second.Tex});
+            return CountOfTex++;
+          }
+          if (ext != "g32" && IsConvert)
+          {
+            // Scenes compiled at the same time may share images
+            static std::mutex Convert;
+            std::lock_guard<std::mutex> guard(Convert);
             std::string fmt = std::format("utils\\ANY2ANY.exe {} {}", "bin//images//" + tmp_name, "bin//images//" + res_name);
             system(fmt.c_str());
           }
 
-		  Textures.emplace(res_name, CountOfTex);
+		  Textures.emplace(res_name, trm::tex_data {CountOfTex, nullptr});
 		  return CountOfTex++;
 		}
       }
 
-      static std::map<std::string, trm::texture::tex_data>& Textures;
-      static int CountOfTex;
+    private:
+      static thread_local std::map<std::string, trm::tex_data> Textures; // Textures of scene
+      static thread_local std::map<std::string, trm::tex_data> Kept;     // Textures of previous parse
+      static thread_local int CountOfTex;
+      static thread_local bool IsConvert; // Are images converted to '.g32' by current compilation
 
     public:
       enum class type
@@ -79,15 +94,47 @@ namespace parser
 
       static const std::map<type, std::vector<param::type>> Types;
 
-      static const std::map<type, std::function<std::string(std::string, std::vector<std::string>, bool)>> ToStr;
+      static const std::map<type, std::function<std::string(std::string, std::vector<std::string>)>> ToStr;
 
-      static std::string GetTexStr(void);
+      /* Shape material structure */
+      struct mtl
+      {
+        std::string Text; // Material argument GLSL text
+        int Tex = -1;     // Texture sampler number, -1 if shape has no texture
+        int Write = 0;    // Assignment number of material chunk (see 'file::GetWrite')
+      }; /* End of 'mtl' structure */
+
+      static mtl GetMtl(type Type, const std::vector<std::string> &P, bool IsTex);
+      static std::string MtlStr(const std::string &Dst, const std::string &Var, const mtl &M);
+      static std::string GetTexStr(int Count = 0);
+      static std::string GetTexKey(void);
 
-      static void ClearTextures( void )
+      /* Start scene textures function.
+       * Offline compilation needs shader text only, it skips images conversion.
+       * ARGUMENTS:
+       *   - textures of previous parse, loaded ones are reused:
+       *       const std::map<std::string, trm::tex_data> &Old;
+       *   - images conversion flag (see 'compile_context'):
+       *       bool IsConvertImages;
+       * RETURNS: None.
+       */
+      static void ClearTextures(const std::map<std::string, trm::tex_data> &Old, bool IsConvertImages)
       {
+        IsConvert = IsConvertImages;
+        Kept = Old;
         Textures.clear();
         CountOfTex = 1;
-      }
+      } /* End of 'ClearTextures' function */
+
+      /* Take scene textures function.
+       * ARGUMENTS: None.
+       * RETURNS: (std::map<std::string, trm::tex_data>) textures of scene, ones to be loaded have no texture.
+       */
+      static std::map<std::string, trm::tex_data> TakeTextures(void)
+      {
+        Kept.clear();
+        return std::move(Textures);
+      } /* End of 'TakeTextures' function */
     };
   }
 }
@@ -0,0 +1,269 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : pack.cpp
+ * PURPOSE     : Ray marching project.
+ *               Parser module.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 01.04.2023
+ * NOTE        : None.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include <cstring>
+#include <filesystem>
+
+#include "pack.h"
+#include "table.h"
+
+/* Add data to hash function (64-bit FNV-1a, stable between runs and platforms).
+ * ARGUMENTS:
+ *   - hash to continue:
+ *       uint64_t Hash;
+ *   - data:
+ *       std::string_view Data;
+ * RETURNS: (uint64_t) new hash.
+ */
+uint64_t parser::pack::Hash( uint64_t Hash, std::string_view Data )
+{
+  for (unsigned char c : Data)
+    Hash = (Hash ^ c) * 0x100000001B3ull;
+  // Length separates concatenated parts
+  for (size_t n = Data.size(), i = 0; i < sizeof(n); i++)
+    Hash = (Hash ^ ((n >> (i * 8)) & 0xFF)) * 0x100000001B3ull;
+  return Hash;
+} /* End of 'parser::pack::Hash' function */
+
+/* Get hash of shader sources function.
+ * Every file pasted to shader text is hashed: template and scene table interpreter.
+ * ARGUMENTS:
+ *   - previous hash value:
+ *       uint64_t Hash;
+ *   - shader template file name:
+ *       const std::string &ShIn;
+ * RETURNS: (uint64_t) hash.
+ */
+uint64_t parser::pack::Template( uint64_t Hash, const std::string &ShIn )
+{
+  mapping tmpl(ShIn);
+
+  Hash = pack::Hash(Hash, tmpl.View());
+  return pack::Hash(Hash, file::ReadFile(table::GetCodeName(ShIn)));
+} /* End of 'parser::pack::Template' function */
+
+/* Get hash of scene sources function.
+ * Compiler executable is taken by its time and size, so any rebuild invalidates saved scenes.
+ * ARGUMENTS:
+ *   - scene and shader template file names:
+ *       const std::string &Scene, &ShIn;
+ *   - switches scene is compiled with:
+ *       const compile_context &Ctx;
+ * RETURNS: (uint64_t) hash.
+ */
+uint64_t parser::pack::Source( const std::string &Scene, const std::string &ShIn, const compile_context &Ctx )
+{
+  static const std::string stamp = []()
+  {
+    std::filesystem::path self;
+    std::error_code err;
+
+#ifdef _WIN32
+    char buf[MAX_PATH];
+
+    if (GetModuleFileNameA(nullptr, buf, MAX_PATH) != 0)
+      self = buf;
+#else
+    self = std::filesystem::read_symlink("/proc/self/exe", err);
+#endif
+    auto time = std::filesystem::last_write_time(self, err).time_since_epoch().count();
+    auto size = std::filesystem::file_size(self, err);
+
+    return std::format("{} {} {}", Version, (long long)time, (unsigned long long)size);
+  }();
+  uint64_t hash = Hash(Basis, stamp);
+  mapping scene(Scene);
+
+  hash = Hash(hash, std::string_view(reinterpret_cast<const char *>(&Format), sizeof(Format)));
+  hash = Hash(hash, scene.View());
+  hash = Template(hash, ShIn);
+  return Hash(hash, std::format("table {} params {}", Ctx.IsTable, Ctx.IsParams));
+} /* End of 'parser::pack::Source' function */
+
+/* Open precompiled scene function.
+ * ARGUMENTS:
+ *   - file name:
+ *       const std::string &Name;
+ *   - hash of scene sources (see 'Source'):
+ *       uint64_t Source;
+ * RETURNS: (std::shared_ptr<pack>) mapped scene, nullptr if there is no valid one.
+ */
+std::shared_ptr<parser::pack> parser::pack::Open( const std::string &Name, uint64_t Source )
+{
+  std::error_code err;
+
+  if (!std::filesystem::is_regular_file(Name, err))
+    return nullptr;
+
+  std::shared_ptr<pack> res(new pack(Name));
+  std::string_view all = res->File.View();
+
+  if (all.size() < sizeof(header))
+    return nullptr;
+  res->Head = reinterpret_cast<const header *>(all.data());
+
+  const header &h = *res->Head;
+
+  if (h.Magic != Magic || h.Format != Format || h.Source != Source || h.Size != all.size())
+    return nullptr;
+  for (auto &s : h.Sections)
+    if (s.Offset > all.size() || s.Size > all.size() - s.Offset)
+      return nullptr;
+  if (h.Sum != Hash(Basis, all.substr(sizeof(header))))
+    return nullptr;
+  return res;
+} /* End of 'parser::pack::Open' function */
+
+/* Save precompiled scene function.
+ * ARGUMENTS:
+ *   - file name:
+ *       const std::string &Name;
+ *   - hash of scene sources (see 'Source'):
+ *       uint64_t Source;
+ *   - compiled scene:
+ *       const data &Data;
+ * RETURNS: (bool) is file saved, it isn't for frame program referring to syntax tree or on write failure.
+ */
+bool parser::pack::Save( const std::string &Name, uint64_t Source, const data &Data )
+{
+  header h {};
+  std::string buf(sizeof(header), 0);
+  auto put = [&]( section S, const void *Ptr, size_t Size )
+  {
+    // Sections are aligned for 'double' registers
+    buf.resize((buf.size() + 7) & ~size_t(7));
+    h.Sections[S].Offset = (uint32_t)buf.size();
+    h.Sections[S].Size = (uint32_t)Size;
+    buf.append(static_cast<const char *>(Ptr), Size);
+  };
+  std::string tex;
+  std::vector<int> code;
+
+  if (Data.Textures != nullptr)
+    for (auto &t : *Data.Textures)
+    {
+      int rec[2] = {t.second.n, (int)t.first.size()};
+
+      tex.append(reinterpret_cast<const char *>(rec), sizeof(rec));
+      tex += t.first;
+      tex.resize((tex.size() + 3) & ~size_t(3));
+    }
+  put(eShader, Data.Shader.data(), Data.Shader.size());
+  put(eKey, Data.Key.data(), Data.Key.size());
+  put(eReport, Data.Report.data(), Data.Report.size());
+  put(eTextures, tex.data(), tex.size());
+  put(eHead, Data.Head.data(), Data.Head.size_bytes());
+  put(eVals, Data.Vals.data(), Data.Vals.size_bytes());
+  h.Flags = Data.IsTable ? 1 : 0;
+  if (Data.Frame != nullptr)
+  {
+    const program &p = *Data.Frame;
+
+    // Frame program can't refer to syntax tree, it is gone after compilation
+    if (!p.Exprs.empty() || !p.Statements.empty() || !p.Assigns.empty() || !p.Loops.empty())
+      return false;
+
+    int info[] = {p.Slots, p.Outs, p.Time};
+
+    for (auto &i : p.Code)
+      code.insert(code.end(), {(int)i.Op, i.A, i.B, i.C});
+    put(eFrame, info, sizeof(info));
+    put(eCode, code.data(), code.size() * sizeof(int));
+    put(eRegs, p.Regs.data(), p.Regs.size() * sizeof(double));
+    h.Flags |= 2;
+  }
+  h.Magic = Magic;
+  h.Format = Format;
+  h.Source = Source;
+  h.Size = (uint32_t)buf.size();
+  h.Sum = Hash(Basis, std::string_view(buf).substr(sizeof(header)));
+  std::memcpy(buf.data(), &h, sizeof(header));
+
+  // Other application instances may read the file, it is replaced at once
+  std::filesystem::path path(Name), tmp(Name + ".tmp");
+  std::error_code err;
+
+  std::filesystem::create_directories(path.parent_path(), err);
+  {
+    std::ofstream f(tmp, std::ios::binary);
+
+    if (!f.is_open())
+      return false;
+    f.write(buf.data(), buf.size());
+    if (!f)
+      return false;
+  }
+  std::filesystem::rename(tmp, path, err);
+  if (err)
+  {
+    std::filesystem::remove(tmp, err);
+    return false;
+  }
+  return true;
+} /* End of 'parser::pack::Save' function */
+
+/* Get scene textures function.
+ * ARGUMENTS:
+ *   - textures of previous scene, loaded ones are reused:
+ *       const std::map<std::string, trm::tex_data> &Old;
+ * RETURNS: (std::map<std::string, trm::tex_data>) textures, ones to be loaded have no texture.
+ */
+std::map<std::string, trm::tex_data> parser::pack::GetTextures( const std::map<std::string, trm::tex_data> &Old ) const
+{
+  std::map<std::string, trm::tex_data> res;
+  std::string_view v = Get(eTextures);
+
+  for (size_t pos = 0; pos + 2 * sizeof(int) <= v.size(); )
+  {
+    int rec[2];
+
+    std::memcpy(rec, v.data() + pos, sizeof(rec));
+    pos += sizeof(rec);
+
+    std::string name(v.substr(pos, rec[1]));
+    auto old = Old.find(name);
+
+    res.emplace(name, trm::tex_data {rec[0], old != Old.end() ? old->second.Tex : nullptr});
+    pos = (pos + rec[1] + 3) & ~size_t(3);
+  }
+  return res;
+} /* End of 'parser::pack::GetTextures' function */
+
+/* Get frame uniforms program function.
+ * ARGUMENTS: None.
+ * RETURNS: (std::optional<program>) program, empty if scene has none.
+ */
+std::optional<parser::program> parser::pack::GetFrame( void ) const
+{
+  if ((Head->Flags & 2) == 0)
+    return std::nullopt;
+
+  std::span<const int> info = Array<int>(eFrame), code = Array<int>(eCode);
+  std::span<const double> regs = Array<double>(eRegs);
+  program p;
+
+  if (info.size() != 3)
+    return std::nullopt;
+  p.Slots = info[0];
+  p.Outs = info[1];
+  p.Time = info[2];
+  for (size_t i = 0; i + 4 <= code.size(); i += 4)
+    p.Code.push_back({(opcode)code[i], code[i + 1], code[i + 2], code[i + 3]});
+  p.Regs.assign(regs.begin(), regs.end());
+  return p;
+} /* End of 'parser::pack::GetFrame' function */
+
+/* END OF 'pack.cpp' FILE */
@@ -0,0 +1,191 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+ /* FILE NAME   : pack.h
+  * PURPOSE     : Ray marching project.
+  *               Parser module.
+  * PROGRAMMER  : Vladislav Biserov.
+  * LAST UPDATE : 01.04.2023
+  * NOTE        : None.
+  *
+  * No part of this file may be changed without agreement of
+  * Computer Graphics Support Group of 30 Phys-Math Lyceum
+  */
+
+#ifndef __pack_h_
+#define __pack_h_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "file.h"
+#include "bytecode.h"
+#include "context.h"
+#include "../../animation/render/resource/tex_data.h"
+
+namespace parser
+{
+  /* Scene compiler version, precompiled scenes and offline compilation cache depend on it */
+  inline constexpr const char *Version = "2023.04.01";
+
+  /* Precompiled scene class.
+   * Compiled scene (shader text, scene table with lights and flags, textures,
+   * frame program and report) is saved to binary file. On next load the file
+   * is mapped and its data is used in place instead of parsing scene again.
+   * File is valid only for the same scene and template text, compiler and
+   * options, it has format version and checksum.
+   */
+  class pack
+  {
+  public:
+    static constexpr uint32_t Magic = 0x534D5254; // 'TRMS'
+    static constexpr uint32_t Format = 1;         // File layout version
+    static constexpr uint64_t Basis = 0xCBF29CE484222325ull; // Initial value of hash (see 'Hash')
+
+    /* Compiled scene to be saved structure */
+    struct data
+    {
+      std::string_view Shader;                          // Shader text
+      std::string_view Key;                             // State shader is used with (see 'file::Write')
+      std::string_view Report;                          // Compilation report
+      const std::map<std::string, trm::tex_data> *Textures = nullptr; // Scene textures
+      bool IsTable = false;                             // Is scene table used
+      std::span<const int> Head;                        // Scene table flags, lights and program
+      std::span<const float> Vals;                      // Scene table constants
+      const program *Frame = nullptr;                   // Frame uniforms program
+    }; /* End of 'data' structure */
+
+  private:
+    /* File sections */
+    enum section
+    {
+      eShader, eKey, eReport, eTextures, eHead, eVals, eFrame, eCode, eRegs, eCount
+    }; /* End of 'section' enum */
+
+    /* File header structure */
+    struct header
+    {
+      uint32_t Magic, Format;
+      uint64_t Source;  // Hash of scene, shader sources, options and compiler
+      uint64_t Sum;     // Hash of all data after header
+      uint32_t Size;    // File size
+      uint32_t Flags;   // Bit 0 - scene table is used, bit 1 - frame program is present
+      struct
+      {
+        uint32_t Offset, Size; // Section placement in bytes
+      } Sections[eCount];
+    }; /* End of 'header' structure */
+
+    mapping File;                // Mapped file
+    const header *Head = nullptr; // Header in mapped file
+
+    /* Get section data function.
+     * ARGUMENTS:
+     *   - section:
+     *       section S;
+     * RETURNS: (std::string_view) section bytes.
+     */
+    std::string_view Get(section S) const
+    {
+      return File.View().substr(Head->Sections[S].Offset, Head->Sections[S].Size);
+    } /* End of 'Get' function */
+
+    /* Get section array function.
+     * ARGUMENTS:
+     *   - section:
+     *       section S;
+     * RETURNS: (std::span<const type>) section items.
+     */
+    template<typename type>
+      std::span<const type> Array(section S) const
+      {
+        std::string_view v = Get(S);
+
+        return {reinterpret_cast<const type *>(v.data()), v.size() / sizeof(type)};
+      } /* End of 'Array' function */
+
+    /* Map file constructor.
+     * ARGUMENTS:
+     *   - file name:
+     *       const std::string &Name;
+     */
+    pack(const std::string &Name) : File(Name)
+    {
+    } /* End of 'pack' constructor */
+
+  public:
+    static uint64_t Hash(uint64_t Hash, std::string_view Data);
+    static uint64_t Template(uint64_t Hash, const std::string &ShIn);
+    static uint64_t Source(const std::string &Scene, const std::string &ShIn, const compile_context &Ctx);
+    static std::shared_ptr<pack> Open(const std::string &Name, uint64_t Source);
+    static bool Save(const std::string &Name, uint64_t Source, const data &Data);
+
+    /* Get shader text function.
+     * ARGUMENTS: None.
+     * RETURNS: (std::string_view) text.
+     */
+    std::string_view GetShader(void) const
+    {
+      return Get(eShader);
+    } /* End of 'GetShader' function */
+
+    /* Get shader key function.
+     * ARGUMENTS: None.
+     * RETURNS: (std::string_view) state shader is used with.
+     */
+    std::string_view GetKey(void) const
+    {
+      return Get(eKey);
+    } /* End of 'GetKey' function */
+
+    /* Get compilation report function.
+     * ARGUMENTS: None.
+     * RETURNS: (std::string_view) report text.
+     */
+    std::string_view GetReport(void) const
+    {
+      return Get(eReport);
+    } /* End of 'GetReport' function */
+
+    /* Check is scene table used function.
+     * ARGUMENTS: None.
+     * RETURNS: (bool) is table to be uploaded.
+     */
+    bool IsTable(void) const
+    {
+      return (Head->Flags & 1) != 0;
+    } /* End of 'IsTable' function */
+
+    /* Get scene table head function.
+     * ARGUMENTS: None.
+     * RETURNS: (std::span<const int>) flags, lights and program, they are uploaded from mapped file.
+     */
+    std::span<const int> GetHead(void) const
+    {
+      return Array<int>(eHead);
+    } /* End of 'GetHead' function */
+
+    /* Get scene table constants function.
+     * ARGUMENTS: None.
+     * RETURNS: (std::span<const float>) constants, they are uploaded from mapped file.
+     */
+    std::span<const float> GetVals(void) const
+    {
+      return Array<float>(eVals);
+    } /* End of 'GetVals' function */
+
+    std::map<std::string, trm::tex_data> GetTextures(const std::map<std::string, trm::tex_data> &Old) const;
+    std::optional<program> GetFrame(void) const;
+  }; /* End of 'pack' class */
+}
+
+#endif
+
+/* END OF 'pack.h' FILE */
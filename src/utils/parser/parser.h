@@ -7,7 +7,7 @@
   * PURPOSE     : Ray marching project.
   *               Parser module.
   * PROGRAMMER  : Vladislav Biserov.
-  * LAST UPDATE : 30.03.2023
+  * LAST UPDATE : 02.04.2023
   * NOTE        : None.
   *
   * No part of this file may be changed without agreement of
@@ -17,8 +17,15 @@
 #ifndef __parser_h_
 #define __parser_h_
 
+#include <charconv>
+
+#include "arena.h"
+#include "context.h"
 #include "lexer.h"
+#include "live.h"
+#include "pack.h"
 #include "statement.h"
+#include "vm.h"
 
 namespace parser
 {
@@ -26,22 +33,65 @@ namespace parser
   {
   private:
     token END = token("", token_type::eEOF);
-    std::vector<token> Tokens;
-    int CurPos, Size;
+    lexer &Lexer;               // Token source
+    arena &Arena;               // Syntax tree nodes memory
+    std::vector<token> Tokens;  // Pulled tokens window
+    int CurPos, Base;           // Current and window first token absolute positions
+    bool IsEnd;                 // Is source exhausted flag
 
-    token Get(int RelPos)
+    const token & Get(int RelPos)
     {
-      int pos = CurPos + RelPos;
+      int pos = CurPos + RelPos - Base;
+
+      while (pos >= (int)Tokens.size() && !IsEnd)
+      {
+        token t = Lexer.Scan();
+
+        if (t.Type == token_type::eEOF)
+          IsEnd = true;
+        else
+          Tokens.push_back(t);
+      }
 
-      if (pos >= Size)
+      if (pos < 0 || pos >= (int)Tokens.size())
         return END;
 
       return Tokens[pos];
     }
 
+    /* Drop already parsed tokens function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    void Trim(void)
+    {
+      // Keep previous token for 'Get(-1)' requests
+      int n = CurPos - 1 - Base;
+
+      if (n < 64)
+        return;
+      Tokens.erase(Tokens.begin(), Tokens.begin() + n);
+      Base += n;
+    }
+
+    /* Get source text of parsed tokens function.
+     * ARGUMENTS:
+     *   - first token absolute position:
+     *       int Start;
+     * RETURNS: (std::string) concatenated tokens text up to current position.
+     */
+    std::string GetText(int Start)
+    {
+      std::string res;
+
+      for (int i = Start; i < CurPos; i++)
+        res += Tokens[i - Base].Text;
+      return res;
+    }
+
     bool Match(token_type Type)
     {
-      token cur = Get(0);
+      const token &cur = Get(0);
 
       if (cur.Type != Type)
         return false;
@@ -53,7 +103,7 @@ namespace parser
     {
       token cur = Get(0);
       if (Type != cur.Type)
-        throw std::exception("token  doesn't match type!");
+        throw std::runtime_error("token  doesn't match type!");
       CurPos++;
       return cur;
     }
@@ -73,26 +123,87 @@ namespace parser
       Consume(token_type::eWord); // ext
       if (ext.Text != "png" && ext.Text != "jpg" && ext.Text != "tga" && ext.Text != "bmp" && 
           ext.Text != "g32" && ext.Text != "g24")
-        throw std::exception("incorrect texture extension!");
+        throw std::runtime_error("incorrect texture extension!");
       Consume(token_type::eCav);  // "
     }
 
-    void ShpExpr(void)
+    int ShpExpr(void)
     {
       token cur = Get(0);
+      int id = functions::Lookup(cur.Text);
+
+      var_type type;
 
-      if (!variables::IsExists(cur.Text) || variables::Get(cur.Text).Type != var_type::eShape)
-        throw std::exception("incorrect type of variable!");
+      if (!variables::GetType(id, &type) || type != var_type::eShape)
+        throw std::runtime_error("incorrect type of variable!");
+      if (!functions::IsLocal(id))
+        throw std::runtime_error(std::format("function can't read scene variable '{}', pass it as parameter!", cur.Text));
 
       Consume(token_type::eWord);
+      return id;
     }
 
-    expr* Func(std::string VarName)
+    /* Check is token shape variable name function.
+     * ARGUMENTS:
+     *   - token:
+     *       const token &Tok;
+     * RETURNS: (bool) is shape variable.
+     */
+    bool IsShape(const token &Tok)
+    {
+      var_type type;
+
+      return Tok.Type == token_type::eWord && variables::GetType(functions::Lookup(Tok.Text), &type) && type == var_type::eShape;
+    } /* End of 'IsShape' function */
+
+    /* Scene function call parse function.
+     * ARGUMENTS:
+     *   - result shape variable symbol id:
+     *       int VarId;
+     * RETURNS: (expr *) expression.
+     */
+    expr* CallExpr(int VarId)
+    {
+      token cur = Consume(token_type::eWord);
+      int func = functions::Find(symbols::Find(cur.Text));
+
+      if (func < 0)
+        throw std::runtime_error("no such function!");
+
+      auto &params = functions::GetParams(func);
+      std::vector<arg> par;
+
+      Consume(token_type::eLParen); // (
+      while (!Match(token_type::eRParen))
+      {
+        if (par.size() >= params.size())
+          throw std::runtime_error("incorrect count of parameters!");
+
+        switch (params[par.size()].second)
+        {
+        case var_type::eVec:
+          par.push_back({VecExpr(), ""});
+          break;
+        case var_type::eMtl:
+          par.push_back({MtlExpr(), ""});
+          break;
+        default:
+          par.push_back({Expr(), ""});
+          break;
+        }
+        Match(token_type::eSemicolon);
+      }
+      if (par.size() != params.size())
+        throw std::runtime_error("incorrect count of parameters!");
+
+      return Arena.New<call_expr>(VarId, func, par);
+    }
+
+    expr* Func(int VarId)
     {
       token cur = Get(0);
-      std::vector<std::string> par;
+      std::vector<arg> par;
       std::vector<param::type> types;
-      std::string name;
       bool isTex = true;
 
       enum f_type
@@ -103,30 +214,37 @@ namespace parser
         eLight,
       } ftype;
 
-      if (obj::shape::Table.find(cur.Text) != obj::shape::Table.end())
+      // Scene functions are plain words
+      if (cur.Type == token_type::eWord)
+        return CallExpr(VarId);
+
+      const keyword::entry *kw = keyword::Find(cur.Text);
+
+      if (kw == nullptr || kw->Type != token_type::eFunc)
+        throw std::runtime_error("no such function!");
+
+      switch (kw->Kind)
       {
+      case keyword::kind::eShape:
         ftype = f_type::eShape;
-        types = obj::shape::Types.at(obj::shape::Table.at(cur.Text));
-      }
-      else if (obj::mod::Table.find(cur.Text) != obj::mod::Table.end())
-      {
+        types = obj::shape::Types.at((obj::shape::type)kw->Id);
+        break;
+      case keyword::kind::eMod:
         ftype = f_type::eMod;
-        types = obj::mod::Types.at(obj::mod::Table.at(cur.Text));
-      }
-      else if (obj::oper::Table.find(cur.Text) != obj::oper::Table.end())
-      {
+        types = obj::mod::Types.at((obj::mod::type)kw->Id);
+        break;
+      case keyword::kind::eOper:
         ftype = f_type::eOper;
-        types = obj::oper::Types.at(obj::oper::Table.at(cur.Text));
-      }
-      else if (obj::light::Table.find(cur.Text) != obj::light::Table.end())
-      {
+        types = obj::oper::Types.at((obj::oper::type)kw->Id);
+        break;
+      case keyword::kind::eLight:
         ftype = f_type::eLight;
-        types = obj::light::Types.at(obj::light::Table.at(cur.Text));
+        types = obj::light::Types.at((obj::light::type)kw->Id);
+        break;
+      default:
+        throw std::runtime_error("no such function!");
       }
-      else
-        throw std::exception("no such function!");
 
-      name = cur.Text;
 
       Consume(token_type::eFunc);   // func
       Consume(token_type::eLParen); // (
@@ -134,64 +252,65 @@ namespace parser
       int
         ind = 0,
         size = (int)types.size(); // Current argument index
+      bool is_nary = ftype == f_type::eOper &&
+        ((obj::oper::type)kw->Id == obj::oper::type::eUnion || (obj::oper::type)kw->Id == obj::oper::type::eUnionSmth);
 
       while (!Match(token_type::eRParen))
       {
+        // Union takes any number of shapes before its coefficient
+        if (is_nary && ind >= 2 && IsShape(Get(0)))
+        {
+          types.insert(types.begin() + ind, param::type::eShp);
+          size++;
+        }
         if (ind >= size)
-          throw std::exception("incorrect count of parameters!");
+          throw std::runtime_error("incorrect count of parameters!");
 
         int p = CurPos;
-        std::string tmp = "";
-        expr *e = nullptr;
 
+        // Numeric parameters are kept as nodes to be folded, others as text
         switch (types[ind])
         {
         case param::type::eNum:
-          e = Expr();
-          delete e;
+          par.push_back({Expr(), ""});
           break;
         case param::type::eTex:
           TexExpr();
+          par.push_back({nullptr, GetText(p)});
           break;
         case param::type::eVec:
-          e = VecExpr();
-          delete e;
+          par.push_back({VecExpr(), ""});
           break;
         case param::type::eMat:
-          e = MtlExpr();
-          delete e;
+          par.push_back({MtlExpr(), ""});
           break;
         case param::type::eShp:
-          ShpExpr();
+          par.push_back({nullptr, symbols::GetName(ShpExpr())});
           break;
         default:
-          throw std::exception("incorrect parameter type!");
+          throw std::runtime_error("incorrect parameter type!");
         }
 
-        for (int i = p; i < CurPos; i++)
-          tmp += Tokens[i].Text;
-
-        par.emplace_back(tmp);
-
         Match(token_type::eSemicolon);
         ind++;
       }
 
       if (ftype == f_type::eShape && ind == size - 1)
         isTex = false;
-      else if (ind != size)
-        throw std::exception("incorrect count of parameters!");
+      // Repetition without count of cells is infinite
+      else if (ind != size && !(ftype == f_type::eMod && (obj::mod::type)kw->Id == obj::mod::type::eRepeat && ind == size - 1))
+        throw std::runtime_error("incorrect count of parameters!");
 
       if (ftype == f_type::eShape)
-        return new shape_expr(VarName, obj::shape::Table.find(name)->second, par, isTex);
+        return Arena.New<shape_expr>(VarId, (obj::shape::type)kw->Id, par, isTex);
       if (ftype == f_type::eMod)
-        return new mod_expr(VarName, obj::mod::Table.find(name)->second, par);
+        return Arena.New<mod_expr>(VarId, (obj::mod::type)kw->Id, par);
       if (ftype == f_type::eOper)
-        return new oper_expr(VarName, obj::oper::Table.find(name)->second, par);
+        return Arena.New<oper_expr>(VarId, (obj::oper::type)kw->Id, par);
       if (ftype == f_type::eLight)
-        return new light_expr(VarName, obj::light::Table.find(name)->second, par);
+        return Arena.New<light_expr>(VarId, (obj::light::type)kw->Id, par);
 
-      throw std::exception("incorrect function!");
+      throw std::runtime_error("incorrect function!");
     }
 
     expr* MtlExpr(void)
@@ -211,7 +330,7 @@ namespace parser
 
         Consume(token_type::eRParen); // )
 
-        return new mtl_expr(alb, rough, met);
+        return Arena.New<mtl_expr>(alb, rough, met);
       }
       else if (Match(token_type::eWord))
       {
@@ -221,24 +340,21 @@ namespace parser
           expr* e = Expr();                           // num
           Consume(token_type::eRBracket);   // ]
 
-          e->Eval();
-          std::string t = e->Text;
-          delete e;
-
-          return new mtl_expr(nullptr, nullptr, nullptr, true, std::format("MtlLib[int({0})]", t));
+          return Arena.New<mtl_expr>(e);
         }
         else
         {
-          auto a = variables::Get(cur.Text);
+          int id = functions::Lookup(cur.Text);
+          auto &a = variables::Get(id);
 
           if (a.Type == var_type::eMtl)
-            return new const_expr(cur.Text);
+            return Arena.New<const_expr>(id);
 
-          throw std::exception("it isn't material!");
+          throw std::runtime_error("it isn't material!");
         }
       }
       
-      throw std::exception("incorrect material parameters!");
+      throw std::runtime_error("incorrect material parameters!");
     }
 
     expr* VecExpr(void)
@@ -254,12 +370,12 @@ namespace parser
       {
         if (Match(token_type::ePlus))
         {
-          exp = new bin_expr('+', exp, VecMultiExpr());
+          exp = Arena.New<bin_expr>('+', exp, VecMultiExpr());
           continue;
         }
         if (Match(token_type::eMinus))
         {
-          exp = new bin_expr('-', exp, VecMultiExpr());
+          exp = Arena.New<bin_expr>('-', exp, VecMultiExpr());
           continue;
         }
         break;
@@ -275,12 +391,12 @@ namespace parser
       {
         if (Match(token_type::eStar))
         {
-          exp = new bin_expr('*', exp, Unary());
+          exp = Arena.New<bin_expr>('*', exp, Unary());
           continue;
         }
         if (Match(token_type::eSlash))
         {
-          exp = new bin_expr('/', exp, Unary());
+          exp = Arena.New<bin_expr>('/', exp, Unary());
           continue;
         }
         break;
@@ -302,16 +418,17 @@ namespace parser
           Ex.emplace_back(Expr());
           Match(token_type::eSemicolon);
         }
-        return new vec_expr(Ex);
+        return Arena.New<vec_expr>(Ex);
       }
       else if (Match(token_type::eWord))
       {
-        auto a = variables::Get(cur.Text);
+        int id = functions::Lookup(cur.Text);
+        auto &a = variables::Get(id);
 
         if (a.Type == var_type::eVec)
-          return new const_expr(cur.Text);
+          return Arena.New<const_expr>(id);
 
-        throw std::exception("it isn't vector!");
+        throw std::runtime_error("it isn't vector!");
       }
       else if (Match(token_type::eLParen))
       {
@@ -321,7 +438,7 @@ namespace parser
         return res;
       }
 
-      throw std::exception("incorrect vector input data!");
+      throw std::runtime_error("incorrect vector input data!");
     }
 
     expr* Expr(void)
@@ -337,7 +454,7 @@ namespace parser
       {
         if (Match(token_type::eBARBAR))
         {
-          res = new cond_expr(cond_expr::eOR, res, LogAnd());
+          res = Arena.New<cond_expr>(cond_expr::eOR, res, LogAnd());
           continue;
         }
         break;
@@ -354,7 +471,7 @@ namespace parser
       {
         if (Match(token_type::eAMPAMP))
         {
-          res = new cond_expr(cond_expr::eAND, res, LogEq());
+          res = Arena.New<cond_expr>(cond_expr::eAND, res, LogEq());
           continue;
         }
         break;
@@ -371,12 +488,12 @@ namespace parser
       {
         if (Match(token_type::eEQEQ))
         {
-          res = new cond_expr(cond_expr::eEQ, res, Conditional());
+          res = Arena.New<cond_expr>(cond_expr::eEQ, res, Conditional());
           continue;
         }
         else if (Match(token_type::eEXCLEQ))
         {
-          res = new cond_expr(cond_expr::eNOTEQ, res, Conditional());
+          res = Arena.New<cond_expr>(cond_expr::eNOTEQ, res, Conditional());
           continue;
         }
         break;
@@ -393,22 +510,22 @@ namespace parser
       {
         if (Match(token_type::eGT))
         {
-          exp = new cond_expr(cond_expr::oper_type::eGT, exp, Additive());
+          exp = Arena.New<cond_expr>(cond_expr::oper_type::eGT, exp, Additive());
           continue;
         }
         else if (Match(token_type::eLT))
         {
-          exp = new cond_expr(cond_expr::oper_type::eLT, exp, Additive());
+          exp = Arena.New<cond_expr>(cond_expr::oper_type::eLT, exp, Additive());
           continue;
         }
         else if (Match(token_type::eGTEQ))
         {
-          exp = new cond_expr(cond_expr::oper_type::eGTEQ, exp, Additive());
+          exp = Arena.New<cond_expr>(cond_expr::oper_type::eGTEQ, exp, Additive());
           continue;
         }
         else if (Match(token_type::eLTEQ))
         {
-          exp = new cond_expr(cond_expr::oper_type::eLTEQ, exp, Additive());
+          exp = Arena.New<cond_expr>(cond_expr::oper_type::eLTEQ, exp, Additive());
           continue;
         }
         break;
@@ -424,12 +541,12 @@ namespace parser
       {
         if (Match(token_type::ePlus))
         {
-          exp = new bin_expr('+', exp, Multi());
+          exp = Arena.New<bin_expr>('+', exp, Multi());
           continue;
         }
         if (Match(token_type::eMinus))
         {
-          exp = new bin_expr('-', exp, Multi());
+          exp = Arena.New<bin_expr>('-', exp, Multi());
           continue;
         }
         break;
@@ -445,12 +562,12 @@ namespace parser
       {
         if (Match(token_type::eStar))
         {
-          exp = new bin_expr('*', exp, Unary());
+          exp = Arena.New<bin_expr>('*', exp, Unary());
           continue;
         }
         if (Match(token_type::eSlash))
         {
-          exp = new bin_expr('/', exp, Unary());
+          exp = Arena.New<bin_expr>('/', exp, Unary());
           continue;
         }
         break;
@@ -461,7 +578,7 @@ namespace parser
     {
       if (Match(token_type::eMinus))
       {
-        return new un_expr('-', Primary());
+        return Arena.New<un_expr>('-', Primary());
       }
 
       return Primary();
@@ -472,8 +589,10 @@ namespace parser
 
       if (Match(token_type::eNumber))
       {
-        double num = std::stod(cur.Text);
-        return new num_expr(num);
+        double num = 0;
+
+        std::from_chars(cur.Text.data(), cur.Text.data() + cur.Text.size(), num);
+        return Arena.New<num_expr>(num);
       }
       if (Match(token_type::eWord))
       {
@@ -486,19 +605,19 @@ namespace parser
           {
             expr* res = Expr();
             Consume(token_type::eRParen);
-            return new sin_expr(res);
+            return Arena.New<sin_expr>(res);
           }
           if (cur.Text == "cos")
           {
             expr* res = Expr();
             Consume(token_type::eRParen);
-            return new cos_expr(res);
+            return Arena.New<cos_expr>(res);
           }
           if (cur.Text == "abs")
           {
             expr* res = Expr();
             Consume(token_type::eRParen);
-            return new abs_expr(res);
+            return Arena.New<abs_expr>(res);
           }
           if (cur.Text == "mod")
           {
@@ -506,18 +625,19 @@ namespace parser
             Consume(token_type::eSemicolon);
             expr* e2 = Expr();
             Consume(token_type::eRParen);
-            return new fmod_expr(e1, e2);
+            return Arena.New<fmod_expr>(e1, e2);
           }
         }
         /* Variable */
         else
         {
-          auto a = variables::Get(cur.Text);
+          int id = functions::Lookup(cur.Text);
+          auto &a = variables::Get(id);
 
           if (a.Type == var_type::eInt || a.Type == var_type::eFloat)
-            return new const_expr(cur.Text);
+            return Arena.New<const_expr>(id);
 
-          throw std::exception("it isn't number!");
+          throw std::runtime_error("it isn't number!");
         }
       }
       if (Match(token_type::eLParen))
@@ -527,7 +647,7 @@ namespace parser
         return res;
       }
 
-      throw std::exception("incorrect input data!");
+      throw std::runtime_error("incorrect input data!");
     }
 
     statement* BlockOrStatement(void)
@@ -539,7 +659,7 @@ namespace parser
 
     statement* Block(void)
     {
-      block_statement* block = new block_statement();
+      block_statement* block = Arena.New<block_statement>();
 
       Consume(token_type::eLBRACE);
       while (!Match(token_type::eRBRACE))
@@ -551,6 +671,9 @@ namespace parser
 
     statement* Statement(void)
     {
+      Trim();
+      if (Get(0).Type == token_type::eDef)
+        throw std::runtime_error("function can be defined at top level only!");
       if (Match(token_type::eIf))
         return IfStatement();
       if (Match(token_type::eWhile))
@@ -567,7 +690,7 @@ namespace parser
     statement* StateStatement(void)
     {
       token cur = Get(-1);
-      state_type type = STATES[cur.Text];
+      state_type type = (state_type)keyword::Find(cur.Text)->Id;
       bool val = false;
 
       Consume(token_type::eLParen);
@@ -578,17 +701,20 @@ namespace parser
       else if (cur.Type == token_type::eFalse)
         val = false;
       else
-        throw std::exception("invalid function parameter!");
+        throw std::runtime_error("invalid function parameter!");
 
       Consume(token_type::eRParen);
 
-      return new state_statement(type, val);
+      return Arena.New<state_statement>(type, val);
     }
 
     statement* AddStatement(void)
     {
+      if (functions::IsBody())
+        throw std::runtime_error("function can't add objects to scene!");
+
       token cur = Consume(token_type::eLParen);
-      add_statement* s = new add_statement();
+      add_statement* s = Arena.New<add_statement>();
 
       while (cur.Type != token_type::eRParen)
       {
@@ -596,15 +722,17 @@ namespace parser
 
         if (Get(0).Type == token_type::eSemicolon || Get(0).Type == token_type::eRParen)
         {
-          if (!variables::IsExists(cur.Text))
-            throw std::exception("no such variable exists!");
-          s->Add(cur.Text);
+          int id = symbols::Find(cur.Text);
+
+          if (!variables::IsExists(id))
+            throw std::runtime_error("no such variable exists!");
+          s->Add(id);
         }
       }
       return s;
     }
 
-    statement* AssignStatement(void)
+    assign_statement* AssignStatement(void)
     {
       token
         cur = Get(0),
@@ -616,83 +744,89 @@ namespace parser
         Match(token_type::eWord);
         Match(token_type::eEQ);
 
-        if (variables::IsExists(next.Text))
-          throw std::exception("such varibale is already exists!");
+        int id = functions::Intern(next.Text);
 
-        var_type type = TYPES[cur.Text];
-        if (type == var_type::eInt || type == var_type::eFloat)
-        {
-          int p1 = CurPos;
-          expr* e = Expr();
-          std::string tmp = "";
+        if (variables::IsExists(id) || functions::Find(id) >= 0)
+          throw std::runtime_error("such varibale is already exists!");
 
-          for (int i = p1; i < CurPos; i++)
-            tmp += Tokens[i].Text;
+        var_type type = (var_type)keyword::Find(cur.Text)->Id;
 
-          return new assign_statement(TYPES[cur.Text], next.Text, e, tmp);
-        }
+        if (type == var_type::eLight && functions::IsBody())
+          throw std::runtime_error("function can't build lights!");
+        if (type == var_type::eInt || type == var_type::eFloat)
+          return Arena.New<assign_statement>(type, id, Expr());
         else if (type == var_type::eVec)
-        {
-          int p1 = CurPos;
-          expr* e = VecExpr();
-          std::string tmp = "";
-
-          for (int i = p1; i < CurPos; i++)
-            tmp += Tokens[i].Text;
-
-          return new assign_statement(TYPES[cur.Text], next.Text, e, tmp);
-        }
+          return Arena.New<assign_statement>(type, id, VecExpr());
         else if (type == var_type::eMtl)
-        {
-          int p1 = CurPos;
-          expr* e = MtlExpr();
-          std::string tmp = "";
-
-          for (int i = p1; i < CurPos; i++)
-            tmp += Tokens[i].Text;
-
-          return new assign_statement(TYPES[cur.Text], next.Text, e, tmp);
-        }
+          return Arena.New<assign_statement>(type, id, MtlExpr());
         // NOT NUMBERS
-        return new assign_statement(TYPES[cur.Text], next.Text, Func(next.Text), "");
+        return Arena.New<assign_statement>(type, id, Func(id));
       }
       if (cur.Type == token_type::eWord && next.Type == token_type::eEQ)
       {
         Match(token_type::eWord);
         Match(token_type::eEQ);
 
+        int id = functions::Lookup(cur.Text);
         var_type type;
-        if (!variables::GetType(cur.Text, &type))
-          throw std::exception("no such varibale!");
+
+        if (!variables::GetType(id, &type))
+          throw std::runtime_error("no such varibale!");
+        if (!functions::IsLocal(id))
+          throw std::runtime_error(std::format("function can't change scene variable '{}'!", cur.Text));
 
         if (type == var_type::eInt || type == var_type::eFloat)
-        {
-          int p1 = CurPos;
-          expr* e = Expr();
-          std::string tmp = "";
+          return Arena.New<assign_statement>(type, id, Expr());
+        else if (type == var_type::eVec)
+          return Arena.New<assign_statement>(type, id, VecExpr());
 
-          for (int i = p1; i < CurPos; i++)
-            tmp += Tokens[i].Text;
+        // NOT NUMBERS
+        return Arena.New<assign_statement>(type, id, Func(id));
+      }
 
-          return new assign_statement(type, cur.Text, e, tmp);
-        }
-        else if (type == var_type::eVec)
-        {
-          int p1 = CurPos;
-          expr* e = VecExpr();
-          std::string tmp = "";
+      throw std::runtime_error("Unknown statement");
+    }
 
-          for (int i = p1; i < CurPos; i++)
-            tmp += Tokens[i].Text;
+    /* Function definition parse function.
+     * ARGUMENTS: None.
+     * RETURNS: (statement *) definition statement.
+     */
+    statement* FuncStatement(void)
+    {
+      token name = Consume(token_type::eWord);
+      int id = symbols::Intern(name.Text);
 
-          return new assign_statement(type, cur.Text, e, tmp);
-        }
+      if (variables::IsExists(id) || functions::Find(id) >= 0)
+        throw std::runtime_error("such function is already exists!");
 
-        // NOT NUMBERS
-        return new assign_statement(type, cur.Text, Func(cur.Text), "");
+      int func = functions::Declare(id);
+
+      Consume(token_type::eLParen); // (
+      while (!Match(token_type::eRParen))
+      {
+        token type = Consume(token_type::eType);
+        token par = Consume(token_type::eWord);
+
+        functions::Param(functions::Intern(par.Text), (var_type)keyword::Find(type.Text)->Id);
+        Match(token_type::eSemicolon);
       }
 
-      throw std::exception("Unknown statement");
+      block_statement* body = Arena.New<block_statement>();
+
+      Consume(token_type::eLBRACE);
+      while (!Match(token_type::eReturn))
+        body->Add(Statement());
+
+      token res = Consume(token_type::eWord);
+      int res_id = functions::Lookup(res.Text);
+      var_type res_type;
+
+      if (!functions::IsLocal(res_id) || !variables::GetType(res_id, &res_type) || res_type != var_type::eShape)
+        throw std::runtime_error("function must return its shape!");
+      Consume(token_type::eRBRACE);
+      functions::EndDecl();
+
+      return Arena.New<func_statement>(func, body, res_id);
     }
 
     statement* IfStatement(void)
@@ -705,7 +839,7 @@ namespace parser
       if (Match(token_type::eElse))
         elsest = BlockOrStatement();
 
-      return new if_statement(cond, ifst, elsest);
+      return Arena.New<if_statement>(cond, ifst, elsest);
     }
 
     statement* WhileStatement(void)
@@ -713,62 +847,165 @@ namespace parser
       expr* cond = Expr();
       statement* st = BlockOrStatement();
 
-      return new while_statement(cond, st);
+      return Arena.New<while_statement>(cond, st);
     }
 
     statement* ForStatement(void)
     {
       Consume(token_type::eLParen);
-      statement* init = AssignStatement();
+      assign_statement* init = AssignStatement();
       Consume(token_type::eSemicolon);
       expr* term = Expr();
       Consume(token_type::eSemicolon);
-      statement* incr = AssignStatement();
+      assign_statement* incr = AssignStatement();
       Consume(token_type::eRParen);
       statement* block = BlockOrStatement();
 
-      return new for_statement(init, term, incr, block);
+      return Arena.New<for_statement>(init, term, incr, block);
     }
 
   public:
-    parser(std::vector<token> NewTokens) : Tokens(NewTokens)
+    parser(lexer &Source, arena &Mem) : Lexer(Source), Arena(Mem)
     {
       CurPos = 0;
-      Size = (int)Tokens.size();
+      Base = 0;
+      IsEnd = false;
     }
 
     statement* Parse(void)
     {
-      block_statement* result = new block_statement();
+      block_statement* result = Arena.New<block_statement>();
 
       while (!Match(token_type::eEOF))
-        result->Add(Statement());
+        result->Add(Match(token_type::eDef) ? FuncStatement() : Statement());
 
       return result;
     }
   };
 
-  void Parse(const std::string &Scene, const std::string &ShIn, const std::string &ShOut )
+  /* Compile scene to shader function.
+   * Compilation state is kept per thread, so scenes may be compiled by several threads at once,
+   * each with its own context.
+   * ARGUMENTS:
+   *   - scene, shader template and output shader file names:
+   *       const std::string &Scene, &ShIn, &ShOut;
+   *   - textures of previous scene, replaced with textures of this one (ones to be loaded have no texture):
+   *       std::map<std::string, trm::tex_data> &Textures;
+   *   - compilation switches, gets shader, report, scene table, frame program and shader write counters:
+   *       compile_context &Ctx;
+   * RETURNS: (bool) is shader rebuild needed (false if shader and texture set are the same).
+   */
+  inline bool Parse(const std::string &Scene, const std::string &ShIn, const std::string &ShOut,
+    std::map<std::string, trm::tex_data> &Textures, compile_context &Ctx)
   {
-    obj::shape::ClearTextures();
+    // Results of previous scene aren't left if this one fails
+    Ctx.Frame.reset();
+    Ctx.Overflow = 0;
+    Ctx.Shader.clear();
+    Ctx.Key.clear();
+    Ctx.Report.clear();
+    Ctx.IsTableUsed = false;
+    Ctx.Head.clear();
+    Ctx.Vals.clear();
+    obj::shape::ClearTextures(Textures, Ctx.IsConvert);
+    variables::Clear();
+    functions::Clear();
+    file::Clear();
+    report::Clear();
+    loops::Clear();
+    scene::Clear();
+    table::Clear(Ctx.IsTable);
+    bounds::Clear();
+    obj::oper::Clear();
+    chains::Clear();
 
-    std::string F = file::ReadFile(Scene);
+    mapping F(Scene);
 
-    lexer L(F);
+    lexer L(F.View());
 
-    std::vector<token> lt = L.Tokenize();
+    arena A;
 
-    parser P(lt);
+    parser P(L, A);
 
     statement* state = P.Parse();
 
+    F.Close();
+
+    // Repeat until dynamic variables set stops growing
+    folder Fold;
+
+    do
+    {
+      Fold.Begin();
+      state->Fold(Fold);
+    } while (!Fold.IsStable());
+    report::Add(std::format("constant folding: {} expression nodes folded", Fold.Count));
+    bounds::Begin();
+
+    uniforms::Begin(symbols::Find("Time"), Ctx.IsParams);
+#ifdef TRM_PARSER_TREE_WALK
+    // Reference implementation
     state->Execute();
+#else
+    compiler C;
+
+    state->Compile(C);
+    vm(C.Link()).Run();
+#endif
+    bounds::End();
+
+    report::Add(std::format("frame uniforms: {} slots used, {} parameter slots used", uniforms::GetCount(), uniforms::GetParams()));
+    // Such values are literals, their edits rebuild shader even in parameters mode
+    if ((Ctx.Overflow = uniforms::GetMissed()) > 0)
+      report::Add(std::format("frame uniforms: {} values don't fit into {} frame or {} parameter slots, they are kept in shader text",
+        Ctx.Overflow, uniforms::MaxCount, uniforms::MaxParams));
+    Ctx.Frame = uniforms::End();
+
+    report::Add(std::format("syntax tree: {} arena allocations, {} KB", A.GetCount(), (A.GetSize() + 1023) / 1024));
+    A.Reset();
+
+    std::string lgt = obj::light::GetStr();
+    bool is_changed;
 
-    delete state;
+    if (table::End())
+    {
+      // Scene goes to storage buffers, shader is the same for all scenes
+      file::GetBuf() = table::GetSceneStr();
+      is_changed = file::PrintFile(ShIn, ShOut, table::GetCodeStr(ShIn), obj::shape::GetTexStr(table::MaxTex),
+        table::GetFlagStr(), "");
+    }
+    else
+    {
+      scene::End();
+      liveness::Sweep();
+      report::Add(loops::GetStat());
+      report::Add(functions::GetStat());
+      report::Add(obj::oper::GetStat());
+      report::Add(chains::GetStat());
+      file::GetBuf().insert(0, loops::GetStr(file::GetBuf()));
+      is_changed = file::PrintFile(ShIn, ShOut, lgt, obj::shape::GetTexStr(),
+        variables::GetFlagStr() + bounds::GetFlagStr(), functions::GetStr(), obj::shape::GetTexKey());
+    }
+    report::Add(std::format("shader text: {} bytes", file::GetLast().size()));
+    report::Add(bounds::GetStat());
+    if (table::IsEnabled())
+      report::Add(table::GetStat());
 
-    file::PrintFile(ShIn, ShOut, obj::light::GetStr(), obj::shape::GetTexStr(), variables::GetFlagStr());
+    (is_changed ? Ctx.WriteCnt : Ctx.SkipCnt)++;
+    report::Add(std::format("shader rebuilds: {} performed, {} skipped", Ctx.WriteCnt, Ctx.SkipCnt));
+
+    Ctx.Shader = file::GetLast();
+    Ctx.Key = file::GetLastKey();
+    Ctx.Report = report::Get();
+    if ((Ctx.IsTableUsed = table::IsUsed()))
+    {
+      Ctx.Head = table::GetHead();
+      Ctx.Vals = table::GetVals();
+    }
     variables::Clear();
-  }
+    Textures = obj::shape::TakeTextures();
+    return is_changed;
+  } /* End of 'Parse' function */
 }
 
 #endif
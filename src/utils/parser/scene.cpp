@@ -0,0 +1,206 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : scene.cpp
+ * PURPOSE     : Ray marching project.
+ *               Parser module.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 02.04.2023
+ * NOTE        : None.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include <format>
+
+#include "scene.h"
+#include "file.h"
+#include "loop.h"
+#include "variable.h"
+
+thread_local std::vector<parser::scene::shape> parser::scene::Shapes;
+thread_local int parser::scene::Count = 0;
+
+/* Indent text lines function.
+ * ARGUMENTS:
+ *   - GLSL text:
+ *       const std::string &Text;
+ * RETURNS: (std::string) text with lines indented by two spaces.
+ */
+static std::string Indent( const std::string &Text )
+{
+  std::string res;
+
+  for (size_t p = 0, end; p < Text.size(); p = end + 1)
+  {
+    end = Text.find('\n', p);
+    if (end == std::string::npos)
+      end = Text.size();
+    res += "  " + Text.substr(p, end - p) + "\n";
+  }
+  return res;
+} /* End of 'Indent' function */
+
+/* Reset scene shapes function.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+void parser::scene::Clear( void )
+{
+  Shapes.clear();
+  Count = 0;
+} /* End of 'parser::scene::Clear' function */
+
+/* Get text taking material of shape function.
+ * Primitive material is computed from its arguments if nothing assigned
+ * shape material after its own chunk, otherwise shape material is copied.
+ * ARGUMENTS:
+ *   - shape variable symbol id:
+ *       int Var;
+ *   - output names text reads (out):
+ *       std::vector<int> &Uses;
+ * RETURNS: (std::string) GLSL text assigning 'Mtl'.
+ */
+std::string parser::scene::Take( int Var, std::vector<int> &Uses )
+{
+  const std::string &name = symbols::GetName(Var);
+  int mtl = file::Name(Var, file::facet::eMtl);
+
+  if (variables::IsShapeExists(Var))
+  {
+    const obj::shape::mtl &m = variables::GetShapeMtl(Var);
+
+    if (!m.Text.empty() && m.Write == file::GetWrite(mtl))
+    {
+      Uses = variables::GetShapeUses(Var);
+      // Texture coordinates are written with distance
+      if (m.Tex >= 0)
+        Uses.push_back(file::Name(Var));
+      return obj::shape::MtlStr("Mtl", name, m);
+    }
+  }
+  Uses = {mtl};
+  return std::format("Mtl = mtl_{};\n", name);
+} /* End of 'parser::scene::Take' function */
+
+/* Add shape to scene function.
+ * ARGUMENTS:
+ *   - shape variable symbol id:
+ *       int Var;
+ * RETURNS: None.
+ */
+void parser::scene::Add( int Var )
+{
+  const std::string &name = symbols::GetName(Var);
+  std::string text = std::format("// add to scene '{}' var\n", name);
+  std::vector<int> uses;
+
+  Count++;
+  file::Mark(-1);
+  file::Use(file::Name(Var));
+  if (loops::IsRecording())
+  {
+    // Index would be the same for all iterations, material is taken by nearer shape at once
+    std::string mtl = Take(Var, uses);
+
+    if (variables::IsFirst)
+    {
+      file::Print(text + std::format("res = {};\n", name) + param::MtlOnly("res_id = -1;\n" + mtl));
+      file::Set(file::Res);
+      file::Set(file::ResId);
+      for (int u : uses)
+        file::Use(u);
+      file::Set(file::SceneMtl);
+    }
+    else
+    {
+      file::Print(text + param::MtlOnly(std::format("if ({} <= res)\n{{\n  res_id = -1;\n{}}}\n", name, Indent(mtl))) +
+        std::format("res = SDFUnion(res, {});\n", name));
+      file::Use(file::Res);
+      for (int u : uses)
+        file::Use(u);
+      file::Set(file::ResId, true);
+      file::Set(file::SceneMtl, true);
+      file::Set(file::Res);
+    }
+    variables::IsFirst = false;
+    return;
+  }
+
+  // Material text is taken now, shape may be assigned again later
+  std::string mtl = Take(Var, uses);
+
+  if (variables::IsFirst)
+  {
+    file::Print(text + std::format("res = {};\n", name) + param::MtlOnly(std::format("res_id = {};\n", Shapes.size())));
+    file::Set(file::Res);
+    file::Set(file::ResId);
+  }
+  else
+  {
+    // Equal distances take shape added last
+    file::Print(text + param::MtlOnly(std::format("res_id = {} <= res ? {} : res_id;\n", name, Shapes.size())) +
+      std::format("res = SDFUnion(res, {});\n", name));
+    file::Use(file::Res);
+    file::Use(file::ResId);
+    file::Set(file::ResId);
+    file::Set(file::Res);
+  }
+  variables::IsFirst = false;
+  Shapes.push_back({Var, file::GetChunks().size() - 1, file::GetWrite(), std::move(mtl), std::move(uses)});
+} /* End of 'parser::scene::Add' function */
+
+/* Finish scene function.
+ * Material of nearest shape is taken by its index.
+ * ARGUMENTS: None.
+ * RETURNS: None.
+ */
+void parser::scene::End( void )
+{
+  std::string cases;
+  std::vector<int> uses;
+  int kept = 0;
+
+  for (size_t i = 0; i < Shapes.size(); i++)
+  {
+    shape &s = Shapes[i];
+    bool is_kept = file::GetWrite(file::Name(s.Var)) <= s.Write;
+
+    for (int u : s.Uses)
+      is_kept = is_kept && file::GetWrite(u) <= s.Write;
+    if (is_kept)
+    {
+      cases += std::format("case {}:\n{}  break;\n", i, Indent(s.Mtl));
+      uses.insert(uses.end(), s.Uses.begin(), s.Uses.end());
+      kept++;
+      continue;
+    }
+
+    // Material of shape assigned again is taken by addition
+    std::vector<file::access> acc = {{file::access::eUse, file::ResId}};
+
+    for (int u : s.Uses)
+      acc.push_back({file::access::eUse, u});
+    acc.push_back({file::access::eDef, file::SceneMtl});
+    file::Append(s.Chunk, std::format("// keep material of '{}', it is assigned again\n", symbols::GetName(s.Var)) +
+      param::MtlOnly(std::format("if (res_id == {})\n{{\n{}}}\n", i, Indent(s.Mtl))) + "\n", acc);
+  }
+  if (kept == 0)
+    return;
+
+  file::Mark(-1);
+  // Single scene shape needs no index
+  if (Count == 1)
+    file::Print("// take material of scene shape\n" + param::MtlOnly(Shapes[0].Mtl));
+  else
+    file::Print("// take material of nearest scene shape\n" + param::MtlOnly("switch (res_id)\n{\n" + cases + "}\n"));
+  file::Use(file::ResId);
+  for (int u : uses)
+    file::Use(u);
+  file::Set(file::SceneMtl, true);
+} /* End of 'parser::scene::End' function */
+
+/* END OF 'scene.cpp' FILE */
@@ -0,0 +1,67 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+ /* FILE NAME   : scene.h
+  * PURPOSE     : Ray marching project.
+  *               Parser module.
+  * PROGRAMMER  : Vladislav Biserov.
+  * LAST UPDATE : 02.04.2023
+  * NOTE        : None.
+  *
+  * No part of this file may be changed without agreement of
+  * Computer Graphics Support Group of 30 Phys-Math Lyceum
+  */
+
+#ifndef __scene_h_
+#define __scene_h_
+
+#include <string>
+#include <vector>
+
+namespace parser
+{
+  /* Scene shapes union class.
+   * Scene distance is running minimum of added shapes, material variant
+   * keeps scene index of nearest shape in 'res_id':
+   *   res_id = b <= res ? 1 : res_id;
+   *   res = SDFUnion(res, b);
+   * Material is taken once at the end of 'SceneSDF' by switch over indices,
+   * primitive material is computed in its case only. Shape assigned again
+   * after it was added keeps material by index check appended to its
+   * addition, shape added in recorded loop takes material at once
+   * (loop text is the same for all iterations).
+   */
+  class scene
+  {
+  private:
+    /* Added shape structure */
+    struct shape
+    {
+      int Var;               // Shape variable symbol id
+      size_t Chunk;          // Output chunk adding shape
+      int Write;             // Number of last assignment before addition (see 'file::GetWrite')
+      std::string Mtl;       // Text taking material of shape to 'Mtl'
+      std::vector<int> Uses; // Output names material text reads
+    }; /* End of 'shape' structure */
+
+    static thread_local std::vector<shape> Shapes; // Added shapes by scene index
+    static thread_local int Count;                 // Additions, ones in recorded loops have no index
+
+    scene(void)
+    {
+    }
+
+    static std::string Take(int Var, std::vector<int> &Uses);
+
+  public:
+    static void Clear(void);
+    static void Add(int Var);
+    static void End(void);
+  }; /* End of 'scene' class */
+}
+
+#endif
+
+/* END OF 'scene.h' FILE */
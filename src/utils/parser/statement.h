@@ -7,7 +7,7 @@
   * PURPOSE     : Ray marching project.
   *               Parser module.
   * PROGRAMMER  : Vladislav Biserov.
-  * LAST UPDATE : 30.03.2023
+  * LAST UPDATE : 02.04.2023
   * NOTE        : None.
   *
   * No part of this file may be changed without agreement of
@@ -19,6 +19,8 @@
 
 #include <format>
 #include "expr.h"
+#include "loop.h"
+#include "scene.h"
 
 namespace parser
 {
@@ -27,74 +29,236 @@ namespace parser
   public:
     virtual void Execute(void) = 0;
 
+    /* Compile statement to bytecode function.
+     * ARGUMENTS:
+     *   - bytecode compiler:
+     *       compiler &C;
+     * RETURNS: None.
+     */
+    virtual void Compile(compiler &C)
+    {
+      C.Exec(this);
+    } /* End of 'Compile' function */
+
+    /* Fold constant expressions function.
+     * ARGUMENTS:
+     *   - folding pass state:
+     *       folder &F;
+     * RETURNS: None.
+     */
+    virtual void Fold(folder &/* F */)
+    {
+    } /* End of 'Fold' function */
+
+    /* Check does statement build objects function.
+     * ARGUMENTS: None.
+     * RETURNS: (bool) are shapes assigned.
+     */
+    virtual bool HasObjects(void)
+    {
+      return false;
+    } /* End of 'HasObjects' function */
+
+    /* Check can statement be emitted in GLSL loop body function.
+     * ARGUMENTS:
+     *   - shapes events of loop body by symbol id (see 'expr::IsLoopBody'):
+     *       std::map<int, int> &Shapes;
+     * RETURNS: (bool) can statement be emitted once for all iterations.
+     */
+    virtual bool IsLoopBody(std::map<int, int> &/* Shapes */)
+    {
+      return false;
+    } /* End of 'IsLoopBody' function */
+
+    /* Update compile time state without output function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    virtual void Track(void)
+    {
+    } /* End of 'Track' function */
+
     virtual ~statement() {}
   };
 
   class assign_statement : public statement
   {
   private:
-    std::string Var;
+    int Var; // Variable symbol
     var_type Type;
     expr* Expr;
 
   public:
-    assign_statement(var_type Type, std::string Var, expr* Expr, std::string Text) : Type(Type), Var(Var), Expr(Expr)
+    assign_statement(var_type Type, int VarId, expr* Expr) : Var(VarId), Type(Type), Expr(Expr)
     {
+      const std::string &name = symbols::GetName(Var);
+
       if (!variables::IsExists(Var))
+      {
+        file::Mark(Var, true);
         switch (Type)
         {
         case var_type::eInt:
           file::Print(std::format("// add int '{0}'\n"
-            "int {0};\n", Var));
+            "int {0};\n", name));
           break;
         case var_type::eFloat:
           file::Print(std::format("// add float '{0}'\n"
-            "float {0};\n", Var));
+            "float {0};\n", name));
           break;
         case var_type::eVec:
           file::Print(std::format("// add vec3 '{0}'\n"
-            "vec3 {0};\n", Var));
+            "vec3 {0};\n", name));
           break;
         case var_type::eMtl:
-          file::Print(std::format("// add mtl '{0}'\n"
-            "mtl {0};\n", Var));
+          file::Print(std::format("// add mtl '{0}'\n", name) + param::MtlOnly(std::format("mtl {0};\n", name)));
           break;
         case var_type::eShape:
           file::Print(std::format("// add shape '{0}'\n"
-            "float {0};\n"
-            "mtl mtl_{0};\n"
-            "vec3 mod_{0} = point;\n"
-            "vec2 tex_{0};\n", Var));
+            "float {0};\n", name) +
+            param::MtlOnly(std::format("mtl mtl_{0};\n", name)) +
+            std::format("vec3 mod_{0} = point;\n"
+            "vec2 tex_{0};\n", name));
           break;
         default:
           break;
         }
-      variables::Set(Var, { Type, 0, Text });
+      }
+      variables::Set(Var, Type, 0);
     }
 
-    ~assign_statement()
+    void Execute(void) override
     {
-      delete Expr;
+      // Values of GLSL loop body are tracked before it is emitted
+      if (loops::IsSymbolic() && Type != var_type::eShape)
+      {
+        Print();
+        return;
+      }
+
+      double val = Expr->Eval();
+
+      if (Type == var_type::eInt)
+        val = (int)val;
+
+      variables::Set(Var, Type, val);
+      Print();
     }
 
-    void Execute(void) override
+    void Track(void) override
     {
+      if (Type == var_type::eShape)
+      {
+        Expr->Track();
+        return;
+      }
+
       double val = Expr->Eval();
 
       if (Type == var_type::eInt)
         val = (int)val;
+      variables::Set(Var, Type, val);
+    }
+
+    bool IsLoopBody(std::map<int, int> &Shapes) override
+    {
+      if (Type == var_type::eShape)
+        return Expr->IsLoopBody(Shapes);
+      return Type == var_type::eInt || Type == var_type::eFloat;
+    }
+
+    /* Get loop counter function.
+     * ARGUMENTS: None.
+     * RETURNS: (int) number variable symbol id, -1 if other variable is assigned.
+     */
+    int GetCounter(void)
+    {
+      return Type == var_type::eInt || Type == var_type::eFloat ? Var : -1;
+    } /* End of 'GetCounter' function */
+
+    /* Write assignment to GLSL loop header function.
+     * ARGUMENTS:
+     *   - buffer to append text to:
+     *       std::string &Out;
+     * RETURNS: None.
+     */
+    void Write(std::string &Out)
+    {
+      Out += symbols::GetName(Var) + " = ";
+      if (Type == var_type::eInt)
+        Out += "int(";
+      Expr->Emit(Out);
+      if (Type == var_type::eInt)
+        Out += ')';
+      file::Set(file::Name(Var));
+    } /* End of 'Write' function */
+
+    void Compile(compiler &C) override
+    {
+      C.Store(C.Slot(Var), Expr->Compile(C), Type == var_type::eInt);
+      if (Type == var_type::eFloat || Type == var_type::eInt || Type == var_type::eVec || Type == var_type::eMtl)
+        C.Print(this);
+    }
 
-      variables::Set(Var, { Type, val, Expr->Text });
+    void Fold(folder &F) override
+    {
+      if (!Expr->Fold(F))
+        F.SetDynamic(Var);
+      F.SetAssigned(Var);
+    }
+
+    bool HasObjects(void) override
+    {
+      return Type == var_type::eShape;
+    }
+
+    /* Print assignment GLSL function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    void Print(void)
+    {
+      const char *type;
 
       if (Type == var_type::eFloat)
-        file::Print(std::format("// set float value to '{0}'\n{0} = {1};\n", Var, variables::Get(Var).Text));
+        type = "float";
       else if (Type == var_type::eInt)
-        file::Print(std::format("// set int value to '{0}'\n{0} = int({1});\n", Var, variables::Get(Var).Text));
+        type = "int";
       else if (Type == var_type::eVec)
-        file::Print(std::format("// set vec value to '{0}'\n{0} = {1};\n", Var, variables::Get(Var).Text));
+        type = "vec";
       else if (Type == var_type::eMtl)
-        file::Print(std::format("// set mtl value to '{0}'\n{0} = {1};\n", Var, variables::Get(Var).Text));
-    }
+        type = "mtl";
+      else
+        return;
+
+      // Expression text goes straight to output, no intermediate strings
+      std::string &out = file::GetBuf();
+
+      file::Mark(Var);
+
+      out += std::format("// set {1} value to '{0}'\n", symbols::GetName(Var), type);
+      if (Type == var_type::eMtl)
+        out += "#ifndef SCENE_DIST\n";
+      out += symbols::GetName(Var) + " = ";
+      if (Type == var_type::eInt)
+        out += "int(";
+      // Folded expression may read variable itself, print value it was given
+      if (Expr->IsConst && !Expr->IsVector && !loops::IsSymbolic())
+        expr::Literal(out, variables::Get(Var).Val);
+      else
+        Expr->Emit(out);
+      if (Type == var_type::eInt)
+        out += ')';
+      out += ";\n";
+      if (Type == var_type::eMtl)
+        out += "#endif\n";
+      out += '\n';
+      file::Set(file::Name(Var));
+      if (Type == var_type::eVec || Type == var_type::eMtl)
+        table::SetVar(Var, Expr);
+      if (Type == var_type::eVec)
+        bounds::SetVar(Var, Expr);
+    } /* End of 'Print' function */
   };
 
   class if_statement : public statement
@@ -108,13 +272,6 @@ namespace parser
     {
     }
 
-    ~if_statement()
-    {
-      delete Expr;
-      delete If;
-      delete Else;
-    }
-
     void Execute(void) override
     {
       double val = Expr->Eval();
@@ -124,6 +281,36 @@ namespace parser
       else if (Else != nullptr)
         Else->Execute();
     }
+
+    void Compile(compiler &C) override
+    {
+      int skip = C.Jump(opcode::eJumpIfZero, Expr->Compile(C));
+
+      If->Compile(C);
+      if (Else != nullptr)
+      {
+        int end = C.Jump(opcode::eJump);
+
+        C.Patch(skip, C.Here());
+        Else->Compile(C);
+        C.Patch(end, C.Here());
+      }
+      else
+        C.Patch(skip, C.Here());
+    }
+
+    void Fold(folder &F) override
+    {
+      // Condition is evaluated on compile time, it is never emitted
+      If->Fold(F);
+      if (Else != nullptr)
+        Else->Fold(F);
+    }
+
+    bool HasObjects(void) override
+    {
+      return If->HasObjects() || (Else != nullptr && Else->HasObjects());
+    }
   };
 
   class block_statement : public statement
@@ -136,12 +323,6 @@ namespace parser
     {
     }
 
-    ~block_statement()
-    {
-      for (auto &s : St)
-        delete s;
-    }
-
     void Add(statement* S)
     {
       St.emplace_back(S);
@@ -152,59 +333,97 @@ namespace parser
       for (auto& s : St)
         s->Execute();
     }
+
+    void Compile(compiler &C) override
+    {
+      for (auto& s : St)
+        s->Compile(C);
+    }
+
+    void Fold(folder &F) override
+    {
+      for (auto& s : St)
+        s->Fold(F);
+    }
+
+    bool HasObjects(void) override
+    {
+      for (auto& s : St)
+        if (s->HasObjects())
+          return true;
+      return false;
+    }
+
+    bool IsLoopBody(std::map<int, int> &Shapes) override
+    {
+      for (auto& s : St)
+        if (!s->IsLoopBody(Shapes))
+          return false;
+      return true;
+    }
+
+    void Track(void) override
+    {
+      for (auto& s : St)
+        s->Track();
+    }
   };
 
   class add_statement : public statement
   {
   private:
-    std::map<std::string, var_type> St;
+    std::map<std::string_view, std::pair<int, var_type>> St; // Ordered by name
 
   public:
     add_statement()
     {
     }
 
-    ~add_statement()
+    void Add(int Id)
     {
-    }
-
-    void Add(std::string S)
-    {
-      auto a = variables::Get(S);
+      auto &a = variables::Get(Id);
       if (a.Type != var_type::eLight && a.Type != var_type::eShape)
-        throw std::exception("can't add object this type to scene!");
-      St[S] = a.Type;
+        throw std::runtime_error("can't add object this type to scene!");
+      St[symbols::GetName(Id)] = {Id, a.Type};
     }
 
     void Execute(void) override
     {
       for (auto& s : St)
       {
-        if (s.second == var_type::eLight)
+        if (s.second.second == var_type::eLight)
         {
-          obj::light::Enable(s.first);
+          obj::light::Enable(s.second.first);
+          table::Add(s.second.first);
           continue;
         }
-        if (variables::IsFirst)
+        // Compile time state of GLSL loop body is updated by 'Track'
+        if (!loops::IsSymbolic())
         {
-          file::Print(std::format("// add to scene '{0}' var\n"
-            "res = {0};\n"
-            "Mtl = mtl_{0};\n", s.first));
-          variables::IsFirst = false;
+          table::Add(s.second.first);
+          bounds::Add(s.second.first);
         }
-        else
-          file::Print(std::format("// add to scene '{0}' var\n"
-            "tmp = res;\n"
-            "tmp_mtl = Mtl;\n"
-            "res = SDFUnion(tmp, {0});\n"
-            "if (res == {0})\n"
-            "  Mtl = mtl_{0};\n"
-            "else if (res == tmp)\n"
-            "  Mtl = tmp_mtl;\n"
-            "else\n"
-            "  Mtl = SDFSurfaceSmoothUnion(tmp, tmp_mtl, {0}, mtl_{0}, 0.5);\n", s.first));
+        scene::Add(s.second.first);
       }
     }
+
+    void Track(void) override
+    {
+      for (auto& s : St)
+      {
+        table::Add(s.second.first);
+        bounds::Add(s.second.first);
+      }
+    }
+
+    bool IsLoopBody(std::map<int, int> &/* Shapes */) override
+    {
+      // Lights are collected to arrays once
+      for (auto& s : St)
+        if (s.second.second != var_type::eShape)
+          return false;
+      return true;
+    }
   };
 
   class while_statement : public statement
@@ -218,44 +437,288 @@ namespace parser
     {
     }
 
-    ~while_statement()
-    {
-      delete Statement;
-      delete Condition;
-    }
-
     void Execute(void) override
     {
       while (Condition->Eval() != 0)
         Statement->Execute();
     }
+
+    void Compile(compiler &C) override
+    {
+      int
+        start = C.Here(),
+        end = C.Jump(opcode::eJumpIfZero, Condition->Compile(C));
+
+      Statement->Compile(C);
+      C.Patch(C.Jump(opcode::eJump), start);
+      C.Patch(end, C.Here());
+    }
+
+    void Fold(folder &F) override
+    {
+      Statement->Fold(F);
+    }
+
+    bool HasObjects(void) override
+    {
+      return Statement->HasObjects();
+    }
   };
 
   class for_statement : public statement
   {
   private:
-    statement* Init;
+    assign_statement* Init;
     expr* Term;
 
-    statement* Incr, * Block;
+    assign_statement* Incr;
+    statement* Block;
+    int Id = -1;              // GLSL loop id
+    int Glsl = -1;            // Can loop be emitted from syntax tree, -1 if not checked yet
+    int Runs = -1;            // Minimal number of iterations tracked, -1 if loop isn't tracked
+    size_t Start = 0;         // Recorded iterations text start offset
+    std::vector<size_t> Ends; // Recorded iterations text end offsets
+    bool IsUniform = false;   // Frame uniforms loop flag before recording
+
+    /* Check can loop be emitted from syntax tree function.
+     * Counter is kept in GLSL, body builds objects by fixed text.
+     * ARGUMENTS: None.
+     * RETURNS: (bool) is loop written as GLSL loop at once.
+     */
+    bool IsGlsl(void)
+    {
+      if (Glsl < 0)
+      {
+        std::map<int, int> shapes;
+        int var = Init->GetCounter();
+
+        Glsl = var >= 0 && Incr->GetCounter() == var && Term->IsConst && Term->IsBool() &&
+          Block->IsLoopBody(shapes) && std::none_of(shapes.begin(), shapes.end(), [](auto &S) { return S.second == 3; });
+      }
+      return Glsl > 0;
+    } /* End of 'IsGlsl' function */
+
+    /* Track loop iterations function.
+     * ARGUMENTS: None.
+     * RETURNS: (int) number of iterations.
+     */
+    int Run(void)
+    {
+      int n = 0;
+
+      for (; Term->Eval() != 0; n++)
+      {
+        Block->Track();
+        Incr->Track();
+      }
+      return n;
+    } /* End of 'Run' function */
+
+    /* Emit loop from syntax tree function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    void Emit(void)
+    {
+      std::string &buf = file::GetBuf();
+      auto &chunks = file::GetChunks();
+
+      // Header accesses are done before and after each iteration
+      file::Mark(-1);
+      chunks.back().Loop = Runs == 0 ? 2 : 1;
+      loops::Symbolic(true);
+      loops::Record(true);
+      buf += "// loop of objects\nfor (; ";
+      Term->Emit(buf);
+      buf += "; ";
+      Incr->Write(buf);
+      buf += ")\n{\n";
+
+      size_t body = buf.size();
+
+      Block->Execute();
+      loops::Record(false);
+      loops::Symbolic(false);
+      while (buf.ends_with("\n\n"))
+        buf.pop_back();
+      for (int i = (int)chunks.size() - 1; i >= 0 && chunks[i].Start > buf.size(); i--)
+        chunks[i].Start = buf.size();
+      loops::Indent(body);
+      file::Mark(-1);
+      chunks.back().Loop = -1;
+      buf += "}\n\n";
+      Runs = -1;
+    } /* End of 'Emit' function */
 
   public:
-    for_statement(statement* In, expr* Ter, statement* Incr, statement* B) : Init(In), Term(Ter), Incr(Incr), Block(B)
+    for_statement(assign_statement* In, expr* Ter, assign_statement* Incr, statement* B) : Init(In), Term(Ter), Incr(Incr), Block(B)
+    {
+    }
+
+    void Execute(void) override
+    {
+      if (!Block->HasObjects())
+      {
+        for (Init->Execute(); Term->Eval() != 0; Incr->Execute())
+          Block->Execute();
+        return;
+      }
+      Init->Execute();
+      // Loop nested in GLSL loop body is tracked with it
+      if (loops::IsSymbolic())
+      {
+        Emit();
+        return;
+      }
+      if (Begin())
+        return;
+      while (Term->Eval() != 0)
+      {
+        Block->Execute();
+        Incr->Execute();
+        Next();
+      }
+      End();
+    }
+
+    void Compile(compiler &C) override
+    {
+      Init->Compile(C);
+
+      // Loops building objects are emitted by syntax tree or recorded by tree walker iterations
+      int
+        at = Block->HasObjects() ? C.Loop(this) : -1,
+        start = C.Here(),
+        end = C.Jump(opcode::eJumpIfZero, Term->Compile(C));
+
+      Block->Compile(C);
+      Incr->Compile(C);
+      if (at >= 0)
+        C.Next(at, false);
+      C.Patch(C.Jump(opcode::eJump), start);
+      C.Patch(end, C.Here());
+      if (at >= 0)
+      {
+        C.Next(at, true);
+        C.Patch(at, C.Here());
+      }
+    }
+
+    /* Start loop building objects function.
+     * Loop which fits GLSL is tracked and emitted at once, other one is recorded.
+     * ARGUMENTS: None.
+     * RETURNS: (bool) is loop done.
+     */
+    bool Begin(void)
     {
+      // Scene distance must be set before loop, function bodies have no scene distance
+      if (IsGlsl() && !variables::IsFirst && !functions::IsBody())
+      {
+        bool old = uniforms::SetLoop(true);
+
+        bounds::Loop(true);
+        Runs = Run();
+        bounds::Loop(false);
+        if (Runs > 0)
+          Emit();
+        Runs = -1;
+        uniforms::SetLoop(old);
+        variables::Restore();
+        return true;
+      }
+
+      // Iterations text is recorded to be replaced with GLSL loop
+      Start = file::GetBuf().size();
+      Ends.clear();
+      IsUniform = uniforms::SetLoop(true);
+      loops::Record(true);
+      return false;
+    } /* End of 'Begin' function */
+
+    /* Finish recorded iteration function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    void Next(void)
+    {
+      Ends.push_back(file::GetBuf().size());
+    } /* End of 'Next' function */
+
+    /* Finish recorded loop function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    void End(void)
+    {
+      loops::Record(false);
+      uniforms::SetLoop(IsUniform);
+      loops::Emit(Id, Start, Ends);
+    } /* End of 'End' function */
+
+    void Fold(folder &F) override
+    {
+      bool is_rec = Block->HasObjects();
+
+      // Variables changed by recorded loop make iterations values differ
+      if (is_rec)
+        F.Loop(true);
+      Init->Fold(F);
+      Incr->Fold(F);
+      Block->Fold(F);
+      if (is_rec)
+      {
+        // Condition of loop emitted from syntax tree is written to GLSL
+        Term->Fold(F);
+        F.Loop(false);
+      }
     }
 
-    ~for_statement()
+    bool HasObjects(void) override
+    {
+      return Block->HasObjects();
+    }
+
+    bool IsLoopBody(std::map<int, int> &Shapes) override
+    {
+      return Block->HasObjects() && IsGlsl() && Block->IsLoopBody(Shapes);
+    }
+
+    void Track(void) override
+    {
+      Init->Track();
+
+      int n = Run();
+
+      Runs = Runs < 0 ? n : std::min(Runs, n);
+    }
+  };
+
+  class func_statement : public statement
+  {
+  private:
+    int Func;        // Scene function index
+    statement* Body;
+    int Res;         // Returned shape variable symbol
+
+  public:
+    func_statement(int Func, statement* Body, int Res) : Func(Func), Body(Body), Res(Res)
     {
-      delete Init;
-      delete Term;
-      delete Incr;
-      delete Block;
     }
 
     void Execute(void) override
     {
-      for (Init->Execute(); Term->Eval() != 0; Incr->Execute())
-        Block->Execute();
+      // Body text goes to function, not to scene
+      functions::Begin(Func);
+      Body->Execute();
+      functions::End(Func, Res);
+    }
+
+    void Fold(folder &F) override
+    {
+      // Parameters are known on call only
+      for (auto &p : functions::GetParams(Func))
+        F.SetDynamic(p.first);
+      Body->Fold(F);
     }
   };
 
@@ -270,10 +733,6 @@ namespace parser
     {
     }
 
-    ~state_statement()
-    {
-    }
-
     void Execute(void) override
     {
       variables::Flags[Type] = Val;
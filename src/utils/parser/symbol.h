@@ -0,0 +1,108 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+ /* FILE NAME   : symbol.h
+  * PURPOSE     : Ray marching project.
+  *               Parser module.
+  * PROGRAMMER  : Vladislav Biserov.
+  * LAST UPDATE : 30.03.2023
+  * NOTE        : None.
+  *
+  * No part of this file may be changed without agreement of
+  * Computer Graphics Support Group of 30 Phys-Math Lyceum
+  */
+
+#ifndef __symbol_h_
+#define __symbol_h_
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace parser
+{
+  /* Symbol interner class.
+   * Every identifier of the scene gets dense integer id on parse,
+   * all later accesses go through this id.
+   */
+  class symbols
+  {
+  private:
+    static thread_local std::deque<std::string> Names;                 // Names by id (stable storage)
+    static thread_local std::unordered_map<std::string_view, int> Ids; // Ids by name
+
+    symbols(void)
+    {
+    }
+  public:
+    /* Intern name function.
+     * ARGUMENTS:
+     *   - identifier:
+     *       std::string_view Name;
+     * RETURNS: (int) symbol id.
+     */
+    static int Intern(std::string_view Name)
+    {
+      auto it = Ids.find(Name);
+
+      if (it != Ids.end())
+        return it->second;
+
+      int id = (int)Names.size();
+
+      Names.emplace_back(Name);
+      Ids.emplace(Names.back(), id);
+      return id;
+    } /* End of 'Intern' function */
+
+    /* Find name function.
+     * ARGUMENTS:
+     *   - identifier:
+     *       std::string_view Name;
+     * RETURNS: (int) symbol id, -1 if name was never interned.
+     */
+    static int Find(std::string_view Name)
+    {
+      auto it = Ids.find(Name);
+
+      return it == Ids.end() ? -1 : it->second;
+    } /* End of 'Find' function */
+
+    /* Get symbol name function.
+     * ARGUMENTS:
+     *   - symbol id:
+     *       int Id;
+     * RETURNS: (const std::string &) name.
+     */
+    static const std::string & GetName(int Id)
+    {
+      return Names[Id];
+    } /* End of 'GetName' function */
+
+    /* Get number of symbols function.
+     * ARGUMENTS: None.
+     * RETURNS: (int) number of symbols.
+     */
+    static int GetCount(void)
+    {
+      return (int)Names.size();
+    } /* End of 'GetCount' function */
+
+    /* Remove all symbols function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    static void Clear(void)
+    {
+      Ids.clear();
+      Names.clear();
+    } /* End of 'Clear' function */
+  }; /* End of 'symbols' class */
+}
+
+#endif
+
+/* END OF 'symbol.h' FILE */
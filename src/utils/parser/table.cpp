@@ -0,0 +1,622 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : table.cpp
+ * PURPOSE     : Ray marching project.
+ *               Parser module.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 02.04.2023
+ * NOTE        : None.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include <algorithm>
+#include <bit>
+
+#include "table.h"
+#include "expr.h"
+#include "func.h"
+
+thread_local std::vector<parser::table::shape> parser::table::Shapes;
+thread_local std::vector<std::vector<int>> parser::table::Vars;
+thread_local std::vector<parser::table::light> parser::table::Lights;
+thread_local std::unordered_map<unsigned, int> parser::table::Pool;
+thread_local std::unordered_map<std::string, int> parser::table::Slots;
+thread_local std::vector<float> parser::table::Vals;
+thread_local std::vector<int> parser::table::Code;
+thread_local std::vector<int> parser::table::Head;
+thread_local std::string parser::table::Fail;
+thread_local int parser::table::Depth = 0;
+thread_local bool
+  parser::table::IsOn = false,
+  parser::table::IsBuilt = false;
+
+/* Reset table function.
+ * ARGUMENTS:
+ *   - is backend used by compilation flag (see 'compile_context'):
+ *       bool On;
+ * RETURNS: None.
+ */
+void parser::table::Clear( bool On )
+{
+  Shapes.clear();
+  Vars.clear();
+  Lights.clear();
+  Pool.clear();
+  Slots.clear();
+  Vals.clear();
+  Code.clear();
+  Fail.clear();
+  Depth = 0;
+  IsBuilt = false;
+  IsOn = On;
+} /* End of 'parser::table::Clear' function */
+
+/* Get shape variable by symbol id function.
+ * ARGUMENTS:
+ *   - symbol id:
+ *       int Id;
+ * RETURNS: (shape &) shape variable.
+ */
+parser::table::shape & parser::table::At( int Id )
+{
+  if (Id >= (int)Shapes.size())
+    Shapes.resize(Id + 1);
+  return Shapes[Id];
+} /* End of 'parser::table::At' function */
+
+/* Add constant to pool function.
+ * ARGUMENTS:
+ *   - value:
+ *       double Val;
+ * RETURNS: (int) operand.
+ */
+int parser::table::Const( double Val )
+{
+  float val = (float)Val;
+  auto res = Pool.emplace(std::bit_cast<unsigned>(val), (int)Vals.size());
+
+  if (res.second)
+    Vals.push_back(val);
+  return res.first->second;
+} /* End of 'parser::table::Const' function */
+
+/* Get constant operand value function.
+ * ARGUMENTS:
+ *   - operand (not negative):
+ *       int Op;
+ * RETURNS: (float) value.
+ */
+float parser::table::Value( int Op )
+{
+  return Vals[Op];
+} /* End of 'parser::table::Value' function */
+
+/* Put expression to frame slot function.
+ * ARGUMENTS:
+ *   - expression depending on 'Time' only:
+ *       expr *E;
+ *   - operand (out):
+ *       int *Op;
+ * RETURNS: (bool) is slot found.
+ */
+bool parser::table::Slot( expr *E, int *Op )
+{
+  std::string text;
+  bool old = uniforms::IsEnabled();
+
+  uniforms::Enable(false);
+  E->Emit(text);
+  uniforms::Enable(old);
+
+  // Parameters mode doesn't share slots, table does
+  auto it = Slots.find(text);
+  int slot = it != Slots.end() ? it->second : uniforms::Add(E, text);
+
+  if (slot < 0)
+    return false;
+  Slots.emplace(text, slot);
+  *Op = -1 - slot;
+  return true;
+} /* End of 'parser::table::Slot' function */
+
+/* Get vector or material variable operands function.
+ * ARGUMENTS:
+ *   - symbol id:
+ *       int Id;
+ *   - operands (out):
+ *       int *Ops;
+ * RETURNS: (int) number of operands, 0 if variable value isn't known.
+ */
+int parser::table::GetVar( int Id, int *Ops )
+{
+  if (Id >= (int)Vars.size())
+    return 0;
+  std::copy(Vars[Id].begin(), Vars[Id].end(), Ops);
+  return (int)Vars[Id].size();
+} /* End of 'parser::table::GetVar' function */
+
+/* Set vector or material variable function.
+ * ARGUMENTS:
+ *   - symbol id:
+ *       int Id;
+ *   - assigned expression:
+ *       expr *E;
+ * RETURNS: None.
+ */
+void parser::table::SetVar( int Id, expr *E )
+{
+  if (!IsOn)
+    return;
+
+  int ops[6], n = E->Operands(ops);
+
+  if (Id >= (int)Vars.size())
+    Vars.resize(Id + 1);
+  Vars[Id].assign(ops, ops + n);
+} /* End of 'parser::table::SetVar' function */
+
+/* Read function arguments operands function.
+ * ARGUMENTS:
+ *   - arguments:
+ *       std::vector<arg> &Args;
+ *   - arguments types:
+ *       const std::vector<param::type> &Types;
+ *   - operands to append to (out):
+ *       std::vector<int> &Ops;
+ *   - texture number, 0 if there is no texture (out):
+ *       int *Tex;
+ * RETURNS: (bool) are all arguments known per frame.
+ */
+bool parser::table::Read( std::vector<arg> &Args, const std::vector<param::type> &Types, std::vector<int> &Ops, int *Tex )
+{
+  for (size_t i = 0; i < Args.size(); i++)
+  {
+    if (Types[i] == param::type::eTex)
+    {
+      *Tex = obj::shape::AddTex(Args[i].Text);
+      continue;
+    }
+
+    int ops[6], n = Args[i].Value->Operands(ops);
+
+    if (n == 0)
+      return false;
+    Ops.insert(Ops.end(), ops, ops + n);
+  }
+  return true;
+} /* End of 'parser::table::Read' function */
+
+/* Make shape value code from its primitive and modifications function.
+ * ARGUMENTS:
+ *   - shape variable:
+ *       shape &S;
+ * RETURNS: None.
+ */
+void parser::table::Leaf( shape &S )
+{
+  S.Error = !S.ModError.empty() ? S.ModError : S.PrimError;
+  S.Code.clear();
+  S.Depth = 1;
+  if (!S.Error.empty())
+    return;
+
+  // Modifications with constant arguments are baked to one affine transform
+  double m[3][3] {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}, t[3] {};
+  bool is_affine = false;
+  auto flush = [&]()
+  {
+    if (!is_affine)
+      return;
+    S.Code.push_back((int)op::eAffine);
+    for (int c = 0; c < 3; c++)
+      for (int r = 0; r < 3; r++)
+        S.Code.push_back(Const(m[r][c]));
+    for (int r = 0; r < 3; r++)
+      S.Code.push_back(Const(t[r]));
+    for (int r = 0; r < 3; r++)
+      for (int c = 0; c < 3; c++)
+        m[r][c] = r == c;
+    t[0] = t[1] = t[2] = 0;
+    is_affine = false;
+  };
+
+  S.Code.push_back((int)op::ePoint);
+  for (auto &md : S.Mods)
+  {
+    int n = md.Type == op::eRotate ? 4 : md.Type == op::eRepeatN ? 6 : 3;
+    // Space folding modifications are never baked
+    bool is_const = md.Type != op::eRepeat && md.Type != op::eRepeatN && md.Type != op::eMirror &&
+      std::all_of(md.Ops, md.Ops + n, [](int Op) { return Op >= 0; });
+    double f[3][3] {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}, g[3] {};
+
+    if (is_const && md.Type == op::eTranslate)
+      for (int r = 0; r < 3; r++)
+        g[r] = Value(md.Ops[r]);
+    else if (is_const && md.Type == op::eScale)
+      for (int r = 0; r < 3; r++)
+      {
+        f[r][r] = 1.0 / Value(md.Ops[r]);
+        is_const = is_const && isfinite(f[r][r]);
+      }
+    else if (is_const)
+    {
+      // Inverse of 'MatrRotate' matrix as 'Rotate' computes it
+      double
+        a = Value(md.Ops[0]) * 3.14159 / 180, sn = sin(a), cs = cos(a),
+        x = Value(md.Ops[1]), y = Value(md.Ops[2]), z = Value(md.Ops[3]),
+        q[3][3]
+        {
+          {cs + x * x * (1 - cs), y * x * (1 - cs) - z * sn, z * x * (1 - cs) + y * sn},
+          {x * y * (1 - cs) + z * sn, cs + y * y * (1 - cs), z * y * (1 - cs) - x * sn},
+          {x * z * (1 - cs) - y * sn, y * z * (1 - cs) + x * sn, cs + z * z * (1 - cs)},
+        },
+        det =
+          q[0][0] * (q[1][1] * q[2][2] - q[1][2] * q[2][1]) -
+          q[0][1] * (q[1][0] * q[2][2] - q[1][2] * q[2][0]) +
+          q[0][2] * (q[1][0] * q[2][1] - q[1][1] * q[2][0]);
+
+      is_const = det != 0;
+      for (int r = 0; r < 3 && is_const; r++)
+        for (int c = 0; c < 3; c++)
+        {
+          int
+            r1 = (c + 1) % 3, r2 = (c + 2) % 3,
+            c1 = (r + 1) % 3, c2 = (r + 2) % 3;
+
+          f[r][c] = (q[r1][c1] * q[r2][c2] - q[r1][c2] * q[r2][c1]) / det;
+        }
+    }
+
+    if (!is_const)
+    {
+      flush();
+      S.Code.push_back((int)md.Type);
+      S.Code.insert(S.Code.end(), md.Ops, md.Ops + n);
+      continue;
+    }
+
+    // Next modification is applied to result of previous ones
+    double m1[3][3], t1[3];
+
+    for (int r = 0; r < 3; r++)
+    {
+      t1[r] = g[r];
+      for (int c = 0; c < 3; c++)
+      {
+        m1[r][c] = 0;
+        for (int k = 0; k < 3; k++)
+          m1[r][c] += f[r][k] * m[k][c];
+        t1[r] += f[r][c] * t[c];
+      }
+    }
+    std::copy(&m1[0][0], &m1[0][0] + 9, &m[0][0]);
+    std::copy(t1, t1 + 3, t);
+    is_affine = true;
+  }
+  flush();
+  S.Code.insert(S.Code.end(), S.Prim.begin(), S.Prim.end());
+} /* End of 'parser::table::Leaf' function */
+
+/* Record shape function.
+ * ARGUMENTS:
+ *   - shape variable symbol id:
+ *       int Var;
+ *   - shape type:
+ *       obj::shape::type Type;
+ *   - arguments:
+ *       std::vector<arg> &Args;
+ *   - is texture argument given:
+ *       bool IsTex;
+ * RETURNS: None.
+ */
+void parser::table::Shape( int Var, obj::shape::type Type, std::vector<arg> &Args, bool IsTex )
+{
+  if (!IsOn)
+    return;
+
+  shape &s = At(Var);
+  int tex = 0;
+
+  s.Prim = {(int)op::eShape, (int)Type, 0};
+  s.PrimError.clear();
+  if (!Read(Args, obj::shape::Types.at(Type), s.Prim, &tex))
+    s.PrimError = std::format("arguments of '{}' depend on scene variables changed by 'Time'", symbols::GetName(Var));
+  else if (tex > MaxTex)
+    s.PrimError = std::format("'{}' uses more than {} textures", symbols::GetName(Var), MaxTex);
+  s.Prim[2] = IsTex ? tex : 0;
+  Leaf(s);
+} /* End of 'parser::table::Shape' function */
+
+/* Record scene function call function.
+ * ARGUMENTS:
+ *   - result shape variable symbol id:
+ *       int Var;
+ *   - function index:
+ *       int Func;
+ * RETURNS: None.
+ */
+void parser::table::Call( int Var, int Func )
+{
+  if (!IsOn)
+    return;
+
+  shape &s = At(Var);
+
+  // Interpreter has no calls, function body would be inlined to every instance
+  s.Prim.clear();
+  s.PrimError = std::format("'{}' is built by function '{}'", symbols::GetName(Var),
+    symbols::GetName(functions::GetName(Func)));
+  Leaf(s);
+} /* End of 'parser::table::Call' function */
+
+/* Record shape modification function.
+ * ARGUMENTS:
+ *   - shape variable symbol id:
+ *       int Var;
+ *   - modification type:
+ *       obj::mod::type Type;
+ *   - arguments:
+ *       std::vector<arg> &Args;
+ * RETURNS: None.
+ */
+void parser::table::Mod( int Var, obj::mod::type Type, std::vector<arg> &Args )
+{
+  if (!IsOn)
+    return;
+
+  shape &s = At(Var);
+  std::vector<int> ops;
+  int tex = 0;
+  mod md {
+    Type == obj::mod::type::eRotate ? op::eRotate :
+    Type == obj::mod::type::eScale ? op::eScale :
+    Type == obj::mod::type::eRepeat ? (Args.size() > 1 ? op::eRepeatN : op::eRepeat) :
+    Type == obj::mod::type::eMirror ? op::eMirror : op::eTranslate, {}};
+
+  if (!Read(Args, obj::mod::Types.at(Type), ops, &tex))
+    s.ModError = std::format("modification of '{}' depends on scene variables changed by 'Time'", symbols::GetName(Var));
+  else
+    std::copy(ops.begin(), ops.end(), md.Ops);
+  s.Mods.push_back(md);
+  Leaf(s);
+} /* End of 'parser::table::Mod' function */
+
+/* Record operation function.
+ * ARGUMENTS:
+ *   - result shape variable symbol id:
+ *       int Var;
+ *   - operation type:
+ *       obj::oper::type Type;
+ *   - operands shape names:
+ *       const std::string &P1, &P2;
+ *   - smoothness coefficient, nullptr if there isn't one:
+ *       expr *K;
+ * RETURNS: None.
+ */
+void parser::table::Oper( int Var, obj::oper::type Type, const std::string &P1, const std::string &P2, expr *K )
+{
+  if (!IsOn)
+    return;
+
+  shape &a = At(symbols::Find(P1)), &b = At(symbols::Find(P2));
+  std::vector<int> code;
+  std::string error = !a.Error.empty() ? a.Error : b.Error;
+  int k = 0;
+
+  if (error.empty() && (a.Code.empty() || b.Code.empty()))
+    error = std::format("'{}' is combined with shape without value", symbols::GetName(Var));
+  if (error.empty() && a.Code.size() + b.Code.size() + 3 > MaxCode)
+    error = std::format("code of '{}' is too long", symbols::GetName(Var));
+  if (K == nullptr)
+    k = Const(0);
+  else if (error.empty() && K->Operands(&k) != 1)
+    error = std::format("coefficient of '{}' depends on scene variables changed by 'Time'", symbols::GetName(Var));
+  if (error.empty())
+  {
+    code.reserve(a.Code.size() + b.Code.size() + 3);
+    code = a.Code;
+    code.insert(code.end(), b.Code.begin(), b.Code.end());
+    code.insert(code.end(), {(int)op::eOper, (int)Type, k});
+  }
+
+  // Result may be one of operands
+  shape &s = At(Var);
+
+  s.Depth = std::max(a.Depth, b.Depth + 1);
+  s.Code = std::move(code);
+  s.Error = std::move(error);
+} /* End of 'parser::table::Oper' function */
+
+/* Record light function.
+ * ARGUMENTS:
+ *   - light variable symbol id:
+ *       int Var;
+ *   - light type:
+ *       obj::light::type Type;
+ *   - arguments:
+ *       std::vector<arg> &Args;
+ * RETURNS: None.
+ */
+void parser::table::Light( int Var, obj::light::type Type, std::vector<arg> &Args )
+{
+  if (!IsOn)
+    return;
+  if (Var >= (int)Lights.size())
+    Lights.resize(Var + 1);
+
+  // Light keeps its first definition as in generated code
+  light &l = Lights[Var];
+  std::vector<int> ops;
+  int tex = 0;
+
+  if (l.IsAdded)
+    return;
+  l = {Type, {}, "", true, false};
+  if (!Read(Args, obj::light::Types.at(Type), ops, &tex) ||
+      std::any_of(ops.begin(), ops.end(), [](int Op) { return Op < 0; }))
+  {
+    l.Error = std::format("light '{}' isn't constant", symbols::GetName(Var));
+    return;
+  }
+
+  // Vectors are aligned to 4 floats
+  for (int i = 0; i < (int)ops.size(); i++)
+    l.Val[i / 3 * 4 + i % 3] = Value(ops[i]);
+  if (Type == obj::light::type::ePoint)
+  {
+    l.Val[7] = 0.4f;
+    l.Val[8] = 0.6f;
+    l.Val[9] = 0.06f;
+  }
+  else if (Type == obj::light::type::eSpot)
+  {
+    l.Val[11] = cosf(0.1f);
+    l.Val[12] = cosf(1.1f);
+  }
+} /* End of 'parser::table::Light' function */
+
+/* Add object to scene function.
+ * ARGUMENTS:
+ *   - shape or light variable symbol id:
+ *       int Var;
+ * RETURNS: None.
+ */
+void parser::table::Add( int Var )
+{
+  if (!IsOn || !Fail.empty())
+    return;
+
+  if (Var < (int)Lights.size() && Lights[Var].IsAdded)
+  {
+    Fail = Lights[Var].Error;
+    Lights[Var].IsEnabled = true;
+    return;
+  }
+
+  shape &s = At(Var);
+
+  if (!s.Error.empty())
+    Fail = s.Error;
+  else if (s.Code.empty())
+    Fail = std::format("'{}' is added without value", symbols::GetName(Var));
+  else if (Code.size() + s.Code.size() > MaxCode)
+    Fail = "scene code is too long";
+  else
+  {
+    bool is_first = Code.empty();
+
+    Depth = std::max(Depth, (is_first ? 0 : 1) + s.Depth);
+    Code.insert(Code.end(), s.Code.begin(), s.Code.end());
+    if (!is_first)
+      Code.push_back((int)op::eAdd);
+  }
+} /* End of 'parser::table::Add' function */
+
+/* Finish scene recording function.
+ * ARGUMENTS: None.
+ * RETURNS: (bool) is scene passed in table.
+ */
+bool parser::table::End( void )
+{
+  IsBuilt = false;
+  if (!IsOn)
+    return false;
+  if (Fail.empty() && Depth > MaxStack)
+    Fail = std::format("scene needs stack of {} shapes", Depth);
+
+  // Lights are ordered by name as in generated code
+  std::vector<int> ids[3];
+
+  for (int i = 0; i < (int)Lights.size(); i++)
+    if (Lights[i].IsEnabled)
+      ids[(int)Lights[i].Type].push_back(i);
+  for (auto &v : ids)
+  {
+    std::sort(v.begin(), v.end(), [](int A, int B) { return symbols::GetName(A) < symbols::GetName(B); });
+    if (Fail.empty() && v.size() > MaxLights)
+      Fail = std::format("scene has more than {} lights of one type", MaxLights);
+  }
+  if (!Fail.empty())
+    return false;
+
+  Head.assign(CodeOffset, 0);
+  Head[0] = variables::Flags[state_type::eSky];
+  Head[1] = variables::Flags[state_type::eReflect];
+  Head[2] = variables::Flags[state_type::eShadow];
+  Head[3] = variables::Flags[state_type::eAO];
+  for (int t = 0; t < 3; t++)
+  {
+    int
+      offset = t == (int)obj::light::type::ePoint ? PointOffset : t == (int)obj::light::type::eDir ? DirOffset : SpotOffset,
+      size = t == (int)obj::light::type::ePoint ? PointSize : t == (int)obj::light::type::eDir ? DirSize : SpotSize;
+
+    Head[4 + t] = (int)ids[t].size();
+    for (int i = 0; i < (int)ids[t].size(); i++)
+      for (int j = 0; j < std::min(size, 13); j++)
+        Head[offset + i * size + j] = std::bit_cast<int>(Lights[ids[t][i]].Val[j]);
+  }
+  Head[7] = (int)Code.size();
+
+  float bound[4];
+
+  bounds::GetScene(bound);
+  for (int i = 0; i < 4; i++)
+    Head[BoundOffset + i] = std::bit_cast<int>(bound[i]);
+  Head.insert(Head.end(), Code.begin(), Code.end());
+
+  // Empty buffer can't be bound
+  if (Vals.empty())
+    Vals.push_back(0);
+  IsBuilt = true;
+  return true;
+} /* End of 'parser::table::End' function */
+
+/* Get interpreter code file name function.
+ * ARGUMENTS:
+ *   - shader template file name:
+ *       const std::string &ShIn;
+ * RETURNS: (std::string) name of 'table.glsl' near template.
+ */
+std::string parser::table::GetCodeName( const std::string &ShIn )
+{
+  return ShIn.substr(0, ShIn.find_last_of("\\/") + 1) + "table.glsl";
+} /* End of 'parser::table::GetCodeName' function */
+
+/* Get interpreter code function.
+ * ARGUMENTS:
+ *   - shader template file name, interpreter is read from 'table.glsl' near it:
+ *       const std::string &ShIn;
+ * RETURNS: (std::string) GLSL text.
+ */
+std::string parser::table::GetCodeStr( const std::string &ShIn )
+{
+  std::string res = file::ReadFile(GetCodeName(ShIn));
+
+  if (res.empty())
+    throw std::runtime_error("incorrect file!");
+
+  // Interpreter function is the file tail, distance only copy of it is added
+  size_t run = res.find("#ifndef SCENE_DIST");
+
+  if (run == std::string::npos)
+    throw std::runtime_error("incorrect file!");
+  return res + "\n#define SCENE_DIST\n" + res.substr(run) + "#undef SCENE_DIST\n";
+} /* End of 'parser::table::GetCodeStr' function */
+
+/* Get table statistics function.
+ * ARGUMENTS: None.
+ * RETURNS: (std::string) report line.
+ */
+std::string parser::table::GetStat( void )
+{
+  if (!IsBuilt)
+    return std::format("scene table: not used, {}", Fail);
+  return std::format("scene table: {} code words, {} values, stack depth {}", Code.size(), Vals.size(), Depth);
+} /* End of 'parser::table::GetStat' function */
+
+/* END OF 'table.cpp' FILE */
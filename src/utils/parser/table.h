@@ -0,0 +1,207 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+ /* FILE NAME   : table.h
+  * PURPOSE     : Ray marching project.
+  *               Parser module.
+  * PROGRAMMER  : Vladislav Biserov.
+  * LAST UPDATE : 02.04.2023
+  * NOTE        : None.
+  *
+  * No part of this file may be changed without agreement of
+  * Computer Graphics Support Group of 30 Phys-Math Lyceum
+  */
+
+#ifndef __table_h_
+#define __table_h_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "obj/obj.h"
+
+namespace parser
+{
+  class expr;
+  struct arg;
+
+  /* Scene table class.
+   * Alternative backend: objects are recorded on compile time as postfix
+   * program with constant pool, which is passed to shader in storage buffers
+   * and executed by interpreter from 'table.glsl'. Shader text doesn't depend
+   * on scene then, so scene switch needs buffers upload only.
+   * Operands are constant pool indices, negative operand -1 - N is 'FrameVal' slot N.
+   * Scenes which can't be recorded (objects depending on non frame values)
+   * are compiled to GLSL text as usual.
+   */
+  class table
+  {
+  public:
+    /* Instruction codes, values are read by 'table.glsl' */
+    enum class op
+    {
+      ePoint = 0,     // Reset point to 'SceneSDF' argument
+      eAffine = 1,    // Baked modifications: 3x3 matrix by columns and translation
+      eRotate = 2,    // Rotate point: angle and axis
+      eTranslate = 3, // Translate point: vector
+      eScale = 4,     // Scale point: vector
+      eShape = 5,     // Push shape: type, texture, arguments, material
+      eOper = 6,      // Combine two top shapes: operation type, coefficient
+      eAdd = 7,       // Add top shape to scene
+      eRepeat = 8,    // Repeat point: period
+      eRepeatN = 9,   // Repeat point limited: period and count of cells
+      eMirror = 10,   // Mirror point: plane normal
+    }; /* End of 'op' enum */
+
+    static constexpr int MaxLights = 16;   // Lights of one type capacity
+    static constexpr int MaxTex = 8;       // Number of samplers in shader
+    static constexpr int MaxStack = 16;    // Interpreter stack size
+    static constexpr int MaxCode = 1 << 22; // Program size limit in words
+    static constexpr int HeadBinding = 5;   // 'SceneHead' storage buffer binding point
+    static constexpr int DataBinding = 6;   // 'SceneData' storage buffer binding point
+
+    // Head layout in words (std430 layout of 'SceneHead' block)
+    static constexpr int
+      BoundOffset = 8, PointOffset = 12, PointSize = 12,
+      DirOffset = PointOffset + MaxLights * PointSize, DirSize = 8,
+      SpotOffset = DirOffset + MaxLights * DirSize, SpotSize = 16,
+      CodeOffset = SpotOffset + MaxLights * SpotSize;
+
+  private:
+    /* Point modification structure */
+    struct mod
+    {
+      op Type;    // Modification instruction
+      int Ops[6]; // Operands
+    }; /* End of 'mod' structure */
+
+    /* Shape variable structure */
+    struct shape
+    {
+      std::vector<mod> Mods;  // Point modifications in order
+      std::vector<int> Prim;  // Last primitive instruction
+      std::vector<int> Code;  // Postfix code of current value
+      int Depth = 0;          // Stack depth needed by code
+      std::string PrimError;  // Why primitive can't be recorded
+      std::string ModError;   // Why modifications can't be recorded
+      std::string Error;      // Why value can't be recorded
+    }; /* End of 'shape' structure */
+
+    /* Light source structure */
+    struct light
+    {
+      obj::light::type Type;  // Light type
+      float Val[13];          // Values in 'SceneHead' layout
+      std::string Error;      // Why light can't be recorded
+      bool IsAdded = false;   // Is light created
+      bool IsEnabled = false; // Is light added to scene
+    }; /* End of 'light' structure */
+
+    static thread_local std::vector<shape> Shapes;             // Shape variables by symbol id
+    static thread_local std::vector<std::vector<int>> Vars;    // Vector and material variables operands by symbol id
+    static thread_local std::vector<light> Lights;             // Light sources by symbol id
+    static thread_local std::unordered_map<unsigned, int> Pool; // Constant indices by value bits
+    static thread_local std::unordered_map<std::string, int> Slots; // Frame slots by expression text
+    static thread_local std::vector<float> Vals;               // Constant pool
+    static thread_local std::vector<int> Code;                 // Scene program
+    static thread_local std::vector<int> Head;                 // Flags, lights and program
+    static thread_local std::string Fail;                      // Why scene can't be recorded
+    static thread_local int Depth;                             // Program stack depth
+    static thread_local bool IsOn;                             // Is backend used by current compilation
+    static thread_local bool IsBuilt;                          // Was last scene recorded
+
+    table(void)
+    {
+    }
+
+    static shape & At(int Id);
+    static void Leaf(shape &S);
+    static bool Read(std::vector<arg> &Args, const std::vector<param::type> &Types, std::vector<int> &Ops, int *Tex);
+
+  public:
+    /* Check is backend enabled for current compilation function.
+     * ARGUMENTS: None.
+     * RETURNS: (bool) is enabled.
+     */
+    static bool IsEnabled(void)
+    {
+      return IsOn;
+    } /* End of 'IsEnabled' function */
+
+    /* Check was last scene passed in table function.
+     * ARGUMENTS: None.
+     * RETURNS: (bool) is scene table to be uploaded.
+     */
+    static bool IsUsed(void)
+    {
+      return IsBuilt;
+    } /* End of 'IsUsed' function */
+
+    /* Get head buffer data function.
+     * ARGUMENTS: None.
+     * RETURNS: (const std::vector<int> &) flags, lights and program.
+     */
+    static const std::vector<int> & GetHead(void)
+    {
+      return Head;
+    } /* End of 'GetHead' function */
+
+    /* Get constant buffer data function.
+     * ARGUMENTS: None.
+     * RETURNS: (const std::vector<float> &) constant pool.
+     */
+    static const std::vector<float> & GetVals(void)
+    {
+      return Vals;
+    } /* End of 'GetVals' function */
+
+    /* Get scene code for 'SceneSDF' function.
+     * ARGUMENTS: None.
+     * RETURNS: (std::string) GLSL text.
+     */
+    static std::string GetSceneStr(void)
+    {
+      return
+        "#ifndef SCENE_DIST\n"
+        "res = SceneRun(point, Mtl);\n"
+        "#else\n"
+        "res = SceneRunDist(point);\n"
+        "#endif\n";
+    } /* End of 'GetSceneStr' function */
+
+    /* Get interpreter declaration function.
+     * ARGUMENTS: None.
+     * RETURNS: (std::string) GLSL text.
+     */
+    static std::string GetFlagStr(void)
+    {
+      return
+        "float SceneRun( in vec3 point, inout mtl Mtl );\n"
+        "float SceneRunDist( in vec3 point );\n";
+    } /* End of 'GetFlagStr' function */
+
+    static void Clear(bool On);
+    static int Const(double Val);
+    static float Value(int Op);
+    static bool Slot(expr *E, int *Op);
+    static int GetVar(int Id, int *Ops);
+    static void SetVar(int Id, expr *E);
+    static void Shape(int Var, obj::shape::type Type, std::vector<arg> &Args, bool IsTex);
+    static void Mod(int Var, obj::mod::type Type, std::vector<arg> &Args);
+    static void Oper(int Var, obj::oper::type Type, const std::string &P1, const std::string &P2, expr *K);
+    static void Call(int Var, int Func);
+    static void Light(int Var, obj::light::type Type, std::vector<arg> &Args);
+    static void Add(int Var);
+    static bool End(void);
+    static std::string GetCodeName(const std::string &ShIn);
+    static std::string GetCodeStr(const std::string &ShIn);
+    static std::string GetStat(void);
+  }; /* End of 'table' class */
+}
+
+#endif
+
+/* END OF 'table.h' FILE */
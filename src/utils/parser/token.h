@@ -7,7 +7,7 @@
   * PURPOSE     : Ray marching project.
   *               Parser module.
   * PROGRAMMER  : Vladislav Biserov.
-  * LAST UPDATE : 30.03.2023
+  * LAST UPDATE : 02.04.2023
   * NOTE        : None.
   *
   * No part of this file may be changed without agreement of
@@ -18,6 +18,7 @@
 #define __token_h_
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <exception>
 #include <map>
@@ -43,11 +44,10 @@ namespace parser
     eReflect,
     eShadow,
     eAO,
+    eLod,
+    eLodDebug,
   };
 
-  extern std::map<std::string, var_type> TYPES;
-  extern std::map<std::string, state_type> STATES;
-
   enum class token_type
   {
     eNumber,
@@ -65,6 +65,8 @@ namespace parser
     eTrue,
     eFalse,
     eState,
+    eDef,
+    eReturn,
 
     ePlus,
     eMinus,
@@ -95,13 +97,17 @@ namespace parser
     eEOF
   };
 
+  /* Token class.
+   * Text is a view into the lexer input (memory mapped scene file),
+   * so tokens are cheap to copy but must not outlive the lexer source.
+   */
   class token
   {
   public:
-    std::string Text;
+    std::string_view Text;
     token_type Type;
 
-    token(std::string NewText, token_type NewType) : Text(NewText), Type(NewType)
+    token(std::string_view NewText, token_type NewType) : Text(NewText), Type(NewType)
     {
     }
   };
@@ -0,0 +1,108 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : uniform.cpp
+ * PURPOSE     : Ray marching project.
+ *               Parser module.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 02.04.2023
+ * NOTE        : None.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include "uniform.h"
+#include "vm.h"
+
+thread_local std::optional<parser::compiler> parser::uniforms::Comp;
+thread_local std::unordered_map<std::string, int> parser::uniforms::Ids;
+thread_local int
+  parser::uniforms::Count = 0,
+  parser::uniforms::Params = 0,
+  parser::uniforms::Missed = 0;
+thread_local bool
+  parser::uniforms::IsOn = false,
+  parser::uniforms::IsParams = false,
+  parser::uniforms::IsArgs = false,
+  parser::uniforms::IsLoop = false;
+
+/* Add uniform expression function.
+ * ARGUMENTS:
+ *   - expression depending on 'Time' only:
+ *       expr *E;
+ *   - expression GLSL text:
+ *       const std::string &Text;
+ * RETURNS: (int) slot, -1 if there are no free slots.
+ */
+int parser::uniforms::Add( expr *E, const std::string &Text )
+{
+  return Compute(Text, [E](compiler &C) { return E->Compile(C); });
+} /* End of 'parser::uniforms::Add' function */
+
+/* Add parameter function.
+ * ARGUMENTS:
+ *   - parameter value:
+ *       double Val;
+ * RETURNS: (int) slot (after 'FrameVal' ones), -1 if there are no free slots.
+ */
+int parser::uniforms::Param( double Val )
+{
+  // Slots aren't shared by value, layout must depend on scene structure only
+  if (!Comp.has_value())
+    return -1;
+  if (Params >= MaxParams)
+  {
+    Missed++;
+    return -1;
+  }
+  return Comp->Out(Comp->Const(Val), MaxCount + Params++);
+} /* End of 'parser::uniforms::Param' function */
+
+/* Add uniform compiled by caller function.
+ * ARGUMENTS:
+ *   - value GLSL text (slots are shared by it):
+ *       const std::string &Text;
+ *   - function compiling value to frame program, returns value register:
+ *       const std::function<int(compiler &)> &Gen;
+ * RETURNS: (int) slot, -1 if there are no free slots.
+ */
+int parser::uniforms::Compute( const std::string &Text, const std::function<int(compiler &)> &Gen )
+{
+  auto it = Ids.find(Text);
+
+  // Iterations of loop recorded read the same slot, loop arrays keep values anyway
+  if (it != Ids.end() && (!IsParams || IsLoop))
+    return it->second;
+  if (!Comp.has_value())
+    return -1;
+  if (Count >= MaxCount)
+  {
+    Missed++;
+    return -1;
+  }
+
+  int slot = Comp->Out(Gen(*Comp), Count++);
+
+  Ids.emplace(Text, slot);
+  return slot;
+} /* End of 'parser::uniforms::Compute' function */
+
+/* Finish collecting uniforms function.
+ * ARGUMENTS: None.
+ * RETURNS: (std::optional<program>) frame program, empty if uniforms weren't collected.
+ */
+std::optional<parser::program> parser::uniforms::End( void )
+{
+  std::optional<program> res;
+
+  IsOn = false;
+  if (Comp.has_value())
+    res.emplace(Comp->Link());
+  Comp.reset();
+  return res;
+} /* End of 'parser::uniforms::End' function */
+
+/* END OF 'uniform.cpp' FILE */
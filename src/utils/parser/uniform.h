@@ -0,0 +1,199 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+ /* FILE NAME   : uniform.h
+  * PURPOSE     : Ray marching project.
+  *               Parser module.
+  * PROGRAMMER  : Vladislav Biserov.
+  * LAST UPDATE : 02.04.2023
+  * NOTE        : None.
+  *
+  * No part of this file may be changed without agreement of
+  * Computer Graphics Support Group of 30 Phys-Math Lyceum
+  */
+
+#ifndef __uniform_h_
+#define __uniform_h_
+
+#include <format>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bytecode.h"
+
+namespace parser
+{
+  /* Frame uniforms class.
+   * Expressions which depend on 'Time' only are evaluated once per frame on CPU
+   * and passed to shader through 'FrameVal' uniform block instead of being
+   * computed at every 'SceneSDF' call.
+   * In parameters mode constant arguments of objects get own slots too, so
+   * scenes differing in values only produce the same shader text. They are
+   * kept in separate 'ParamVal' block, so large scenes don't take 'FrameVal'
+   * slots of 'Time' values, and are numbered after 'FrameVal' slots.
+   */
+  class uniforms
+  {
+  private:
+    static thread_local std::optional<compiler> Comp;             // Frame program being compiled
+    static thread_local std::unordered_map<std::string, int> Ids; // Slots by expression text
+    static thread_local int Count;                                // Number of used 'FrameVal' slots
+    static thread_local int Params;                               // Number of used 'ParamVal' slots
+    static thread_local int Missed;                               // Values without free slot, emitted as literals
+    static thread_local bool IsOn;                                // Is hoisting enabled
+    static thread_local bool IsParams;                            // Parameters mode of current compilation
+    static thread_local bool IsArgs;                              // Are object arguments emitted
+    static thread_local bool IsLoop;                              // Is loop of objects recorded
+
+    uniforms(void)
+    {
+    }
+  public:
+    static constexpr int MaxCount = 256;      // 'FrameVal' capacity in floats (64 vec4 in std140)
+    static constexpr int MaxParams = 4096;    // 'ParamVal' capacity in floats, 16 KB is least GL_MAX_UNIFORM_BLOCK_SIZE
+    static constexpr int ParamBinding = 7;    // 'Params' uniform block binding point
+
+    /* Start collecting uniforms function.
+     * ARGUMENTS:
+     *   - 'Time' symbol id:
+     *       int TimeId;
+     *   - parameters mode flag (see 'compile_context'):
+     *       bool IsParamsMode;
+     * RETURNS: None.
+     */
+    static void Begin(int TimeId, bool IsParamsMode)
+    {
+      Comp.emplace(TimeId);
+      Ids.clear();
+      Count = 0;
+      Params = 0;
+      Missed = 0;
+      IsOn = true;
+      IsParams = IsParamsMode;
+      IsLoop = false;
+    } /* End of 'Begin' function */
+
+    /* Enable or disable hoisting function.
+     * ARGUMENTS:
+     *   - enable flag:
+     *       bool On;
+     * RETURNS: None.
+     */
+    static void Enable(bool On)
+    {
+      IsOn = On && Comp.has_value();
+    } /* End of 'Enable' function */
+
+    /* Check is hoisting enabled function.
+     * ARGUMENTS: None.
+     * RETURNS: (bool) is enabled.
+     */
+    static bool IsEnabled(void)
+    {
+      return IsOn;
+    } /* End of 'IsEnabled' function */
+
+    /* Mark object arguments emission function.
+     * ARGUMENTS:
+     *   - are arguments emitted flag:
+     *       bool On;
+     * RETURNS: (bool) previous flag value.
+     */
+    static bool SetArgs(bool On)
+    {
+      bool old = IsArgs;
+
+      IsArgs = On;
+      return old;
+    } /* End of 'SetArgs' function */
+
+    /* Mark loop of objects recording function.
+     * Iterations text is merged to GLSL loop only if it is the same, so
+     * parameters aren't taken and only values equal in all iterations
+     * are hoisted (they share slot by text).
+     * ARGUMENTS:
+     *   - is loop recorded flag:
+     *       bool On;
+     * RETURNS: (bool) previous flag value.
+     */
+    static bool SetLoop(bool On)
+    {
+      bool old = IsLoop;
+
+      IsLoop = On;
+      return old;
+    } /* End of 'SetLoop' function */
+
+    /* Check is loop of objects recorded function.
+     * ARGUMENTS: None.
+     * RETURNS: (bool) is loop recorded.
+     */
+    static bool IsInLoop(void)
+    {
+      return IsLoop;
+    } /* End of 'IsInLoop' function */
+
+    /* Check is constant to be passed as parameter function.
+     * ARGUMENTS: None.
+     * RETURNS: (bool) is parameter slot needed.
+     */
+    static bool IsParam(void)
+    {
+      return IsParams && IsArgs && IsOn && !IsLoop;
+    } /* End of 'IsParam' function */
+
+    /* Get slot GLSL name function.
+     * ARGUMENTS:
+     *   - slot:
+     *       int Slot;
+     * RETURNS: (std::string) name.
+     */
+    static std::string Name(int Slot)
+    {
+      if (Slot >= MaxCount)
+        return std::format("ParamVal[{}].{}", (Slot - MaxCount) / 4, "xyzw"[(Slot - MaxCount) % 4]);
+      return std::format("FrameVal[{}].{}", Slot / 4, "xyzw"[Slot % 4]);
+    } /* End of 'Name' function */
+
+    /* Get number of slots function.
+     * ARGUMENTS: None.
+     * RETURNS: (int) number of 'FrameVal' slots.
+     */
+    static int GetCount(void)
+    {
+      return Count;
+    } /* End of 'GetCount' function */
+
+    /* Get number of parameter slots function.
+     * ARGUMENTS: None.
+     * RETURNS: (int) number of 'ParamVal' slots.
+     */
+    static int GetParams(void)
+    {
+      return Params;
+    } /* End of 'GetParams' function */
+
+    /* Get number of values without free slot function.
+     * ARGUMENTS: None.
+     * RETURNS: (int) number of values emitted as literals because their block is full.
+     */
+    static int GetMissed(void)
+    {
+      return Missed;
+    } /* End of 'GetMissed' function */
+
+    static int Add(expr *E, const std::string &Text);
+    static int Param(double Val);
+    static int Compute(const std::string &Text, const std::function<int(compiler &)> &Gen);
+    static std::optional<program> End(void);
+  }; /* End of 'uniforms' class */
+}
+
+#endif
+
+/* END OF 'uniform.h' FILE */
@@ -7,7 +7,7 @@
   * PURPOSE     : Ray marching project.
   *               Parser module.
   * PROGRAMMER  : Vladislav Biserov.
-  * LAST UPDATE : 30.03.2023
+  * LAST UPDATE : 02.04.2023
   * NOTE        : None.
   *
   * No part of this file may be changed without agreement of
@@ -18,48 +18,71 @@
 #define __variable_h_
 
 #include <map>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
+#include "obj/shape.h"
+#include "symbol.h"
 #include "token.h"
 
 namespace parser
 {
-  /* Variable class */
+  /* Variable class.
+   * Values are kept in flat array indexed by symbol id.
+   */
   class variables
   {
   private:
     /* Variable daata structure */
     struct data
     {
-      var_type Type;    // Variable type
-      double Val;       // Returning value
-      std::string Text; // After '='
+      var_type Type;          // Variable type
+      double Val;             // Returning value
+      bool IsDefined = false; // Is variable declared
     }; /* End of 'data' structure */
 
-    static std::map<std::string, data> Table;
-    static std::map<std::string, std::string> Shapes;
+    /* Shape code structure */
+    struct shape
+    {
+      std::string Text;      // Evaluation GLSL code
+      std::vector<int> Uses; // Output names code reads (see 'file::Name')
+      obj::shape::mtl Mtl;   // Material of primitive, empty text if evaluation code assigns material
+    }; /* End of 'shape' structure */
+
+    static thread_local std::vector<data> Table;
+    static thread_local std::vector<shape> Shapes;
+    static thread_local std::vector<std::pair<int, shape>> Kept; // Shapes saved before GLSL loop body by symbol id
 
     variables(void)
     {
     }
   public:
-    static bool IsFirst;
-    static std::map<state_type, bool> Flags;
+    static thread_local bool IsFirst;
+    static thread_local std::map<state_type, bool> Flags;
 
+    /* Reset all variables function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
     static void Clear( void )
     {
       Shapes.clear();
+      Kept.clear();
       IsFirst = true;
       Table.clear();
+      symbols::Clear();
 
-      Table["PI"] = { var_type::eFloat, 3.1415 };
-      Table["Time"] = { var_type::eFloat, 0 };
+      Set(symbols::Intern("PI"), var_type::eFloat, 3.1415);
+      Set(symbols::Intern("Time"), var_type::eFloat, 0);
 
       Flags[state_type::eAO] = false;
       Flags[state_type::eReflect] = true;
       Flags[state_type::eShadow] = true;
       Flags[state_type::eSky] = true;
-    }
+      Flags[state_type::eLod] = true;
+      Flags[state_type::eLodDebug] = false;
+    } /* End of 'Clear' function */
 
     static std::string GetFlagStr( void )
     {
@@ -69,82 +92,187 @@ namespace parser
       return std::format("const bool IsSkybox = {0};\n"
                          "const bool IsReflection = {1};\n"
                          "const bool IsShadows = {2};\n"
-                         "const bool IsAO = {3};\n", 
+                         "const bool IsAO = {3};\n"
+                         "const bool IsLod = {4};\n"
+                         "const bool IsLodDebug = {5};\n",
         Flags[state_type::eSky] ? "true" : "false",
         Flags[state_type::eReflect] ? "true" : "false",
         Flags[state_type::eShadow] ? "true" : "false",
-        Flags[state_type::eAO] ? "true" : "false");
+        Flags[state_type::eAO] ? "true" : "false",
+        Flags[state_type::eLod] ? "true" : "false",
+        Flags[state_type::eLodDebug] ? "true" : "false");
     }
 
-    static data Get(std::string Name)
+    /* Check is variable exists function.
+     * ARGUMENTS:
+     *   - symbol id:
+     *       int Id;
+     * RETURNS: (bool) is exists.
+     */
+    static bool IsExists(int Id)
     {
-      if (Table.find(Name) != Table.end())
-        return Table[Name];
-      throw std::exception("no such variable exists");
-    } /* End of 'Get' function */
+      return Id >= 0 && Id < (int)Table.size() && Table[Id].IsDefined;
+    } /* End of 'IsExists' function */
 
-    static bool GetType(std::string Name, var_type* Type)
+    /* Get variable function.
+     * ARGUMENTS:
+     *   - symbol id:
+     *       int Id;
+     * RETURNS: (const data &) variable.
+     */
+    static const data & Get(int Id)
     {
-      auto search = Table.find(Name);
+      if (!IsExists(Id))
+        throw std::runtime_error("no such variable exists");
+      return Table[Id];
+    } /* End of 'Get' function */
 
-      if (search == Table.end())
+    /* Get variable type function.
+     * ARGUMENTS:
+     *   - symbol id:
+     *       int Id;
+     *   - type (out):
+     *       var_type *Type;
+     * RETURNS: (bool) is variable exists.
+     */
+    static bool GetType(int Id, var_type* Type)
+    {
+      if (!IsExists(Id))
         return false;
-      *Type = search->second.Type;
+      *Type = Table[Id].Type;
       return true;
     } /* End of 'GetType' function */
 
-    static bool IsExists(std::string Name)
-    {
-      return Table.find(Name) != Table.end();
-    } /* End of 'IsExists' function */
-
     /* Set variable function.
      * ARGUMENTS:
-     *   - Key:
-     *       const std::string Name;
-     *   - Value:
-     *       data val;
+     *   - symbol id:
+     *       int Id;
+     *   - type:
+     *       var_type Type;
+     *   - value:
+     *       double Val;
      * RETURNS: None.
      */
-    static void Set(std::string Key, data Val)
+    static void Set(int Id, var_type Type, double Val)
     {
-      Table[Key] = Val;
+      if (Id >= (int)Table.size())
+        Table.resize(Id + 1);
+      Table[Id] = {Type, Val, true};
     } /* End of 'Set' function */
 
+    /* Set existing variable value function.
+     * ARGUMENTS:
+     *   - symbol id:
+     *       int Id;
+     *   - value:
+     *       double Val;
+     * RETURNS: None.
+     */
+    static void SetVal(int Id, double Val)
+    {
+      Table[Id].Val = Val;
+    } /* End of 'SetVal' function */
+
     /* Check is shape exists function.
      * ARGUMENTS:
-     *   - shape name:
-     *       const std::string Name;
+     *   - symbol id:
+     *       int Id;
      * RETURNS: (bool) is exists.
      */
-    static bool IsShapeExists(const std::string& Name)
+    static bool IsShapeExists(int Id)
     {
-      return Shapes.find(Name) != Shapes.end();
+      return Id >= 0 && Id < (int)Shapes.size() && !Shapes[Id].Text.empty();
     } /* End of 'IsShapeExists' function */
 
     /* Get shape function.
      * ARGUMENTS:
-     *   - shape name:
-     *       const std::string Name;
-     * RETURNS: (std::string) Name.
+     *   - symbol id:
+     *       int Id;
+     * RETURNS: (const std::string &) shape GLSL code.
      */
-    static std::string GetShape(const std::string& Name)
+    static const std::string & GetShape(int Id)
     {
-      if (Shapes.find(Name) != Shapes.end())
-        return Shapes[Name];
-      throw std::exception("no such shape exists");
+      if (!IsShapeExists(Id))
+        throw std::runtime_error("no such shape exists");
+      return Shapes[Id].Text;
     } /* End of 'GetShape' function */
 
+    /* Get names read by shape function.
+     * ARGUMENTS:
+     *   - symbol id:
+     *       int Id;
+     * RETURNS: (const std::vector<int> &) output names shape code reads.
+     */
+    static const std::vector<int> & GetShapeUses(int Id)
+    {
+      if (!IsShapeExists(Id))
+        throw std::runtime_error("no such shape exists");
+      return Shapes[Id].Uses;
+    } /* End of 'GetShapeUses' function */
+
+    /* Get material of shape function.
+     * ARGUMENTS:
+     *   - symbol id:
+     *       int Id;
+     * RETURNS: (obj::shape::mtl &) material of primitive, empty text if evaluation code assigns material.
+     */
+    static obj::shape::mtl & GetShapeMtl(int Id)
+    {
+      if (!IsShapeExists(Id))
+        throw std::runtime_error("no such shape exists");
+      return Shapes[Id].Mtl;
+    } /* End of 'GetShapeMtl' function */
+
     /* Set shape function.
      * ARGUMENTS:
-     *   - Key, value:
-     *       const std::string Key, Val;
+     *   - symbol id:
+     *       int Id;
+     *   - shape GLSL code:
+     *       const std::string &Val;
+     *   - output names code reads:
+     *       std::vector<int> &&Uses;
+     *   - material of primitive, empty text if code assigns material:
+     *       obj::shape::mtl &&Mtl;
      * RETURNS: None.
      */
-    static void SetShape(const std::string& Key, const std::string& Val)
+    static void SetShape(int Id, const std::string& Val, std::vector<int> &&Uses, obj::shape::mtl &&Mtl = {})
     {
-      Shapes[Key] = Val;
+      if (Id >= (int)Shapes.size())
+        Shapes.resize(Id + 1);
+      Shapes[Id] = {Val, std::move(Uses), std::move(Mtl)};
     } /* End of 'SetShape' function */
+
+    /* Save shape before GLSL loop body assigns it function.
+     * Loop body text reads loop variables, after loop shape keeps text of last iteration.
+     * ARGUMENTS:
+     *   - symbol id:
+     *       int Id;
+     * RETURNS: None.
+     */
+    static void Keep(int Id)
+    {
+      for (auto &k : Kept)
+        if (k.first == Id)
+          return;
+      Kept.push_back({Id, IsShapeExists(Id) ? Shapes[Id] : shape()});
+    } /* End of 'Keep' function */
+
+    /* Restore shapes saved before GLSL loop body function.
+     * Material assignment numbers of loop body are kept.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    static void Restore(void)
+    {
+      for (auto &k : Kept)
+      {
+        int write = Shapes[k.first].Mtl.Write;
+
+        Shapes[k.first] = std::move(k.second);
+        Shapes[k.first].Mtl.Write = write;
+      }
+      Kept.clear();
+    } /* End of 'Restore' function */
   }; /* End of 'variable' class */
 }
 
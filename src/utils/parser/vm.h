@@ -0,0 +1,207 @@
+/*************************************************************
+ * Copyright (C) 2022-2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+ /* FILE NAME   : vm.h
+  * PURPOSE     : Ray marching project.
+  *               Parser module.
+  * PROGRAMMER  : Vladislav Biserov.
+  * LAST UPDATE : 01.04.2023
+  * NOTE        : None.
+  *
+  * No part of this file may be changed without agreement of
+  * Computer Graphics Support Group of 30 Phys-Math Lyceum
+  */
+
+#ifndef __vm_h_
+#define __vm_h_
+
+#include <math.h>
+
+#include "bytecode.h"
+#include "statement.h"
+
+namespace parser
+{
+  /* Scene program virtual machine class.
+   * Executes compiled program instead of walking syntax tree,
+   * variable slots are read from the 'variables' table once before run,
+   * stores write them through to the table.
+   */
+  class vm
+  {
+  private:
+    program Prog;
+    std::vector<double> R;   // Register file
+    std::vector<float> Outs; // Program outputs
+
+    /* Execute loaded program function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    void Exec(void)
+    {
+      const instr *code = Prog.Code.data(), *pc = code;
+      double *r = R.data();
+
+      while (true)
+      {
+        const instr &i = *pc++;
+
+        switch (i.Op)
+        {
+        case opcode::eStore:
+          r[i.A] = r[i.B];
+          variables::SetVal(i.A, r[i.A]);
+          break;
+        case opcode::eStoreInt:
+          r[i.A] = (int)r[i.B];
+          variables::SetVal(i.A, r[i.A]);
+          break;
+        case opcode::eAdd:
+          r[i.A] = r[i.B] + r[i.C];
+          break;
+        case opcode::eSub:
+          r[i.A] = r[i.B] - r[i.C];
+          break;
+        case opcode::eMul:
+          r[i.A] = r[i.B] * r[i.C];
+          break;
+        case opcode::eDiv:
+          r[i.A] = r[i.B] / r[i.C];
+          break;
+        case opcode::eEQ:
+          r[i.A] = r[i.B] == r[i.C];
+          break;
+        case opcode::eNOTEQ:
+          r[i.A] = r[i.B] != r[i.C];
+          break;
+        case opcode::eLT:
+          r[i.A] = r[i.B] < r[i.C];
+          break;
+        case opcode::eLTEQ:
+          r[i.A] = r[i.B] <= r[i.C];
+          break;
+        case opcode::eGT:
+          r[i.A] = r[i.B] > r[i.C];
+          break;
+        case opcode::eGTEQ:
+          r[i.A] = r[i.B] >= r[i.C];
+          break;
+        case opcode::eAnd:
+          r[i.A] = r[i.B] && r[i.C];
+          break;
+        case opcode::eOr:
+          r[i.A] = r[i.B] || r[i.C];
+          break;
+        case opcode::eNeg:
+          r[i.A] = -r[i.B];
+          break;
+        case opcode::eSin:
+          r[i.A] = sin(r[i.B]);
+          break;
+        case opcode::eCos:
+          r[i.A] = cos(r[i.B]);
+          break;
+        case opcode::eAbs:
+          r[i.A] = fabs(r[i.B]);
+          break;
+        case opcode::eMod:
+          r[i.A] = fmod(r[i.B], r[i.C]);
+          break;
+        case opcode::eJump:
+          pc = code + i.A;
+          break;
+        case opcode::eJumpIfZero:
+          if (r[i.A] == 0)
+            pc = code + i.B;
+          break;
+        case opcode::eEval:
+          r[i.A] = Prog.Exprs[i.B]->Eval();
+          break;
+        case opcode::eExec:
+          Prog.Statements[i.A]->Execute();
+          // Tree walker could change variables
+          Load();
+          break;
+        case opcode::ePrint:
+          Prog.Assigns[i.A]->Print();
+          break;
+        case opcode::eLoop:
+          if (Prog.Loops[i.A]->Begin())
+            pc = code + i.B;
+          // Loop emitted at once runs its iterations on compile time
+          Load();
+          break;
+        case opcode::eNext:
+          Prog.Loops[i.A]->Next();
+          break;
+        case opcode::eDone:
+          Prog.Loops[i.A]->End();
+          break;
+        case opcode::eOut:
+          Outs[i.A] = (float)r[i.B];
+          break;
+        case opcode::eHalt:
+          return;
+        }
+      }
+    } /* End of 'Exec' function */
+
+    /* Read variable slots function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    void Load(void)
+    {
+      for (int i = 0; i < Prog.Slots; i++)
+        if (variables::IsExists(i))
+          R[i] = variables::Get(i).Val;
+    } /* End of 'Load' function */
+
+  public:
+    vm(program &&Prog) : Prog(std::move(Prog))
+    {
+      Outs.resize(this->Prog.Outs);
+    }
+
+    /* Get loaded program function.
+     * ARGUMENTS: None.
+     * RETURNS: (const program &) program.
+     */
+    const program & GetProgram(void) const
+    {
+      return Prog;
+    } /* End of 'GetProgram' function */
+
+    /* Run scene program function.
+     * ARGUMENTS: None.
+     * RETURNS: None.
+     */
+    void Run(void)
+    {
+      R = Prog.Regs;
+      Load();
+      Exec();
+    } /* End of 'Run' function */
+
+    /* Run frame program function.
+     * ARGUMENTS:
+     *   - current time:
+     *       double Time;
+     * RETURNS: (const std::vector<float> &) outputs.
+     */
+    const std::vector<float> & Frame(double Time)
+    {
+      R = Prog.Regs;
+      R[Prog.Time] = Time;
+      Exec();
+      return Outs;
+    } /* End of 'Frame' function */
+  }; /* End of 'vm' class */
+}
+
+#endif
+
+/* END OF 'vm.h' FILE */
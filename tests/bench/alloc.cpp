@@ -0,0 +1,177 @@
+/*************************************************************
+ * Copyright (C) 2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : alloc.cpp
+ * PURPOSE     : Ray marching project.
+ *               Allocations benchmark.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 02.04.2023
+ * NOTE        : Compiles synthetic scene of 50000 statements,
+ *               prints heap allocations, syntax tree arena use
+ *               and compilation time.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include "bench.h"
+
+using test::bench;
+
+/* Heap allocations counter */
+static std::atomic<size_t> Allocs = 0;
+
+/* Allocate counted memory function.
+ * ARGUMENTS:
+ *   - memory size and alignment:
+ *       size_t Size, Align;
+ * RETURNS: (void *) allocated memory.
+ */
+static void * Alloc(size_t Size, size_t Align)
+{
+  void *p;
+
+  Allocs++;
+  Size = Size == 0 ? 1 : Size;
+#ifdef _WIN32
+  p = Align == 0 ? std::malloc(Size) : _aligned_malloc(Size, Align);
+#else
+  p = Align == 0 ? std::malloc(Size) : std::aligned_alloc(Align, (Size + Align - 1) / Align * Align);
+#endif
+  if (p == nullptr)
+    throw std::bad_alloc();
+  return p;
+} /* End of 'Alloc' function */
+
+/* Free counted memory function.
+ * ARGUMENTS:
+ *   - memory:
+ *       void *P;
+ *   - is memory aligned flag:
+ *       bool IsAligned;
+ * RETURNS: None.
+ */
+static void Free(void *P, bool IsAligned)
+{
+#ifdef _WIN32
+  if (IsAligned)
+    _aligned_free(P);
+  else
+    std::free(P);
+#else
+  (void)IsAligned;
+  std::free(P);
+#endif
+} /* End of 'Free' function */
+
+/* Count heap allocation operators, all forms are replaced.
+ * GCC can't match inlined replacement 'delete' with replacement 'new'. */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void * operator new(size_t Size)
+{
+  return Alloc(Size, 0);
+}
+void * operator new[](size_t Size)
+{
+  return Alloc(Size, 0);
+}
+void * operator new(size_t Size, std::align_val_t Align)
+{
+  return Alloc(Size, (size_t)Align);
+}
+void * operator new[](size_t Size, std::align_val_t Align)
+{
+  return Alloc(Size, (size_t)Align);
+}
+void operator delete(void *P) noexcept
+{
+  Free(P, false);
+}
+void operator delete[](void *P) noexcept
+{
+  Free(P, false);
+}
+void operator delete(void *P, size_t) noexcept
+{
+  Free(P, false);
+}
+void operator delete[](void *P, size_t) noexcept
+{
+  Free(P, false);
+}
+void operator delete(void *P, std::align_val_t) noexcept
+{
+  Free(P, true);
+}
+void operator delete[](void *P, std::align_val_t) noexcept
+{
+  Free(P, true);
+}
+void operator delete(void *P, size_t, std::align_val_t) noexcept
+{
+  Free(P, true);
+}
+void operator delete[](void *P, size_t, std::align_val_t) noexcept
+{
+  Free(P, true);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+/* The main program function.
+ * ARGUMENTS: None.
+ * RETURNS:
+ *   (int) Error level for operation system (0 for success).
+ */
+int main(void)
+{
+  const int Shapes = 10000;
+  std::string text;
+
+  // Five statements per shape
+  for (int i = 0; i < Shapes; i++)
+    text += std::format(
+      "double x{0} = {0} * 0.5 + 1;\n"
+      "double y{0} = sin(x{0}) * 2;\n"
+      "shape s{0} = sphere(vec3(x{0}, y{0}, 0), 0.5, MtlLib[{1}]);\n"
+      "s{0} = translate(vec3(0, 1, 0));\n"
+      "add(s{0});\n", i, i % 8);
+
+  std::filesystem::path scene = bench::Write("alloc", text);
+  parser::compile_context ctx;
+  size_t allocs = 0;
+  std::string arena;
+  double t = bench::Time([&]( void )
+    {
+      size_t start = Allocs;
+
+      bench::Compile(scene, ctx);
+      allocs = Allocs - start;
+
+      std::string rep = ctx.Report;
+      size_t p = rep.find("syntax tree:");
+
+      arena = p == std::string::npos ? "" : rep.substr(p, rep.find('\n', p) - p);
+    }, 3, 0);
+
+  std::cout << std::format("{} statements, {} bytes of scene text\n", Shapes * 5, text.size());
+  std::cout << std::format("heap allocations: {}\n", allocs);
+  std::cout << arena << '\n';
+  std::cout << std::format("compilation: {:.1f} ms\n", t * 1000);
+  return 0;
+} /* End of 'main' function */
+
+/* END OF 'alloc.cpp' FILE */
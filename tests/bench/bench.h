@@ -0,0 +1,134 @@
+/*************************************************************
+ * Copyright (C) 2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : bench.h
+ * PURPOSE     : Ray marching project.
+ *               Scene compiler benchmarks.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 02.04.2023
+ * NOTE        : Benchmarks aren't run by 'ctest', they print
+ *               tables to be compared between builds. Build
+ *               them in release configuration.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#ifndef __bench_h_
+#define __bench_h_
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "parser.h"
+
+namespace test
+{
+  /* Benchmark utilities class */
+  class bench
+  {
+  public:
+    /* Measure function run time.
+     * Function is run at least 'MinRuns' times and for at least
+     * 'MinTime' seconds, best run is taken.
+     * ARGUMENTS:
+     *   - function to measure:
+     *       const std::function<void(void)> &Run;
+     *   - minimal runs count:
+     *       int MinRuns;
+     *   - minimal total time in seconds:
+     *       double MinTime;
+     * RETURNS: (double) best run time in seconds.
+     */
+    static double Time(const std::function<void(void)> &Run, int MinRuns = 5, double MinTime = 0.2)
+    {
+      using clock = std::chrono::steady_clock;
+      double best = 1e30, total = 0;
+
+      for (int i = 0; i < MinRuns || total < MinTime; i++)
+      {
+        clock::time_point start = clock::now();
+
+        Run();
+
+        double t = std::chrono::duration<double>(clock::now() - start).count();
+
+        best = std::min(best, t);
+        total += t;
+      }
+      return best;
+    } /* End of 'Time' function */
+
+    /* Get bundled scenes function.
+     * ARGUMENTS: None.
+     * RETURNS: (std::vector<std::filesystem::path>) scenes of 'bin/scenes' and 'tests/scenes' sorted by name.
+     */
+    static std::vector<std::filesystem::path> Scenes(void)
+    {
+      std::vector<std::filesystem::path> res;
+
+      for (const char *d : {TRM_SOURCE_DIR "/bin/scenes", TRM_SOURCE_DIR "/tests/scenes"})
+        for (auto &e : std::filesystem::directory_iterator(d))
+          if (e.path().extension() == ".scene")
+            res.push_back(e.path());
+      std::sort(res.begin(), res.end());
+      return res;
+    } /* End of 'Scenes' function */
+
+    /* Write generated scene function.
+     * ARGUMENTS:
+     *   - scene name:
+     *       const std::string &Name;
+     *   - scene text:
+     *       const std::string &Text;
+     * RETURNS: (std::filesystem::path) scene file in temporary directory.
+     */
+    static std::filesystem::path Write(const std::string &Name, const std::string &Text)
+    {
+      std::filesystem::path dir = std::filesystem::temp_directory_path() / "trm_bench";
+
+      std::filesystem::create_directories(dir);
+      std::ofstream(dir / (Name + ".scene"), std::ios::binary) << Text;
+      return dir / (Name + ".scene");
+    } /* End of 'Write' function */
+
+    /* Compile scene function.
+     * ARGUMENTS:
+     *   - scene file name:
+     *       const std::filesystem::path &Scene;
+     *   - compilation switches and results:
+     *       parser::compile_context &Ctx;
+     * RETURNS: (std::string) shader text, empty if scene failed to compile.
+     */
+    static std::string Compile(const std::filesystem::path &Scene, parser::compile_context &Ctx)
+    {
+      std::filesystem::path out = std::filesystem::temp_directory_path() / "trm_bench" / "out.glsl";
+      std::map<std::string, trm::tex_data> tex;
+
+      Ctx.IsConvert = false;
+      std::filesystem::create_directories(out.parent_path());
+      try
+      {
+        parser::Parse(Scene.string(), TRM_SOURCE_DIR "/bin/shaders/RT/myfrag.glsl", out.string(), tex, Ctx);
+      }
+      catch (std::exception &)
+      {
+        return {};
+      }
+      return Ctx.Shader;
+    } /* End of 'Compile' function */
+  }; /* End of 'bench' class */
+}
+
+#endif
+
+/* END OF 'bench.h' FILE */
@@ -0,0 +1,89 @@
+/*************************************************************
+ * Copyright (C) 2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : lexer.cpp
+ * PURPOSE     : Ray marching project.
+ *               Lexer throughput benchmark.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 02.04.2023
+ * NOTE        : Maps each scene and scans all its tokens, prints
+ *               MB/s for bundled scenes and synthetic large ones.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include "bench.h"
+
+using test::bench;
+
+/* Generate large scene function.
+ * ARGUMENTS:
+ *   - approximate size in bytes:
+ *       size_t Size;
+ * RETURNS: (std::string) scene text.
+ */
+static std::string Large(size_t Size)
+{
+  std::string res;
+
+  for (int i = 0; res.size() < Size; i++)
+  {
+    res += std::format("// shape {0}\nshape s{0} = sphere(vec3({1}, {2:.3f}, -{3}), 0.5, MtlLib[{4}]);\n",
+      i, i % 100, 1 + i * 0.001, i / 100, i % 8);
+    res += std::format("s{0} = rotate({1}, vec3(0, 1, 0));\nif (s{0} > 0)\n{{\n  add(s{0});\n}}\n", i, i % 360);
+  }
+  return res;
+} /* End of 'Large' function */
+
+/* Measure scene lexing function.
+ * ARGUMENTS:
+ *   - scene file name:
+ *       const std::filesystem::path &Scene;
+ *   - name in table:
+ *       const std::string &Name;
+ * RETURNS: None.
+ */
+static void Lex(const std::filesystem::path &Scene, const std::string &Name)
+{
+  size_t size = std::filesystem::file_size(Scene), tokens = 0;
+  bool is_ok = true;
+  double t = bench::Time([&]( void )
+    {
+      parser::mapping m(Scene.string());
+      parser::lexer l(m.View());
+
+      tokens = 0;
+      try
+      {
+        while (l.Scan().Type != parser::token_type::eEOF)
+          tokens++;
+      }
+      catch (std::exception &)
+      {
+        is_ok = false;
+      }
+    });
+
+  std::cout << std::format("{:<24} {:>10} {:>9} {:>10.3f} {:>9.1f}{}\n", Name, size, tokens, t * 1000,
+    size / t / (1 << 20), is_ok ? "" : "  (unbalanced tags)");
+} /* End of 'Lex' function */
+
+/* The main program function.
+ * ARGUMENTS: None.
+ * RETURNS:
+ *   (int) Error level for operation system (0 for success).
+ */
+int main(void)
+{
+  std::cout << std::format("{:<24} {:>10} {:>9} {:>10} {:>9}\n", "scene", "bytes", "tokens", "ms", "MB/s");
+  for (auto &s : bench::Scenes())
+    Lex(s, std::filesystem::relative(s, TRM_SOURCE_DIR).generic_string());
+  for (size_t mb : {1, 20})
+    Lex(bench::Write(std::format("lex{}", mb), Large(mb << 20)), std::format("synthetic {} MB", mb));
+  return 0;
+} /* End of 'main' function */
+
+/* END OF 'lexer.cpp' FILE */
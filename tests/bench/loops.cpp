@@ -0,0 +1,152 @@
+/*************************************************************
+ * Copyright (C) 2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : loops.cpp
+ * PURPOSE     : Ray marching project.
+ *               Loops of objects benchmark.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 02.04.2023
+ * NOTE        : Compiles loop heavy scenes written with loops
+ *               and unrolled by hand (that is what shader got
+ *               before GLSL loops), prints shader size and
+ *               compilation time. GL compile time is printed by
+ *               application on each shader rebuild.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include "bench.h"
+
+using test::bench;
+
+/* Scene generator type, argument is unrolled flag */
+using generator = std::function<std::string(bool)>;
+
+/* Count 'SceneSDF' lines function.
+ * ARGUMENTS:
+ *   - shader text:
+ *       const std::string &Shader;
+ * RETURNS: (int) lines count.
+ */
+static int Lines(const std::string &Shader)
+{
+  size_t
+    start = Shader.find("float SceneSDF("),
+    end = start == std::string::npos ? start : Shader.find("return res;\n}\n", start);
+
+  if (end == std::string::npos)
+    return 0;
+  return (int)std::count(Shader.begin() + start, Shader.begin() + end, '\n') + 2;
+} /* End of 'Lines' function */
+
+/* Measure scene function.
+ * ARGUMENTS:
+ *   - scene name:
+ *       const std::string &Name;
+ *   - scene generator:
+ *       const generator &Gen;
+ * RETURNS: None.
+ */
+static void Measure(const std::string &Name, const generator &Gen)
+{
+  for (bool is_unrolled : {true, false})
+  {
+    std::filesystem::path scene = bench::Write("loops", Gen(is_unrolled));
+    parser::compile_context ctx;
+    std::string sh;
+    double t = bench::Time([&]( void ) { sh = bench::Compile(scene, ctx); }, 3, 0);
+    std::string &rep = ctx.Report;
+    size_t p = rep.find("GLSL loops:");
+
+    std::cout << std::format("{:<28} {:<9} {:>9} {:>7} {:>9.1f}  {}\n", Name, is_unrolled ? "unrolled" : "loop",
+      sh.size(), Lines(sh), t * 1000, p == std::string::npos ? "" : rep.substr(p, rep.find('\n', p) - p));
+  }
+} /* End of 'Measure' function */
+
+/* Sphere grid scene function.
+ * ARGUMENTS:
+ *   - grid size:
+ *       int N;
+ *   - sphere height text by outer loop variable text:
+ *       const std::function<std::string(const std::string &)> &Y;
+ *   - unrolled flag:
+ *       bool IsUnrolled;
+ * RETURNS: (std::string) scene text.
+ */
+static std::string Grid(int N, const std::function<std::string(const std::string &)> &Y, bool IsUnrolled)
+{
+  std::string res = "shape g = box(vec3(0, -1, 0), vec3(100, 1, 100), MtlLib[1]);\nadd(g);\n";
+
+  if (!IsUnrolled)
+    return res + std::format(
+      "for (int i = 0, i < {0}, i = i + 1)\n{{\n"
+      "  for (int j = 0, j < {0}, j = j + 1)\n  {{\n"
+      "    shape s = sphere(vec3(i * 2, {1}, j * 2), 0.5, MtlLib[0]);\n"
+      "    add(s);\n"
+      "  }}\n}}\n", N, Y("i"));
+  // Variable is declared once, as loop does
+  for (int i = 0; i < N; i++)
+    for (int j = 0; j < N; j++)
+      res += std::format("{}s = sphere(vec3({}, {}, {}), 0.5, MtlLib[0]);\nadd(s);\n",
+        i + j == 0 ? "shape " : "", i * 2, Y(std::to_string(i)), j * 2);
+  return res;
+} /* End of 'Grid' function */
+
+/* Rotated boxes ring scene function.
+ * ARGUMENTS:
+ *   - boxes count:
+ *       int N;
+ *   - unrolled flag:
+ *       bool IsUnrolled;
+ * RETURNS: (std::string) scene text.
+ */
+static std::string Ring(int N, bool IsUnrolled)
+{
+  std::string res =
+    "shape g = box(vec3(0, -1, 0), vec3(100, 1, 100), MtlLib[1]);\nadd(g);\n"
+    "shape b = box(vec3(10, 1, 0), vec3(0.5, 1, 0.5), MtlLib[2]);\n";
+
+  // Rotations of shape accumulate, so each box turns by the same step
+  if (!IsUnrolled)
+    return res + std::format(
+      "for (int i = 0, i < {}, i = i + 1)\n{{\n"
+      "  b = box(vec3(10, 1, 0), vec3(0.5, 1, 0.5), MtlLib[2]);\n"
+      "  b = rotate({}, vec3(0, 1, 0));\n"
+      "  add(b);\n}}\n", N, 360.0 / N);
+  for (int i = 0; i < N; i++)
+    res += std::format(
+      "b = box(vec3(10, 1, 0), vec3(0.5, 1, 0.5), MtlLib[2]);\n"
+      "b = rotate({}, vec3(0, 1, 0));\n"
+      "add(b);\n", 360.0 / N);
+  return res;
+} /* End of 'Ring' function */
+
+/* The main program function.
+ * ARGUMENTS: None.
+ * RETURNS:
+ *   (int) Error level for operation system (0 for success).
+ */
+int main(void)
+{
+  std::cout << std::format("{:<28} {:<9} {:>9} {:>7} {:>9}\n", "scene", "form", "bytes", "lines", "ms");
+  auto flat = [](const std::string &) { return std::string("1"); };
+
+  Measure("20x20 sphere grid", [&](bool U) { return Grid(20, flat, U); });
+  Measure("40x40 sphere grid", [&](bool U) { return Grid(40, flat, U); });
+  Measure("20x20 grid, sin(Time)", [](bool U)
+    {
+      return Grid(20, [](const std::string &) { return std::string("1 + sin(Time)"); }, U);
+    });
+  Measure("20x20 grid, sin(Time + i)", [](bool U)
+    {
+      return Grid(20, [](const std::string &I) { return "1 + sin(Time + " + I + ")"; }, U);
+    });
+  Measure("8 rotated boxes", [](bool U) { return Ring(8, U); });
+  Measure("64 rotated boxes", [](bool U) { return Ring(64, U); });
+  return 0;
+} /* End of 'main' function */
+
+/* END OF 'loops.cpp' FILE */
@@ -0,0 +1,134 @@
+/*************************************************************
+ * Copyright (C) 2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : symbols.cpp
+ * PURPOSE     : Ray marching project.
+ *               Symbol lookup benchmark.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 02.04.2023
+ * NOTE        : Compares variable access by name through map
+ *               (as table keyed by name did) with interning and
+ *               access by symbol id, then compiles symbol heavy
+ *               scenes.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include "bench.h"
+
+using test::bench;
+
+/* Variable of table keyed by name structure */
+struct named
+{
+  parser::var_type Type; // Variable type
+  double Val;            // Value
+  std::string Text;      // Variable text, it was copied with value
+}; /* End of 'named' structure */
+
+/* Measure variable access function.
+ * ARGUMENTS:
+ *   - variables count:
+ *       int Count;
+ * RETURNS: None.
+ */
+static void Access(int Count)
+{
+  const int Reads = 1000000;
+  std::vector<std::string> names;
+  std::map<std::string, named> table;
+  std::vector<int> ids;
+  double sum = 0;
+
+  parser::symbols::Clear();
+  parser::variables::Clear();
+  for (int i = 0; i < Count; i++)
+  {
+    names.push_back(std::format("var_{}", i));
+    table[names.back()] = {parser::var_type::eFloat, (double)i, names.back()};
+    ids.push_back(parser::symbols::Intern(names.back()));
+    parser::variables::Set(ids.back(), parser::var_type::eFloat, i);
+  }
+
+  // Each read checks existence and takes value, as statements do
+  double
+    by_name = bench::Time([&]( void )
+      {
+        for (int i = 0; i < Reads; i++)
+        {
+          const std::string &n = names[(size_t)i * 7919 % Count];
+
+          if (table.find(n) != table.end())
+          {
+            named v = table[n];
+
+            sum += v.Val;
+          }
+        }
+      }),
+    intern = bench::Time([&]( void )
+      {
+        for (int i = 0; i < Reads; i++)
+          sum += parser::symbols::Find(names[(size_t)i * 7919 % Count]);
+      }),
+    by_id = bench::Time([&]( void )
+      {
+        for (int i = 0; i < Reads; i++)
+        {
+          int id = ids[(size_t)i * 7919 % Count];
+
+          if (parser::variables::IsExists(id))
+            sum += parser::variables::Get(id).Val;
+        }
+      });
+
+  std::cout << std::format("{:>6} variables: by name {:.1f} ns, intern {:.1f} ns (once per identifier), by id {:.1f} ns{}\n",
+    Count, by_name * 1e9 / Reads, intern * 1e9 / Reads, by_id * 1e9 / Reads, sum < 0 ? "!" : "");
+  parser::symbols::Clear();
+  parser::variables::Clear();
+} /* End of 'Access' function */
+
+/* Measure scene compilation function.
+ * ARGUMENTS:
+ *   - variables count:
+ *       int Vars;
+ *   - assignments in loop body, loop iterations:
+ *       int Body, Iters;
+ * RETURNS: None.
+ */
+static void Scene(int Vars, int Body, int Iters)
+{
+  std::string text;
+
+  for (int i = 0; i < Vars; i++)
+    text += std::format("double v{} = {};\n", i, i % 17);
+  text += std::format("for (int i = 0, i < {}, i = i + 1)\n{{\n", Iters);
+  for (int i = 0; i < Body; i++)
+    text += std::format("  v{0} = v{1} + v{2} * 0.5 - i;\n", i * 7 % Vars, i * 13 % Vars, i * 31 % Vars);
+  text += "}\nshape s = sphere(vec3(0, v1 * 0.001, 0), 1, MtlLib[0]);\nadd(s);\n";
+
+  std::filesystem::path scene = bench::Write("symbols", text);
+  parser::compile_context ctx;
+  double t = bench::Time([&]( void ) { bench::Compile(scene, ctx); }, 3, 0);
+
+  std::cout << std::format("{} variables, {} x {} assignments in loop: {:.1f} ms\n", Vars, Iters, Body, t * 1000);
+} /* End of 'Scene' function */
+
+/* The main program function.
+ * ARGUMENTS: None.
+ * RETURNS:
+ *   (int) Error level for operation system (0 for success).
+ */
+int main(void)
+{
+  for (int n : {100, 3000, 100000})
+    Access(n);
+  Scene(3000, 1000, 20);
+  Scene(30000, 10000, 20);
+  return 0;
+} /* End of 'main' function */
+
+/* END OF 'symbols.cpp' FILE */
@@ -0,0 +1,69 @@
+/*************************************************************
+ * Copyright (C) 2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : table.cpp
+ * PURPOSE     : Ray marching project.
+ *               Scene table backend benchmark.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 02.04.2023
+ * NOTE        : Compiles each bundled scene as shader text and as
+ *               scene table, prints compilation time, shader size
+ *               and table size. Table shader has to be the same for
+ *               all scenes, so switching them is buffer upload only.
+ *               GPU frame time of both backends is printed by
+ *               application.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include <set>
+
+#include "bench.h"
+
+using test::bench;
+
+/* The main program function.
+ * ARGUMENTS: None.
+ * RETURNS:
+ *   (int) Error level for operation system (0 for success).
+ */
+int main(void)
+{
+  std::set<std::string> shaders;
+  int tables = 0;
+
+  std::cout << std::format("{:<24} {:>9} {:>9} {:>9} {:>9} {:>9}  {}\n",
+    "scene", "text ms", "bytes", "table ms", "bytes", "table", "scene table");
+  for (auto &s : bench::Scenes())
+  {
+    parser::compile_context text, table;
+    std::string sh_text, sh_table, stat;
+    size_t size = 0;
+
+    table.IsTable = true;
+    double
+      t_text = bench::Time([&]( void ) { sh_text = bench::Compile(s, text); }, 3, 0),
+      t_table = bench::Time([&]( void )
+        {
+          sh_table = bench::Compile(s, table);
+          size = table.Head.size() * sizeof(int) + table.Vals.size() * sizeof(float);
+
+          size_t p = table.Report.find("scene table:");
+
+          stat = p == std::string::npos ? "" : table.Report.substr(p, table.Report.find('\n', p) - p);
+        }, 3, 0);
+
+    if (table.IsTableUsed)
+      tables++, shaders.insert(sh_table);
+    std::cout << std::format("{:<24} {:>9.1f} {:>9} {:>9.1f} {:>9} {:>9}  {}\n",
+      std::filesystem::relative(s, TRM_SOURCE_DIR).generic_string(), t_text * 1000, sh_text.size(),
+      t_table * 1000, sh_table.size(), size, sh_text.empty() ? "compilation error" : stat);
+  }
+  std::cout << std::format("{} scenes use table, {} distinct table shaders\n", tables, shaders.size());
+  return 0;
+} /* End of 'main' function */
+
+/* END OF 'table.cpp' FILE */
@@ -0,0 +1,148 @@
+/*************************************************************
+ * Copyright (C) 2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : check.h
+ * PURPOSE     : Ray marching project.
+ *               Scene compiler tests.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 02.04.2023
+ * NOTE        : Scenes are compiled from text to shader text,
+ *               tests check generated code.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#ifndef __check_h_
+#define __check_h_
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+
+#include "parser.h"
+
+namespace test
+{
+  /* Test checks class */
+  class check
+  {
+  private:
+    static inline int Failed = 0;  // Failed checks count
+    static inline int Total = 0;   // All checks count
+    static inline int Scenes = 0;  // Scenes compiled, output files are named by it
+    static inline std::string Log; // Report of last compiled scene
+
+  public:
+    /* Check condition function.
+     * ARGUMENTS:
+     *   - condition:
+     *       bool Cond;
+     *   - what is checked:
+     *       const std::string &What;
+     * RETURNS: (bool) condition.
+     */
+    static bool That(bool Cond, const std::string &What)
+    {
+      Total++;
+      if (!Cond)
+      {
+        Failed++;
+        std::cerr << "FAILED: " << What << std::endl;
+      }
+      return Cond;
+    } /* End of 'That' function */
+
+    /* Compile scene text function.
+     * ARGUMENTS:
+     *   - scene text:
+     *       const std::string &Scene;
+     *   - pass object arguments through 'ParamVal':
+     *       bool IsParams;
+     * RETURNS: (std::string) shader text.
+     */
+    static std::string Compile(const std::string &Scene, bool IsParams = false)
+    {
+      std::filesystem::path
+        dir = std::filesystem::temp_directory_path() / "trm_test",
+        name = dir / std::format("scene{}.scene", Scenes++);
+      std::map<std::string, trm::tex_data> tex;
+      parser::compile_context ctx;
+
+      ctx.IsParams = IsParams;
+      ctx.IsConvert = false;
+      std::filesystem::create_directories(dir);
+      std::ofstream(name, std::ios::binary) << Scene;
+      parser::Parse(name.string(), TRM_SOURCE_DIR "/bin/shaders/RT/myfrag.glsl",
+        std::filesystem::path(name).replace_extension(".glsl").string(), tex, ctx);
+      Log = std::move(ctx.Report);
+      return std::move(ctx.Shader);
+    } /* End of 'Compile' function */
+
+    /* Get report of last compiled scene function.
+     * ARGUMENTS: None.
+     * RETURNS: (const std::string &) report text.
+     */
+    static const std::string & Report(void)
+    {
+      return Log;
+    } /* End of 'Report' function */
+
+    /* Get function text of shader function.
+     * ARGUMENTS:
+     *   - shader text:
+     *       std::string_view Shader;
+     *   - function name:
+     *       std::string_view Name;
+     * RETURNS: (std::string_view) text from function header to its closing brace after 'return res;', empty if none.
+     */
+    static std::string_view Body(std::string_view Shader, std::string_view Name)
+    {
+      size_t
+        start = Shader.find("float " + std::string(Name) + "("),
+        end = start == std::string_view::npos ? start : Shader.find("return res;\n}\n", start);
+
+      if (end == std::string_view::npos)
+        return {};
+      return Shader.substr(start, end - start + 13);
+    } /* End of 'Body' function */
+
+    /* Count text occurrences function.
+     * ARGUMENTS:
+     *   - text to search in:
+     *       std::string_view Text;
+     *   - text to count:
+     *       std::string_view What;
+     * RETURNS: (int) number of occurrences.
+     */
+    static int Count(std::string_view Text, std::string_view What)
+    {
+      int res = 0;
+
+      for (size_t p = Text.find(What); p != std::string_view::npos; p = Text.find(What, p + What.size()))
+        res++;
+      return res;
+    } /* End of 'Count' function */
+
+    /* Get tests result function.
+     * ARGUMENTS:
+     *   - test name:
+     *       const char *Name;
+     * RETURNS: (int) exit code, 0 if all checks passed.
+     */
+    static int Result(const char *Name)
+    {
+      std::cout << Name << ": " << Total - Failed << " of " << Total << " checks passed" << std::endl;
+      return Failed == 0 ? 0 : 1;
+    } /* End of 'Result' function */
+  }; /* End of 'check' class */
+}
+
+#endif
+
+/* END OF 'check.h' FILE */
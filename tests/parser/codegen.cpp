@@ -0,0 +1,240 @@
+/*************************************************************
+ * Copyright (C) 2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : codegen.cpp
+ * PURPOSE     : Ray marching project.
+ *               Generated scene code tests.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 02.04.2023
+ * NOTE        : Checks dead code removal keeps one evaluation
+ *               of each shape in 'SceneSDF', scene material
+ *               selection, LOD bounds code, loops of objects
+ *               and frame uniforms read in them.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include "check.h"
+
+using test::check;
+
+/* Check shape evaluations count function.
+ * ARGUMENTS:
+ *   - test name:
+ *       const std::string &Name;
+ *   - scene text:
+ *       const std::string &Scene;
+ *   - primitive call text:
+ *       const std::string &Call;
+ *   - expected calls count:
+ *       int Expected;
+ * RETURNS: None.
+ */
+static void Evaluations(const std::string &Name, const std::string &Scene, const std::string &Call, int Expected)
+{
+  std::string sh = check::Compile(Scene);
+  std::string_view sdf = check::Body(sh, "SceneSDF");
+  int n = check::Count(sdf, Call);
+
+  if (!check::That(!sdf.empty(), Name + ": no 'SceneSDF' function") ||
+      !check::That(n == Expected, std::format("{}: {} '{}' calls in 'SceneSDF', expected {}", Name, n, Call, Expected)))
+    std::cerr << sdf << std::endl;
+} /* End of 'Evaluations' function */
+
+/* The main program function.
+ * ARGUMENTS: None.
+ * RETURNS:
+ *   (int) Error level for operation system (0 for success).
+ */
+int main(void)
+{
+  try
+  {
+    Evaluations("box modified after other shape",
+      "shape s = sphere(vec3(0, 1, 0), 1, MtlLib[0]);\n"
+      "add(s);\n"
+      "shape b = box(vec3(3, 1, 0), vec3(1), MtlLib[1]);\n"
+      "b = rotate(30, vec3(0, 1, 0));\n"
+      "b = translate(vec3(0, 2, 0));\n"
+      "add(b);\n",
+      "SDFBox(", 1);
+    Evaluations("box with three modifiers",
+      "shape b = box(vec3(0, 1, 0), vec3(1), MtlLib[1]);\n"
+      "b = rotate(30, vec3(0, 1, 0));\n"
+      "b = translate(vec3(0, 2, 0));\n"
+      "b = scale(vec3(2, 1, 1));\n"
+      "add(b);\n",
+      "SDFBox(", 1);
+    Evaluations("shapes added together",
+      "shape s = sphere(vec3(0, 1, 0), 1, MtlLib[0]);\n"
+      "shape b = box(vec3(3, 0, 0), vec3(1), MtlLib[2]);\n"
+      "b = rotate(30, vec3(0, 1, 0));\n"
+      "b = translate(vec3(0, 2, 0));\n"
+      "add(s, b);\n",
+      "SDFBox(", 1);
+    Evaluations("function shape modified twice",
+      "func leg(vec3 p, double r)\n"
+      "{\n"
+      "  shape l = capsule(p, p - vec3(0, 2, 0), r, MtlLib[3]);\n"
+      "  return l;\n"
+      "}\n"
+      "shape s = sphere(vec3(0, 1, 0), 1, MtlLib[0]);\n"
+      "add(s);\n"
+      "shape l1 = leg(vec3(3, 0, 0), 0.5);\n"
+      "l1 = rotate(30, vec3(0, 1, 0));\n"
+      "l1 = translate(vec3(0, 2, 0));\n"
+      "add(l1);\n",
+      "SDFUser_leg(mod_l1, mtl_l1", 1);
+    Evaluations("shapes of two add statements",
+      "shape s = sphere(vec3(0, 1, 0), 1, MtlLib[0]);\n"
+      "add(s);\n"
+      "shape b = box(vec3(3, 1, 0), vec3(1), MtlLib[1]);\n"
+      "add(b);\n",
+      "switch (res_id)", 1);
+    Evaluations("added primitive material is taken by index",
+      "shape s = sphere(vec3(0, 1, 0), 1, MtlLib[0]);\n"
+      "shape b = box(vec3(3, 1, 0), vec3(1), MtlLib[1]);\n"
+      "add(s, b);\n",
+      "mtl_s = ", 0);
+    Evaluations("shape assigned again after add",
+      "shape s = sphere(vec3(0, 1, 0), 1, MtlLib[0]);\n"
+      "shape b = box(vec3(3, 1, 0), vec3(1), MtlLib[1]);\n"
+      "add(s, b);\n"
+      "b = sphere(vec3(-3, 1, 0), 1, MtlLib[2]);\n"
+      "add(b);\n",
+      "if (res_id == 0)", 1);
+    Evaluations("n-ary smooth union",
+      "shape a = sphere(vec3(0, 1, 0), 1, MtlLib[0]);\n"
+      "shape b = box(vec3(2, 1, 0), vec3(1), MtlLib[1]);\n"
+      "shape c = sphere(vec3(-2, 1, 0), 1, MtlLib[2]);\n"
+      "shape u = smth_union(a, b, c, 1);\n"
+      "add(u);\n",
+      "SDFSurfaceSmoothUnion(", 2);
+    Evaluations("loop reading value known per frame: value is read once",
+      "shape g = box(vec3(0, -1, 0), vec3(10, 1, 10), MtlLib[1]);\n"
+      "add(g);\n"
+      "for (int i = 0, i < 6, i = i + 1)\n"
+      "{\n"
+      "  shape s = sphere(vec3(i * 2, 1 + sin(Time), 0), 0.5, MtlLib[0]);\n"
+      "  add(s);\n"
+      "}\n",
+      "FrameVal[0].x", 1);
+    Evaluations("loop reading value known per frame: loop is emitted",
+      "shape g = box(vec3(0, -1, 0), vec3(10, 1, 10), MtlLib[1]);\n"
+      "add(g);\n"
+      "for (int i = 0, i < 6, i = i + 1)\n"
+      "{\n"
+      "  shape s = sphere(vec3(i * 2, 1 + sin(Time), 0), 0.5, MtlLib[0]);\n"
+      "  add(s);\n"
+      "}\n",
+      "// loop of objects", 1);
+    Evaluations("loop reading per frame value of iteration: loop is emitted",
+      "shape g = box(vec3(0, -1, 0), vec3(10, 1, 10), MtlLib[1]);\n"
+      "add(g);\n"
+      "for (int i = 0, i < 6, i = i + 1)\n"
+      "{\n"
+      "  shape s = sphere(vec3(i * 2, 1 + sin(Time + i), 0), 0.5, MtlLib[0]);\n"
+      "  add(s);\n"
+      "}\n",
+      "// loop of objects", 1);
+
+    Evaluations("ring of rotated boxes: loop is emitted from syntax tree",
+      "shape g = box(vec3(0, -1, 0), vec3(10, 1, 10), MtlLib[1]);\n"
+      "add(g);\n"
+      "shape b = box(vec3(10, 1, 0), vec3(0.5, 1, 0.5), MtlLib[2]);\n"
+      "for (int i = 0, i < 64, i = i + 1)\n"
+      "{\n"
+      "  b = box(vec3(10, 1, 0), vec3(0.5, 1, 0.5), MtlLib[2]);\n"
+      "  b = rotate(5.625, vec3(0, 1, 0));\n"
+      "  add(b);\n"
+      "}\n",
+      "SDFBox(", 2);
+    Evaluations("ring of rotated boxes: rotations accumulate in loop",
+      "shape g = box(vec3(0, -1, 0), vec3(10, 1, 10), MtlLib[1]);\n"
+      "add(g);\n"
+      "shape b = box(vec3(10, 1, 0), vec3(0.5, 1, 0.5), MtlLib[2]);\n"
+      "for (int i = 0, i < 64, i = i + 1)\n"
+      "{\n"
+      "  b = box(vec3(10, 1, 0), vec3(0.5, 1, 0.5), MtlLib[2]);\n"
+      "  b = rotate(5.625, vec3(0, 1, 0));\n"
+      "  add(b);\n"
+      "}\n",
+      "mod_b = Rotate(5.625, vec3(0.0, 1.0, 0.0), mod_b);", 1);
+    Evaluations("shape modified after loop: last iteration is evaluated",
+      "shape g = box(vec3(0, -1, 0), vec3(10, 1, 10), MtlLib[1]);\n"
+      "add(g);\n"
+      "for (int i = 0, i < 6, i = i + 1)\n"
+      "{\n"
+      "  shape s = sphere(vec3(i * 2, 1, 0), 0.5, MtlLib[0]);\n"
+      "  add(s);\n"
+      "}\n"
+      "s = translate(vec3(0, 2, 0));\n"
+      "add(s);\n",
+      "sphere(vec3(10.0, 1.0, 0.0), 0.5)", 1);
+
+    // Condition in body makes iterations differ, so the loop is taken from iterations text
+    std::string named = check::Compile(
+      "double loop0 = 2;\n"
+      "shape g = box(vec3(0, -1, 0), vec3(10, 1, 10), MtlLib[1]);\n"
+      "add(g);\n"
+      "for (int i = 0, i < 6, i = i + 1)\n"
+      "{\n"
+      "  loop0 = i * 2;\n"
+      "  if (i > 6)\n"
+      "    loop0 = 0;\n"
+      "  shape s = sphere(vec3(loop0, 1, 0), 0.5, MtlLib[0]);\n"
+      "  add(s);\n"
+      "}\n");
+
+    check::That(check::Count(named, "float loop0[]") == 0 && check::Count(named, "float _loop0[]") > 0 &&
+      check::Count(check::Body(named, "SceneSDF"), "// loop of objects") == 1,
+      "loop array name: scene variable 'loop0' is declared again by loop");
+
+    std::string many;
+
+    for (int i = 0; i < 500; i++)
+      many += std::format("shape s{0} = sphere(vec3({0}, 1, 0), 0.5, MtlLib[{1}]);\nadd(s{0});\n", i, i % 4);
+    check::Compile(many, true);
+    check::That(check::Report().find("values don't fit into") != std::string::npos,
+      "parameters: 'ParamVal' overflow isn't reported");
+    // More parameters than 'FrameVal' takes, they don't share it with 'Time' values
+    std::string some = check::Compile(many.substr(0, many.find("shape s40 ")), true);
+
+    check::That(check::Report().find("values don't fit into") == std::string::npos &&
+      check::Count(some, "FrameVal[") == 1 && check::Count(some, std::format("ParamVal[{}]", parser::uniforms::MaxCount / 4)) > 0,
+      "parameters: 40 shapes don't fit into 'ParamVal'");
+
+    std::string loop = check::Compile(
+      "shape g = box(vec3(0, -1, 0), vec3(10, 1, 10), MtlLib[1]);\n"
+      "add(g);\n"
+      "for (int i = 0, i < 6, i = i + 1)\n"
+      "{\n"
+      "  shape s = sphere(vec3(i * 2, 1 + sin(Time), 0), 0.5, MtlLib[0]);\n"
+      "  add(s);\n"
+      "}\n", true);
+
+    check::That(check::Count(check::Body(loop, "SceneSDF"), "// loop of objects") == 1,
+      "parameters: loop reading value known per frame is unrolled");
+
+    std::string sh = check::Compile(
+      "shape s = sphere(vec3(0, 1, 0), 1, MtlLib[0]);\n"
+      "shape b = box(vec3(3, 1, 0), vec3(1), MtlLib[1]);\n"
+      "add(s, b);\n");
+    std::string_view dist = check::Body(sh, "SceneDist");
+    int lods = check::Count(dist, "SceneLod +=");
+
+    check::That(lods == 2, std::format("LOD bounds: {} 'SceneLod' counts in 'SceneDist', expected 2", lods));
+    check::That(check::Count(dist, "SceneLod += int(IsLodDebug && ") == lods,
+      "LOD bounds: hits are counted without debug view");
+  }
+  catch (std::exception &E)
+  {
+    check::That(false, std::string("exception: ") + E.what());
+  }
+  return check::Result("codegen");
+} /* End of 'main' function */
+
+/* END OF 'codegen.cpp' FILE */
@@ -0,0 +1,163 @@
+/*************************************************************
+ * Copyright (C) 2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : pack.cpp
+ * PURPOSE     : Ray marching project.
+ *               Precompiled scene key tests.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 02.04.2023
+ * NOTE        : Checks every file pasted to shader changes key
+ *               of precompiled scene, saved scene is read back
+ *               the same and damaged or foreign files are rejected.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include <algorithm>
+
+#include "check.h"
+
+using test::check;
+
+/* Copy file with appended text function.
+ * ARGUMENTS:
+ *   - source and destination file names:
+ *       const std::filesystem::path &From, &To;
+ *   - text to append:
+ *       const std::string &Tail;
+ * RETURNS: None.
+ */
+static void Copy(const std::filesystem::path &From, const std::filesystem::path &To, const std::string &Tail)
+{
+  std::ofstream(To, std::ios::binary) << parser::file::ReadFile(From.string()) << Tail;
+} /* End of 'Copy' function */
+
+/* Change byte of file function.
+ * ARGUMENTS:
+ *   - file name:
+ *       const std::filesystem::path &Name;
+ *   - byte offset:
+ *       size_t Offset;
+ * RETURNS: None.
+ */
+static void Flip(const std::filesystem::path &Name, size_t Offset)
+{
+  std::string buf = parser::file::ReadFile(Name.string());
+
+  buf[Offset] ^= 0x20;
+  std::ofstream(Name, std::ios::binary) << buf;
+} /* End of 'Flip' function */
+
+/* The main program function.
+ * ARGUMENTS: None.
+ * RETURNS:
+ *   (int) Error level for operation system (0 for success).
+ */
+int main(void)
+{
+  try
+  {
+    std::filesystem::path
+      src = TRM_SOURCE_DIR "/bin/shaders/RT",
+      dir = std::filesystem::temp_directory_path() / "trm_test" / "pack",
+      scene = dir / "a.scene",
+      tmpl = dir / "myfrag.glsl";
+
+    std::filesystem::create_directories(dir);
+    std::ofstream(scene, std::ios::binary) << "shape s = sphere(vec3(0, 1, 0), 1, MtlLib[0]);\nadd(s);\n";
+    Copy(src / "myfrag.glsl", tmpl, "");
+    Copy(src / "table.glsl", dir / "table.glsl", "");
+
+    parser::compile_context ctx;
+    uint64_t key = parser::pack::Source(scene.string(), tmpl.string(), ctx);
+
+    check::That(parser::pack::Source(scene.string(), tmpl.string(), ctx) == key, "key of same sources changed");
+    Copy(src / "table.glsl", dir / "table.glsl", "\n// changed\n");
+    check::That(parser::pack::Source(scene.string(), tmpl.string(), ctx) != key, "key doesn't depend on 'table.glsl'");
+    Copy(src / "table.glsl", dir / "table.glsl", "");
+    Copy(src / "myfrag.glsl", tmpl, "\n// changed\n");
+    check::That(parser::pack::Source(scene.string(), tmpl.string(), ctx) != key, "key doesn't depend on template");
+    Copy(src / "myfrag.glsl", tmpl, "");
+    check::That(parser::pack::Source(scene.string(), tmpl.string(), ctx) == key, "key of restored sources changed");
+    ctx.IsTable = true;
+    check::That(parser::pack::Source(scene.string(), tmpl.string(), ctx) != key, "key doesn't depend on table switch");
+
+    // Scene with frame program is saved and opened again
+    std::filesystem::path bin = dir / "a.bin";
+    std::map<std::string, trm::tex_data> tex {{"bin/textures/a.g32", {3, nullptr}}, {"bin/textures/b.g32", {5, nullptr}}};
+    parser::compile_context comp;
+    const int head[] {1, 2, 3, -1};
+    const float vals[] {0.5f, 30};
+
+    std::ofstream(scene, std::ios::binary) << "shape s = sphere(vec3(0, 1 + sin(Time), 0), 1, MtlLib[0]);\nadd(s);\n";
+    comp.IsConvert = false;
+    parser::Parse(scene.string(), tmpl.string(), (dir / "a.glsl").string(), tex, comp);
+    key = parser::pack::Source(scene.string(), tmpl.string(), comp);
+
+    const std::string &shader = comp.Shader, &state = comp.Key, &report = comp.Report;
+
+    if (!check::That(comp.Frame.has_value(), "scene reading 'Time' has no frame program") ||
+        !check::That(parser::pack::Save(bin.string(), key, {shader, state, report, &tex, true, head, vals, &*comp.Frame}),
+          "scene isn't saved"))
+      return check::Result("pack");
+
+    std::shared_ptr<parser::pack> pk = parser::pack::Open(bin.string(), key);
+
+    if (!check::That(pk != nullptr, "saved scene isn't opened"))
+      return check::Result("pack");
+    check::That(pk->GetShader() == shader && pk->GetKey() == state && pk->GetReport() == report,
+      "saved shader, key or report differs");
+    check::That(pk->IsTable() && std::ranges::equal(pk->GetHead(), head) && std::ranges::equal(pk->GetVals(), vals),
+      "saved scene table differs");
+
+    std::map<std::string, trm::tex_data> got = pk->GetTextures({});
+
+    check::That(got.size() == tex.size() && std::ranges::all_of(tex, [&got]( auto &T )
+      {
+        auto it = got.find(T.first);
+
+        return it != got.end() && it->second.n == T.second.n;
+      }), "saved textures differ");
+
+    std::optional<parser::program> frame = pk->GetFrame();
+
+    if (check::That(frame.has_value(), "saved frame program is lost"))
+    {
+      parser::vm a(std::move(*frame)), b(parser::program(*comp.Frame));
+
+      check::That(a.Frame(1.5) == b.Frame(1.5), "saved frame program computes other values");
+    }
+    pk.reset();
+
+    // Frame program referring to syntax tree isn't saved
+    parser::program tree;
+
+    tree.Exprs.push_back(nullptr);
+    check::That(!parser::pack::Save((dir / "b.bin").string(), key, {shader, state, report, nullptr, false, {}, {}, &tree}),
+      "frame program referring to syntax tree is saved");
+
+    // Damaged payload and other format or sources are rejected
+    std::string saved = parser::file::ReadFile(bin.string());
+
+    check::That(parser::pack::Open(bin.string(), key + 1) == nullptr, "scene of other sources is opened");
+    Flip(bin, saved.size() - shader.size() / 2);
+    check::That(parser::pack::Open(bin.string(), key) == nullptr, "scene with changed byte passes checksum");
+    std::ofstream(bin, std::ios::binary) << saved;
+    check::That(parser::pack::Open(bin.string(), key) != nullptr, "restored scene isn't opened");
+    Flip(bin, sizeof(uint32_t));
+    check::That(parser::pack::Open(bin.string(), key) == nullptr, "scene of other format version is opened");
+    std::ofstream(bin, std::ios::binary) << saved;
+    Flip(bin, 0);
+    check::That(parser::pack::Open(bin.string(), key) == nullptr, "file of other type is opened");
+  }
+  catch (std::exception &E)
+  {
+    check::That(false, std::string("exception: ") + E.what());
+  }
+  return check::Result("pack");
+} /* End of 'main' function */
+
+/* END OF 'pack.cpp' FILE */
@@ -0,0 +1,142 @@
+/*************************************************************
+ * Copyright (C) 2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : stress.cpp
+ * PURPOSE     : Ray marching project.
+ *               Concurrent compilation tests.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 02.04.2023
+ * NOTE        : Compiles 'bin/scenes' and 'tests/scenes' by several
+ *               threads at once in all modes and checks results are
+ *               the same as serial ones.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include <algorithm>
+#include <thread>
+
+#include "check.h"
+
+using test::check;
+namespace fs = std::filesystem;
+
+/* Compilation result structure */
+struct result
+{
+  std::string Shader, Report, Error; // Shader text, parser report and exception text
+  std::vector<int> Head;             // Scene table program
+  std::vector<float> Vals, Frame;    // Scene table constants and frame uniforms values
+
+  bool operator==(const result &R) const = default;
+}; /* End of 'result' structure */
+
+/* Compile scene function.
+ * ARGUMENTS:
+ *   - scene file name:
+ *       const fs::path &Scene;
+ *   - compilation switches:
+ *       const parser::compile_context &Mode;
+ *   - output shader file name:
+ *       const fs::path &Out;
+ * RETURNS: (result) compiled scene.
+ */
+static result Compile(const fs::path &Scene, const parser::compile_context &Mode, const fs::path &Out)
+{
+  parser::compile_context ctx = Mode;
+  std::map<std::string, trm::tex_data> tex;
+  result res;
+
+  try
+  {
+    parser::Parse(Scene.string(), TRM_SOURCE_DIR "/bin/shaders/RT/myfrag.glsl", Out.string(), tex, ctx);
+    res.Shader = ctx.Shader;
+    res.Report = ctx.Report;
+    res.Head = ctx.Head;
+    res.Vals = ctx.Vals;
+    if (ctx.Frame.has_value())
+      res.Frame = parser::vm(std::move(*ctx.Frame)).Frame(1.5);
+  }
+  catch (std::exception &E)
+  {
+    res.Error = E.what();
+  }
+  return res;
+} /* End of 'Compile' function */
+
+/* The main program function.
+ * ARGUMENTS: None.
+ * RETURNS:
+ *   (int) Error level for operation system (0 for success).
+ */
+int main(void)
+{
+  const int Threads = 4, Rounds = 2;
+  std::vector<fs::path> scenes;
+  fs::path dir = fs::temp_directory_path() / "trm_test" / "stress";
+
+  for (const char *d : {TRM_SOURCE_DIR "/bin/scenes", TRM_SOURCE_DIR "/tests/scenes"})
+    for (auto &e : fs::directory_iterator(d))
+      if (e.path().extension() == ".scene")
+        scenes.push_back(e.path());
+  std::sort(scenes.begin(), scenes.end());
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+
+  std::vector<parser::compile_context> modes(4);
+
+  for (int m = 0; m < 4; m++)
+  {
+    modes[m].IsTable = (m & 1) != 0;
+    modes[m].IsParams = (m & 2) != 0;
+    modes[m].IsConvert = false;
+  }
+
+  // Expected results, each shader goes to own file so none is skipped
+  std::vector<result> serial;
+
+  for (size_t m = 0; m < modes.size(); m++)
+    for (size_t s = 0; s < scenes.size(); s++)
+      serial.push_back(Compile(scenes[s], modes[m], dir / std::format("serial_{}_{}.glsl", m, s)));
+
+  // Each thread compiles all jobs starting from own place, so different scenes and modes overlap
+  size_t jobs = serial.size();
+  std::vector<std::vector<result>> parallel(Threads, std::vector<result>(jobs * Rounds));
+  std::vector<std::thread> th;
+
+  for (int t = 0; t < Threads; t++)
+    th.emplace_back([&, t]( void )
+      {
+        for (size_t i = 0; i < jobs * Rounds; i++)
+        {
+          size_t j = (i + t * jobs / Threads) % jobs;
+
+          parallel[t][i] = Compile(scenes[j % scenes.size()], modes[j / scenes.size()],
+            dir / std::format("parallel_{}_{}.glsl", t, i));
+        }
+      });
+  for (auto &t : th)
+    t.join();
+
+  int ok = 0;
+
+  for (auto &r : serial)
+    ok += r.Error.empty();
+  check::That(ok > 0, "no scene compiled");
+  for (int t = 0; t < Threads; t++)
+    for (size_t i = 0; i < jobs * Rounds; i++)
+    {
+      size_t j = (i + t * jobs / Threads) % jobs;
+
+      check::That(parallel[t][i] == serial[j], std::format("thread {}: '{}' in mode {} differs from serial result",
+        t, scenes[j % scenes.size()].filename().string(), j / scenes.size()));
+    }
+  std::cout << std::format("{} scenes x {} modes ({} compiled) by {} threads x {} rounds\n",
+    scenes.size(), modes.size(), ok, Threads, Rounds);
+  return check::Result("stress");
+} /* End of 'main' function */
+
+/* END OF 'stress.cpp' FILE */
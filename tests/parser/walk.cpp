@@ -0,0 +1,180 @@
+/*************************************************************
+ * Copyright (C) 2023
+ *    Computer Graphics Support Group of 30 Phys-Math Lyceum
+ *************************************************************/
+
+/* FILE NAME   : walk.cpp
+ * PURPOSE     : Ray marching project.
+ *               Bytecode VM tests.
+ * PROGRAMMER  : Vladislav Biserov.
+ * LAST UPDATE : 02.04.2023
+ * NOTE        : Built twice: with 'TRM_PARSER_TREE_WALK' it writes
+ *               reference results of 'bin/scenes' and 'tests/scenes'
+ *               in all modes, without it checks VM results are the
+ *               same.
+ *
+ * No part of this file may be changed without agreement of
+ * Computer Graphics Support Group of 30 Phys-Math Lyceum
+ */
+
+#include <algorithm>
+#include <sstream>
+
+#include "check.h"
+
+using test::check;
+namespace fs = std::filesystem;
+
+/* Compile scene to text function.
+ * ARGUMENTS:
+ *   - scene file name:
+ *       const fs::path &Scene;
+ *   - compilation switches:
+ *       const parser::compile_context &Mode;
+ *   - output shader file name:
+ *       const fs::path &Out;
+ * RETURNS: (std::string) shader, report, scene table and frame uniforms text.
+ */
+static std::string Dump(const fs::path &Scene, const parser::compile_context &Mode, const fs::path &Out)
+{
+  parser::compile_context ctx = Mode;
+  std::map<std::string, trm::tex_data> tex;
+  std::string res;
+
+  try
+  {
+    parser::Parse(Scene.string(), TRM_SOURCE_DIR "/bin/shaders/RT/myfrag.glsl", Out.string(), tex, ctx);
+    res = ctx.Shader + "\n// report\n" + ctx.Report;
+    if (ctx.IsTableUsed)
+    {
+      res += "\n// table\n";
+      for (int x : ctx.Head)
+        res += std::format("{} ", x);
+      res += '\n';
+      for (float x : ctx.Vals)
+        res += std::format("{} ", x);
+      res += '\n';
+    }
+    if (ctx.Frame.has_value())
+    {
+      parser::vm frame(std::move(*ctx.Frame));
+
+      res += "\n// frame\n";
+      for (double t : {0.0, 1.5})
+      {
+        for (float x : frame.Frame(t))
+          res += std::format("{} ", x);
+        res += '\n';
+      }
+    }
+  }
+  catch (std::exception &E)
+  {
+    res = std::string("// error\n") + E.what() + "\n";
+  }
+  return res;
+} /* End of 'Dump' function */
+
+#ifndef TRM_PARSER_TREE_WALK
+/* Find first differing line function.
+ * ARGUMENTS:
+ *   - expected and actual text:
+ *       const std::string &Expected, &Actual;
+ * RETURNS: (std::string) line number and both lines.
+ */
+static std::string Diff(const std::string &Expected, const std::string &Actual)
+{
+  std::istringstream e(Expected), a(Actual);
+  std::string le, la;
+
+  for (int n = 1; ; n++)
+  {
+    bool
+      is_e = (bool)std::getline(e, le),
+      is_a = (bool)std::getline(a, la);
+
+    if (!is_e && !is_a)
+      return "same";
+    if (is_e != is_a || le != la)
+      return std::format("line {}:\n  tree walker: {}\n  VM:          {}", n, is_e ? le : "<end>", is_a ? la : "<end>");
+  }
+} /* End of 'Diff' function */
+#endif
+
+/* The main program function.
+ * ARGUMENTS:
+ *   - command line arguments count:
+ *       int ArgC;
+ *   - command line arguments (reference results directory):
+ *       char *ArgV[];
+ * RETURNS:
+ *   (int) Error level for operation system (0 for success).
+ */
+int main(int ArgC, char *ArgV[])
+{
+  if (ArgC < 2)
+  {
+    std::cerr << "usage: " << ArgV[0] << " <reference directory>\n";
+    return 1;
+  }
+
+  fs::path dir = ArgV[1];
+  std::vector<fs::path> scenes;
+
+  for (const char *d : {TRM_SOURCE_DIR "/bin/scenes", TRM_SOURCE_DIR "/tests/scenes"})
+    for (auto &e : fs::directory_iterator(d))
+      if (e.path().extension() == ".scene")
+        scenes.push_back(e.path());
+  std::sort(scenes.begin(), scenes.end());
+
+  // Shaders written before would be skipped as unchanged
+#ifdef TRM_PARSER_TREE_WALK
+  fs::path out = dir / "walk";
+
+  fs::remove_all(dir);
+#else
+  fs::path out = dir / "vm";
+
+  fs::remove_all(out);
+#endif
+  fs::create_directories(out);
+
+  int cnt = 0;
+
+  for (int m = 0; m < 4; m++)
+  {
+    parser::compile_context mode;
+
+    mode.IsTable = (m & 1) != 0;
+    mode.IsParams = (m & 2) != 0;
+    mode.IsConvert = false;
+    for (auto &s : scenes)
+    {
+      std::string
+        name = std::format("{}_{}", m, fs::relative(s, TRM_SOURCE_DIR).generic_string()),
+        res;
+
+      std::replace(name.begin(), name.end(), '/', '_');
+      res = Dump(s, mode, out / (name + ".glsl"));
+      cnt += !res.starts_with("// error");
+#ifdef TRM_PARSER_TREE_WALK
+      std::ofstream(dir / (name + ".txt"), std::ios::binary) << res;
+#else
+      std::ifstream f(dir / (name + ".txt"), std::ios::binary);
+      std::string ref((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+
+      check::That(f.is_open(), std::format("'{}': no reference result", name));
+      check::That(!f.is_open() || ref == res, std::format("'{}' differs from tree walker, {}", name, Diff(ref, res)));
+#endif
+    }
+  }
+  check::That(cnt > 0, "no scene compiled");
+#ifdef TRM_PARSER_TREE_WALK
+  std::cout << std::format("{} scenes x 4 modes ({} compiled) written to '{}'\n", scenes.size(), cnt, dir.string());
+  return check::Result("walk reference");
+#else
+  return check::Result("walk");
+#endif
+} /* End of 'main' function */
+
+/* END OF 'walk.cpp' FILE */